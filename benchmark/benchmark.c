@@ -0,0 +1,864 @@
+/************************************************************************************//**
+* \file         benchmark.c
+* \brief        Source file of the benchmark application.
+*
+*----------------------------------------------------------------------------------------
+*                          C O P Y R I G H T
+*----------------------------------------------------------------------------------------
+*           Copyright (c) 2022 by PragmaticLinux     All rights reserved
+*
+*----------------------------------------------------------------------------------------
+*                            L I C E N S E
+*----------------------------------------------------------------------------------------
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files (the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+* CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>                         /* for standard integer types              */
+#include <stdbool.h>                        /* for boolean type                        */
+#include <stdio.h>                          /* for standard I/O functions.             */
+#include <stdlib.h>                         /* for standard library                    */
+#include <string.h>                         /* for string library                      */
+#include <inttypes.h>                       /* for format specifiers of integer types  */
+#include <time.h>                           /* clock functions                         */
+#include <poll.h>                           /* waiting for file descriptor events      */
+#include <pthread.h>                        /* POSIX threads                           */
+#include <stdatomic.h>                      /* Atomic operations                       */
+#include <sys/resource.h>                   /* Resource usage                          */
+#include <cancomm.h>                        /* SocketCAN communication library         */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Mode that receives with cancomm_receive() in a polling loop and transmits
+ *         with cancomm_transmit().
+ */
+#define BENCH_MODE_SINGLE              (0U)
+
+/** \brief Mode that waits with poll() and then receives with cancomm_receive_batch().
+ *         Transmits with cancomm_transmit_batch().
+ */
+#define BENCH_MODE_BATCHED             (1U)
+
+/** \brief Mode that receives with cancomm_receive_timeout(), which sleeps in the kernel
+ *         until a frame arrives. Transmits with cancomm_transmit_batch().
+ */
+#define BENCH_MODE_BLOCKING            (2U)
+
+/** \brief Mode that receives from the ring buffer of the background reader, with
+ *         cancomm_reader_pop_batch(). Transmits with cancomm_transmit_batch().
+ */
+#define BENCH_MODE_RING                (3U)
+
+/** \brief Total number of modes. */
+#define BENCH_MODE_CNT                 (4U)
+
+/** \brief Maximum number of frames to transmit or receive at once. */
+#define BENCH_BATCH_SIZE               (32U)
+
+/** \brief Capacity of the ring buffer of the background reader. */
+#define BENCH_RING_CAPACITY            (65536U)
+
+/** \brief Time in microseconds after which a receiver considers the bus idle. */
+#define BENCH_IDLE_TIMEOUT_US          (100000U)
+
+/** \brief Default duration of a throughput test in milliseconds. */
+#define BENCH_DURATION_MS_DEFAULT      (2000U)
+
+/** \brief Default number of round trips of a latency test. */
+#define BENCH_SAMPLES_DEFAULT          (10000U)
+
+/** \brief Number of round trips before a latency test starts measuring. Gets the
+ *         caches and the scheduler of the system up to speed.
+ */
+#define BENCH_WARMUP_SAMPLES           (100U)
+
+/** \brief CAN identifier of the frames that the benchmark transmits. */
+#define BENCH_PING_ID                  (0x100U)
+
+/** \brief CAN identifier of the frames that the echo thread transmits. */
+#define BENCH_PONG_ID                  (0x101U)
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Structure with the results of a throughput test. */
+typedef struct
+{
+  /** \brief Number of frames that were submitted for transmission. */
+  uint64_t sent;
+  /** \brief Number of frames that were received. */
+  uint64_t received;
+  /** \brief Number of frames that the kernel dropped at the receiver. */
+  uint64_t overflows;
+  /** \brief Received frames per second. */
+  double   frames_per_s;
+  /** \brief CPU time of the process in nanoseconds per received frame. */
+  double   cpu_ns_per_frame;
+} tBenchThroughput;
+
+/** \brief Structure with the results of a latency test. */
+typedef struct
+{
+  /** \brief Number of round trips that were measured. */
+  uint32_t samples;
+  /** \brief Number of round trips without a response. */
+  uint32_t lost;
+  /** \brief Median round trip time in microseconds. */
+  double   p50_us;
+  /** \brief 99th percentile of the round trip time in microseconds. */
+  double   p99_us;
+  /** \brief 99.9th percentile of the round trip time in microseconds. */
+  double   p999_us;
+  /** \brief CPU time of the process in nanoseconds per round trip. */
+  double   cpu_ns_per_frame;
+} tBenchLatency;
+
+/** \brief Structure with the state shared with a receiver or echo thread. */
+typedef struct
+{
+  /** \brief CAN communication context of the thread. */
+  cancomm_t  ctx;
+  /** \brief Benchmark mode, such as BENCH_MODE_BATCHED. */
+  uint32_t   mode;
+  /** \brief Request for the thread to stop, once the bus is idle. */
+  atomic_bool stop;
+  /** \brief Number of frames that the thread received. */
+  uint64_t   received;
+  /** \brief Time (CLOCK_MONOTONIC nanoseconds) of the last reception. */
+  uint64_t   last_time;
+} tBenchThread;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static uint64_t BenchTimeNs(void);
+static uint64_t BenchCpuNs(void);
+static cancomm_t BenchConnect(char const * device, uint32_t mode);
+static void     BenchDisconnect(cancomm_t ctx);
+static size_t   BenchReceive(cancomm_t ctx, uint32_t mode, cancomm_frame_t * frames,
+                             size_t max, uint32_t timeout_us);
+static size_t   BenchTransmit(cancomm_t ctx, uint32_t mode, cancomm_frame_t * frames,
+                              size_t count);
+static void   * BenchReceiverThread(void * arg);
+static void   * BenchEchoThread(void * arg);
+static bool     BenchThroughput(char const * txDevice, char const * rxDevice,
+                                uint32_t mode, bool fd, uint32_t durationMs,
+                                tBenchThroughput * result);
+static bool     BenchLatency(char const * device, char const * echoDevice, uint32_t mode,
+                             uint32_t samples, tBenchLatency * result);
+static int      BenchCompare(void const * a, void const * b);
+
+
+/****************************************************************************************
+* Local constant declarations
+****************************************************************************************/
+/** \brief Names of the benchmark modes, indexed by mode. */
+static char const * const benchModeNames[BENCH_MODE_CNT] =
+{
+  "single", "batched", "blocking", "ring"
+};
+
+
+/************************************************************************************//**
+** \brief     This benchmark program measures the performance of the library over
+**            SocketCAN devices, typically virtual ones (vcan). For each mode, it
+**            measures the maximum sustained throughput for CAN classic and CAN FD
+**            frames and the round trip latency of a receive and transmit echo path,
+**            together with the CPU time per frame.
+**
+**            Usage: cancomm_benchmark [--json] [--duration-ms N] [--samples N]
+**                                     [device [echo_device]]
+**
+**            The device defaults to vcan0. The echo device defaults to the device. A
+**            single vcan device suffices, because it passes each frame to all the
+**            other sockets on it. The CAN FD tests need a device with an MTU of 72,
+**            for example after "ip link set vcan0 mtu 72".
+** \param     argc Number of program arguments.
+** \param     argv Array with program arguments.
+** \return    Program exit code. EXIT_SUCCESS for success, EXIT_FAILURE otherwise.
+**
+****************************************************************************************/
+int main(int argc, char const * const argv[])
+{
+  int              result = EXIT_SUCCESS;
+  char const *     device = "vcan0";
+  char const *     echoDevice = NULL;
+  bool             json = false;
+  uint32_t         durationMs = BENCH_DURATION_MS_DEFAULT;
+  uint32_t         samples = BENCH_SAMPLES_DEFAULT;
+  uint32_t         positional = 0;
+  bool             fdSupported = false;
+  cancomm_t        probeCtx;
+  cancomm_link_config_t linkConfig;
+  tBenchThroughput throughput;
+  tBenchLatency    latency;
+  bool             first = true;
+  bool             started = false;
+
+  /* Process the program arguments. */
+  for (int idx = 1; idx < argc; idx++)
+  {
+    if (strcmp(argv[idx], "--json") == 0)
+    {
+      json = true;
+    }
+    else if ((strcmp(argv[idx], "--duration-ms") == 0) && ((idx + 1) < argc))
+    {
+      durationMs = (uint32_t)strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "--samples") == 0) && ((idx + 1) < argc))
+    {
+      samples = (uint32_t)strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((argv[idx][0] != '-') && (positional == 0))
+    {
+      device = argv[idx];
+      positional++;
+    }
+    else if ((argv[idx][0] != '-') && (positional == 1))
+    {
+      echoDevice = argv[idx];
+      positional++;
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--json] [--duration-ms N] [--samples N] "
+              "[device [echo_device]]\n", argv[0]);
+      result = EXIT_FAILURE;
+      break;
+    }
+  }
+  if (echoDevice == NULL)
+  {
+    echoDevice = device;
+  }
+  if ((durationMs == 0) || (samples == 0))
+  {
+    fprintf(stderr, "[ERROR] Duration and samples must be more than zero.\n");
+    result = EXIT_FAILURE;
+  }
+
+  /* Check the CAN devices and find out if they operate in CAN FD mode. */
+  if (result == EXIT_SUCCESS)
+  {
+    probeCtx = cancomm_new();
+    if (probeCtx != NULL)
+    {
+      /* Fail early on CAN devices that are missing or down. */
+      if ((cancomm_connect(probeCtx, device) != CANCOMM_TRUE) ||
+          (cancomm_connect(probeCtx, echoDevice) != CANCOMM_TRUE))
+      {
+        fprintf(stderr, "[ERROR] Could not connect to '%s' and '%s'.\n", device,
+                echoDevice);
+        result = EXIT_FAILURE;
+      }
+      cancomm_disconnect(probeCtx);
+      if ((cancomm_link_get_config(probeCtx, device, &linkConfig) == CANCOMM_TRUE) &&
+          (linkConfig.fd == CANCOMM_TRUE) &&
+          (cancomm_link_get_config(probeCtx, echoDevice, &linkConfig) == CANCOMM_TRUE) &&
+          (linkConfig.fd == CANCOMM_TRUE))
+      {
+        fdSupported = true;
+      }
+      cancomm_free(probeCtx);
+    }
+    if ((result == EXIT_SUCCESS) && (!fdSupported))
+    {
+      fprintf(stderr, "[INFO] Skipping the CAN FD tests, because '%s' or '%s' does not"
+              " operate in CAN FD mode.\n", device, echoDevice);
+    }
+  }
+
+  /* Measure the throughput in each of the modes, for CAN classic and CAN FD. */
+  if (result == EXIT_SUCCESS)
+  {
+    started = true;
+    if (json)
+    {
+      printf("{\n  \"device\": \"%s\",\n  \"echo_device\": \"%s\",\n", device,
+             echoDevice);
+      printf("  \"throughput\": [");
+    }
+    else
+    {
+      printf("%-10s %-8s %12s %12s %10s %12s %14s\n", "mode", "format", "sent",
+             "received", "overflows", "frames/s", "cpu ns/frame");
+    }
+    for (uint32_t mode = 0; mode < BENCH_MODE_CNT; mode++)
+    {
+      for (uint32_t fd = 0; fd <= (fdSupported ? 1U : 0U); fd++)
+      {
+        if (!BenchThroughput(device, echoDevice, mode, (fd == 1U), durationMs,
+                             &throughput))
+        {
+          fprintf(stderr, "[ERROR] Throughput test failed for mode '%s'.\n",
+                  benchModeNames[mode]);
+          result = EXIT_FAILURE;
+          continue;
+        }
+        if (json)
+        {
+          printf("%s\n    { \"mode\": \"%s\", \"format\": \"%s\", \"sent\": %" PRIu64
+                 ", \"received\": %" PRIu64 ", \"overflows\": %" PRIu64
+                 ", \"frames_per_s\": %.1f, \"cpu_ns_per_frame\": %.1f }",
+                 first ? "" : ",", benchModeNames[mode], (fd == 1U) ? "fd" : "classic",
+                 throughput.sent, throughput.received, throughput.overflows,
+                 throughput.frames_per_s, throughput.cpu_ns_per_frame);
+          first = false;
+        }
+        else
+        {
+          printf("%-10s %-8s %12" PRIu64 " %12" PRIu64 " %10" PRIu64 " %12.0f %14.1f\n",
+                 benchModeNames[mode], (fd == 1U) ? "fd" : "classic", throughput.sent,
+                 throughput.received, throughput.overflows, throughput.frames_per_s,
+                 throughput.cpu_ns_per_frame);
+        }
+      }
+    }
+    if (json)
+    {
+      printf("\n  ],\n  \"latency\": [");
+    }
+    else
+    {
+      printf("\n%-10s %10s %8s %10s %10s %10s %14s\n", "mode", "samples", "lost",
+             "p50 us", "p99 us", "p99.9 us", "cpu ns/frame");
+    }
+  }
+
+  /* Measure the round trip latency in each of the modes. Also after a failed
+   * throughput test, which keeps the output complete.
+   */
+  if (started)
+  {
+    first = true;
+    for (uint32_t mode = 0; mode < BENCH_MODE_CNT; mode++)
+    {
+      if (!BenchLatency(device, echoDevice, mode, samples, &latency))
+      {
+        fprintf(stderr, "[ERROR] Latency test failed for mode '%s'.\n",
+                benchModeNames[mode]);
+        result = EXIT_FAILURE;
+        continue;
+      }
+      if (json)
+      {
+        printf("%s\n    { \"mode\": \"%s\", \"samples\": %" PRIu32 ", \"lost\": %" PRIu32
+               ", \"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f"
+               ", \"cpu_ns_per_frame\": %.1f }",
+               first ? "" : ",", benchModeNames[mode], latency.samples, latency.lost,
+               latency.p50_us, latency.p99_us, latency.p999_us,
+               latency.cpu_ns_per_frame);
+        first = false;
+      }
+      else
+      {
+        printf("%-10s %10" PRIu32 " %8" PRIu32 " %10.1f %10.1f %10.1f %14.1f\n",
+               benchModeNames[mode], latency.samples, latency.lost, latency.p50_us,
+               latency.p99_us, latency.p999_us, latency.cpu_ns_per_frame);
+      }
+    }
+    if (json)
+    {
+      printf("\n  ]\n}\n");
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of main ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the time of the monotonic clock.
+** \return    Time in nanoseconds.
+**
+****************************************************************************************/
+static uint64_t BenchTimeNs(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+} /*** end of BenchTimeNs ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the CPU time that all threads of the process spent so far, both in
+**            user space and in the kernel.
+** \return    CPU time in nanoseconds.
+**
+****************************************************************************************/
+static uint64_t BenchCpuNs(void)
+{
+  uint64_t result = 0;
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+    result = (((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) *
+              1000000000ULL) +
+             (((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) *
+              1000ULL);
+  }
+  return result;
+} /*** end of BenchCpuNs ***/
+
+
+/************************************************************************************//**
+** \brief     Creates a context and connects it to the CAN device. Starts the background
+**            reader for the ring buffer mode.
+** \param     device Null terminated string with the SocketCAN device name.
+** \param     mode Benchmark mode, such as BENCH_MODE_RING.
+** \return    The context, or NULL in case of an error.
+**
+****************************************************************************************/
+static cancomm_t BenchConnect(char const * device, uint32_t mode)
+{
+  cancomm_t result;
+
+  result = cancomm_new();
+  if (result != NULL)
+  {
+    if ((cancomm_connect(result, device) != CANCOMM_TRUE) ||
+        ((mode == BENCH_MODE_RING) &&
+         (cancomm_reader_start(result, BENCH_RING_CAPACITY) != CANCOMM_TRUE)))
+    {
+      cancomm_free(result);
+      result = NULL;
+    }
+  }
+  return result;
+} /*** end of BenchConnect ***/
+
+
+/************************************************************************************//**
+** \brief     Disconnects and releases a context, created with BenchConnect().
+** \param     ctx The context.
+**
+****************************************************************************************/
+static void BenchDisconnect(cancomm_t ctx)
+{
+  if (ctx != NULL)
+  {
+    cancomm_disconnect(ctx);
+    cancomm_free(ctx);
+  }
+} /*** end of BenchDisconnect ***/
+
+
+/************************************************************************************//**
+** \brief     Receives frames in the way of the specified mode.
+** \param     ctx CAN communication context.
+** \param     mode Benchmark mode, such as BENCH_MODE_BATCHED.
+** \param     frames Pointer to the array where the received frames are stored.
+** \param     max Maximum number of frames that fit in the array.
+** \param     timeout_us Maximum time in microseconds to wait for a frame.
+** \return    Number of received frames. Zero if the timeout expired.
+**
+****************************************************************************************/
+static size_t BenchReceive(cancomm_t ctx, uint32_t mode, cancomm_frame_t * frames,
+                           size_t max, uint32_t timeout_us)
+{
+  size_t result = 0;
+  uint64_t deadline = BenchTimeNs() + ((uint64_t)timeout_us * 1000U);
+  struct pollfd pfd;
+
+  switch (mode)
+  {
+    case BENCH_MODE_SINGLE:
+      /* Poll until a frame arrives. */
+      do
+      {
+        if (cancomm_receive(ctx, &frames[0].id, &frames[0].ext, &frames[0].len,
+                            frames[0].data, &frames[0].flags,
+                            &frames[0].timestamp) == CANCOMM_TRUE)
+        {
+          result = 1;
+        }
+      }
+      while ((result == 0) && (BenchTimeNs() < deadline));
+      break;
+
+    case BENCH_MODE_BATCHED:
+      /* Sleep until frames arrive and then read all of them at once. */
+      pfd.fd = cancomm_get_fd(ctx);
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, (int)(timeout_us / 1000U)) > 0)
+      {
+        (void)cancomm_receive_batch(ctx, frames, max, &result);
+      }
+      break;
+
+    case BENCH_MODE_BLOCKING:
+      /* Sleep in the kernel until a frame arrives. */
+      if (cancomm_receive_timeout(ctx, &frames[0].id, &frames[0].ext, &frames[0].len,
+                                  frames[0].data, &frames[0].flags,
+                                  &frames[0].timestamp, timeout_us) == CANCOMM_TRUE)
+      {
+        result = 1;
+      }
+      break;
+
+    default:
+      /* Spin on the ring buffer of the background reader until frames arrive. */
+      do
+      {
+        (void)cancomm_reader_pop_batch(ctx, frames, max, &result);
+      }
+      while ((result == 0) && (BenchTimeNs() < deadline));
+      break;
+  }
+  return result;
+} /*** end of BenchReceive ***/
+
+
+/************************************************************************************//**
+** \brief     Transmits frames in the way of the specified mode. Waits for space in the
+**            transmit queue, while it is full.
+** \param     ctx CAN communication context.
+** \param     mode Benchmark mode, such as BENCH_MODE_SINGLE.
+** \param     frames Pointer to the array with the frames to transmit.
+** \param     count Number of frames in the array.
+** \return    Number of transmitted frames.
+**
+****************************************************************************************/
+static size_t BenchTransmit(cancomm_t ctx, uint32_t mode, cancomm_frame_t * frames,
+                            size_t count)
+{
+  size_t result = 0;
+  size_t sent;
+  uint8_t txResult;
+
+  while (result < count)
+  {
+    if (mode == BENCH_MODE_SINGLE)
+    {
+      txResult = cancomm_transmit(ctx, frames[result].id, frames[result].ext,
+                                  frames[result].len, frames[result].data,
+                                  frames[result].flags, NULL);
+      sent = (txResult == CANCOMM_TRUE) ? 1U : 0U;
+    }
+    else
+    {
+      txResult = cancomm_transmit_batch(ctx, &frames[result], count - result, &sent);
+    }
+    result += sent;
+    /* Wait for space in the transmit queue, if full. Give up on other errors. */
+    if ((txResult != CANCOMM_TRUE) && (cancomm_last_tx_queue_full() == CANCOMM_TRUE))
+    {
+      (void)cancomm_wait_writable(ctx, 1000U);
+    }
+    else if (txResult != CANCOMM_TRUE)
+    {
+      break;
+    }
+  }
+  return result;
+} /*** end of BenchTransmit ***/
+
+
+/************************************************************************************//**
+** \brief     Thread of the throughput test that receives and counts frames, until it is
+**            asked to stop and the bus is idle.
+** \param     arg Pointer to the shared state of type tBenchThread.
+** \return    Always NULL.
+**
+****************************************************************************************/
+static void * BenchReceiverThread(void * arg)
+{
+  tBenchThread * thread = (tBenchThread *)arg;
+  cancomm_frame_t frames[BENCH_BATCH_SIZE];
+  size_t count;
+
+  for (;;)
+  {
+    count = BenchReceive(thread->ctx, thread->mode, frames, BENCH_BATCH_SIZE,
+                         BENCH_IDLE_TIMEOUT_US);
+    if (count > 0)
+    {
+      thread->received += count;
+      thread->last_time = BenchTimeNs();
+    }
+    else if (atomic_load(&thread->stop))
+    {
+      break;
+    }
+  }
+  return NULL;
+} /*** end of BenchReceiverThread ***/
+
+
+/************************************************************************************//**
+** \brief     Thread of the latency test that sends each received ping frame back as a
+**            pong frame, until it is asked to stop.
+** \param     arg Pointer to the shared state of type tBenchThread.
+** \return    Always NULL.
+**
+****************************************************************************************/
+static void * BenchEchoThread(void * arg)
+{
+  tBenchThread * thread = (tBenchThread *)arg;
+  cancomm_frame_t frames[BENCH_BATCH_SIZE];
+  size_t count;
+  size_t pongs;
+
+  while (!atomic_load(&thread->stop))
+  {
+    count = BenchReceive(thread->ctx, thread->mode, frames, BENCH_BATCH_SIZE,
+                         BENCH_IDLE_TIMEOUT_US);
+    /* Turn the pings into pongs, in place. */
+    pongs = 0;
+    for (size_t idx = 0; idx < count; idx++)
+    {
+      if (frames[idx].id == BENCH_PING_ID)
+      {
+        frames[pongs] = frames[idx];
+        frames[pongs].id = BENCH_PONG_ID;
+        frames[pongs].ifindex = 0;
+        pongs++;
+      }
+    }
+    if (pongs > 0)
+    {
+      (void)BenchTransmit(thread->ctx, thread->mode, frames, pongs);
+    }
+  }
+  return NULL;
+} /*** end of BenchEchoThread ***/
+
+
+/************************************************************************************//**
+** \brief     Measures the maximum sustained throughput. Transmits frames as fast as
+**            possible for the specified duration and counts how many of them a receiver
+**            thread on the second context manages to receive.
+** \param     txDevice Null terminated string with the transmitting SocketCAN device.
+** \param     rxDevice Null terminated string with the receiving SocketCAN device.
+** \param     mode Benchmark mode, such as BENCH_MODE_BATCHED.
+** \param     fd True for CAN FD frames with 64 data bytes, false for CAN classic frames
+**            with 8 data bytes.
+** \param     durationMs Duration of the test in milliseconds.
+** \param     result Pointer to where the results are stored.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+static bool BenchThroughput(char const * txDevice, char const * rxDevice,
+                            uint32_t mode, bool fd, uint32_t durationMs,
+                            tBenchThroughput * result)
+{
+  bool success = false;
+  cancomm_t txCtx;
+  tBenchThread thread = { 0 };
+  pthread_t threadHandle;
+  cancomm_frame_t frames[BENCH_BATCH_SIZE] = { 0 };
+  cancomm_stats_t stats;
+  uint64_t startTime;
+  uint64_t endTime;
+  uint64_t startCpu;
+  uint64_t sent = 0;
+
+  /* Connect the receiver first, such that it sees all the frames. */
+  thread.ctx = BenchConnect(rxDevice, mode);
+  txCtx = BenchConnect(txDevice, BENCH_MODE_BATCHED);
+  thread.mode = mode;
+  atomic_init(&thread.stop, false);
+  if ((thread.ctx != NULL) && (txCtx != NULL) &&
+      (pthread_create(&threadHandle, NULL, BenchReceiverThread, &thread) == 0))
+  {
+    /* Prepare the frames. */
+    for (size_t idx = 0; idx < BENCH_BATCH_SIZE; idx++)
+    {
+      frames[idx].id = BENCH_PING_ID;
+      frames[idx].len = fd ? 64U : 8U;
+      frames[idx].flags = fd ? CANCOMM_FLAG_CANFD_MSG : 0U;
+    }
+    /* Transmit for the duration of the test. */
+    startCpu = BenchCpuNs();
+    startTime = BenchTimeNs();
+    endTime = startTime + ((uint64_t)durationMs * 1000000ULL);
+    do
+    {
+      sent += BenchTransmit(txCtx, mode, frames, BENCH_BATCH_SIZE);
+    }
+    while (BenchTimeNs() < endTime);
+    /* Let the receiver finish. */
+    atomic_store(&thread.stop, true);
+    (void)pthread_join(threadHandle, NULL);
+    /* Determine the results. */
+    result->sent = sent;
+    result->received = thread.received;
+    result->overflows = 0;
+    if (cancomm_get_stats(thread.ctx, &stats) == CANCOMM_TRUE)
+    {
+      result->overflows = stats.rx_overflows + stats.reader_drops;
+    }
+    if (thread.last_time < endTime)
+    {
+      thread.last_time = endTime;
+    }
+    result->frames_per_s = (double)thread.received * 1e9 /
+                           (double)(thread.last_time - startTime);
+    result->cpu_ns_per_frame = (thread.received > 0) ?
+                               ((double)(BenchCpuNs() - startCpu) /
+                                (double)thread.received) : 0.0;
+    success = true;
+  }
+  BenchDisconnect(txCtx);
+  BenchDisconnect(thread.ctx);
+  return success;
+} /*** end of BenchThroughput ***/
+
+
+/************************************************************************************//**
+** \brief     Measures the round trip latency. Transmits a ping frame, waits for the
+**            pong frame that an echo thread on the second context sends back, and
+**            measures the time in between. The next ping goes out after the pong came
+**            in, so only one frame is underway at a time.
+** \param     device Null terminated string with the pinging SocketCAN device.
+** \param     echoDevice Null terminated string with the echoing SocketCAN device.
+** \param     mode Benchmark mode, such as BENCH_MODE_BLOCKING.
+** \param     samples Number of round trips to measure.
+** \param     result Pointer to where the results are stored.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+static bool BenchLatency(char const * device, char const * echoDevice, uint32_t mode,
+                         uint32_t samples, tBenchLatency * result)
+{
+  bool success = false;
+  cancomm_t ctx;
+  tBenchThread thread = { 0 };
+  pthread_t threadHandle;
+  cancomm_frame_t ping = { 0 };
+  cancomm_frame_t frames[BENCH_BATCH_SIZE];
+  uint64_t * times;
+  uint64_t startTime;
+  uint64_t startCpu = 0;
+  uint32_t measured = 0;
+  uint32_t lost = 0;
+  size_t count;
+  bool pong;
+
+  times = malloc((size_t)samples * sizeof(uint64_t));
+  thread.ctx = BenchConnect(echoDevice, mode);
+  ctx = BenchConnect(device, mode);
+  thread.mode = mode;
+  atomic_init(&thread.stop, false);
+  if ((times != NULL) && (thread.ctx != NULL) && (ctx != NULL) &&
+      (pthread_create(&threadHandle, NULL, BenchEchoThread, &thread) == 0))
+  {
+    ping.id = BENCH_PING_ID;
+    ping.len = 8U;
+    for (uint32_t idx = 0; idx < (BENCH_WARMUP_SAMPLES + samples); idx++)
+    {
+      /* Start measuring the CPU time once warmed up. */
+      if (idx == BENCH_WARMUP_SAMPLES)
+      {
+        startCpu = BenchCpuNs();
+      }
+      /* Ping and wait for the pong. */
+      memcpy(ping.data, &idx, sizeof(idx));
+      startTime = BenchTimeNs();
+      if (BenchTransmit(ctx, mode, &ping, 1) != 1U)
+      {
+        /* Only count the losses after warming up, the same as for the pongs. */
+        if (idx >= BENCH_WARMUP_SAMPLES)
+        {
+          lost++;
+        }
+        continue;
+      }
+      pong = false;
+      do
+      {
+        count = BenchReceive(ctx, mode, frames, BENCH_BATCH_SIZE, BENCH_IDLE_TIMEOUT_US);
+        for (size_t frameIdx = 0; frameIdx < count; frameIdx++)
+        {
+          if ((frames[frameIdx].id == BENCH_PONG_ID) &&
+              (memcmp(frames[frameIdx].data, &idx, sizeof(idx)) == 0))
+          {
+            pong = true;
+          }
+        }
+      }
+      while ((!pong) && (count > 0));
+      /* Store the round trip time. */
+      if (idx >= BENCH_WARMUP_SAMPLES)
+      {
+        if (pong)
+        {
+          times[measured] = BenchTimeNs() - startTime;
+          measured++;
+        }
+        else
+        {
+          lost++;
+        }
+      }
+    }
+    atomic_store(&thread.stop, true);
+    (void)pthread_join(threadHandle, NULL);
+    /* Determine the percentiles. */
+    result->samples = measured;
+    result->lost = lost;
+    result->p50_us = 0.0;
+    result->p99_us = 0.0;
+    result->p999_us = 0.0;
+    result->cpu_ns_per_frame = 0.0;
+    if (measured > 0)
+    {
+      qsort(times, measured, sizeof(uint64_t), BenchCompare);
+      result->p50_us = (double)times[((size_t)(measured - 1U) * 500U) / 1000U] / 1e3;
+      result->p99_us = (double)times[((size_t)(measured - 1U) * 990U) / 1000U] / 1e3;
+      result->p999_us = (double)times[((size_t)(measured - 1U) * 999U) / 1000U] / 1e3;
+      result->cpu_ns_per_frame = (double)(BenchCpuNs() - startCpu) / (double)measured;
+    }
+    success = true;
+  }
+  BenchDisconnect(ctx);
+  BenchDisconnect(thread.ctx);
+  free(times);
+  return success;
+} /*** end of BenchLatency ***/
+
+
+/************************************************************************************//**
+** \brief     Compares two round trip times for sorting them with qsort().
+** \param     a Pointer to the first time.
+** \param     b Pointer to the second time.
+** \return    Negative, zero or positive if the first time is less than, equal to or
+**            more than the second time.
+**
+****************************************************************************************/
+static int BenchCompare(void const * a, void const * b)
+{
+  uint64_t timeA = *(uint64_t const *)a;
+  uint64_t timeB = *(uint64_t const *)b;
+
+  return (timeA > timeB) - (timeA < timeB);
+} /*** end of BenchCompare ***/
+
+
+/********************************** end of benchmark.c *********************************/
@@ -0,0 +1,424 @@
+/************************************************************************************//**
+* \file         microbench.c
+* \brief        Source file of the micro benchmark for the frame conversion.
+*
+*----------------------------------------------------------------------------------------
+*                          C O P Y R I G H T
+*----------------------------------------------------------------------------------------
+*           Copyright (c) 2022 by PragmaticLinux     All rights reserved
+*
+*----------------------------------------------------------------------------------------
+*                            L I C E N S E
+*----------------------------------------------------------------------------------------
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files (the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+* CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>                         /* for standard integer types              */
+#include <stdbool.h>                        /* for boolean type                        */
+#include <stdio.h>                          /* for standard I/O functions.             */
+#include <stdlib.h>                         /* for standard library                    */
+#include <string.h>                         /* for string library                      */
+#include <time.h>                           /* clock functions                         */
+#include <cancomm_inline.h>                 /* Inline frame conversion fast path       */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Default number of conversions per measurement. */
+#define MICRO_ITERATIONS_DEFAULT       (10000000U)
+
+/** \brief Keeps the compiler from inlining a function into its caller. The conversions
+ *         are called through a function pointer, as a call into the library would be,
+ *         such that the compiler cannot specialize them for the measurement loop.
+ */
+#define MICRO_NOINLINE                 __attribute__((noinline))
+
+/** \brief Number of different frames that the measurements cycle through. Keeps the
+ *         compiler from hoisting the conversion out of the loop.
+ */
+#define MICRO_FRAME_CNT                (16U)
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Function type of a frame pack implementation. */
+typedef uint8_t (* tMicroPackFn)(uint32_t id, uint8_t ext, uint8_t len,
+                                 uint8_t const * data, uint8_t flags, uint8_t fd_enabled,
+                                 struct canfd_frame * raw, size_t * size);
+
+/** \brief Function type of a frame unpack implementation. */
+typedef uint8_t (* tMicroUnpackFn)(struct canfd_frame const * raw, size_t size,
+                                   cancomm_frame_t * frame);
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static uint64_t MicroTimeNs(void);
+static uint8_t  MicroRefLenSanitize(uint8_t len);
+static uint8_t  MicroRefPack(uint32_t id, uint8_t ext, uint8_t len, uint8_t const * data,
+                             uint8_t flags, uint8_t fd_enabled, struct canfd_frame * raw,
+                             size_t * size) MICRO_NOINLINE;
+static uint8_t  MicroRefUnpack(struct canfd_frame const * raw, size_t size,
+                               cancomm_frame_t * frame) MICRO_NOINLINE;
+static uint8_t  MicroInlinePack(uint32_t id, uint8_t ext, uint8_t len,
+                                uint8_t const * data, uint8_t flags, uint8_t fd_enabled,
+                                struct canfd_frame * raw, size_t * size) MICRO_NOINLINE;
+static uint8_t  MicroInlineUnpack(struct canfd_frame const * raw, size_t size,
+                                  cancomm_frame_t * frame) MICRO_NOINLINE;
+static double   MicroPack(tMicroPackFn fn, uint8_t len, uint8_t fd,
+                          uint32_t iterations) MICRO_NOINLINE;
+static double   MicroUnpack(tMicroUnpackFn fn, uint8_t len, uint8_t fd,
+                            uint32_t iterations) MICRO_NOINLINE;
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Sink for the results of the conversions, such that the compiler cannot
+ *         optimize them away.
+ */
+static volatile uint32_t microSink;
+
+
+/************************************************************************************//**
+** \brief     This micro benchmark program measures the time that the conversion of a
+**            frame between the format of the library and the format of the CAN raw
+**            socket takes. It compares the inline fast path of cancomm_inline.h with a
+**            reference implementation that copies the data byte by byte and sanitizes
+**            the length with two table lookups. It needs no CAN device.
+**
+**            Usage: cancomm_microbench [iterations]
+** \param     argc Number of program arguments.
+** \param     argv Array with program arguments.
+** \return    Program exit code. EXIT_SUCCESS for success, EXIT_FAILURE otherwise.
+**
+****************************************************************************************/
+int main(int argc, char const * const argv[])
+{
+  int      result = EXIT_SUCCESS;
+  uint32_t iterations = MICRO_ITERATIONS_DEFAULT;
+  double   refNs;
+  double   inlineNs;
+  static const struct
+  {
+    char const * name;
+    uint8_t      len;
+    uint8_t      fd;
+  } cases[] =
+  {
+    { "classic 8 bytes", CAN_MAX_DLEN, CANCOMM_FALSE },
+    { "fd 14 bytes", 14U, CANCOMM_TRUE },
+    { "fd 64 bytes", CANFD_MAX_DLEN, CANCOMM_TRUE }
+  };
+
+  /* Process the program arguments. */
+  if (argc > 2)
+  {
+    fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    result = EXIT_FAILURE;
+  }
+  else if (argc == 2)
+  {
+    iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (iterations == 0)
+    {
+      fprintf(stderr, "[ERROR] Iterations must be more than zero.\n");
+      result = EXIT_FAILURE;
+    }
+  }
+
+  if (result == EXIT_SUCCESS)
+  {
+    printf("%-8s %-16s %12s %12s %8s\n", "path", "frame", "reference", "inline",
+           "speedup");
+    for (size_t idx = 0; idx < (sizeof(cases) / sizeof(cases[0])); idx++)
+    {
+      refNs = MicroPack(MicroRefPack, cases[idx].len, cases[idx].fd, iterations);
+      inlineNs = MicroPack(MicroInlinePack, cases[idx].len, cases[idx].fd, iterations);
+      printf("%-8s %-16s %9.2f ns %9.2f ns %7.2fx\n", "pack", cases[idx].name, refNs,
+             inlineNs, refNs / inlineNs);
+    }
+    for (size_t idx = 0; idx < (sizeof(cases) / sizeof(cases[0])); idx++)
+    {
+      refNs = MicroUnpack(MicroRefUnpack, cases[idx].len, cases[idx].fd, iterations);
+      inlineNs = MicroUnpack(MicroInlineUnpack, cases[idx].len, cases[idx].fd,
+                             iterations);
+      printf("%-8s %-16s %9.2f ns %9.2f ns %7.2fx\n", "unpack", cases[idx].name, refNs,
+             inlineNs, refNs / inlineNs);
+    }
+  }
+
+  return result;
+} /*** end of main ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the time of the monotonic clock.
+** \return    Time in nanoseconds.
+**
+****************************************************************************************/
+static uint64_t MicroTimeNs(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+} /*** end of MicroTimeNs ***/
+
+
+/************************************************************************************//**
+** \brief     Reference implementation of the frame length sanitizing, which converts
+**            the length to the CAN FD dlc value and back, with two table lookups.
+** \param     len Unsanitized frame length. 0..64.
+** \return    Sanitized frame length in the range 0..8, 12, 16, 20, 24, 32, 48, 64.
+**
+****************************************************************************************/
+static uint8_t MicroRefLenSanitize(uint8_t len)
+{
+  static const uint8_t len2dlc[] =
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,    /*  0 -  8 */
+     9,  9,  9,  9,                        /*  9 - 12 */
+    10, 10, 10, 10,                        /* 13 - 16 */
+    11, 11, 11, 11,                        /* 17 - 20 */
+    12, 12, 12, 12,                        /* 21 - 24 */
+    13, 13, 13, 13, 13, 13, 13, 13,        /* 25 - 32 */
+    14, 14, 14, 14, 14, 14, 14, 14,        /* 33 - 40 */
+    14, 14, 14, 14, 14, 14, 14, 14,        /* 41 - 48 */
+    15, 15, 15, 15, 15, 15, 15, 15,        /* 49 - 56 */
+    15, 15, 15, 15, 15, 15, 15, 15         /* 57 - 64 */
+  };
+  static const uint8_t dlc2len[] =
+  {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64
+  };
+
+  return dlc2len[len2dlc[(len > CANFD_MAX_DLEN) ? CANFD_MAX_DLEN : len]];
+} /*** end of MicroRefLenSanitize ***/
+
+
+/************************************************************************************//**
+** \brief     Reference implementation of the frame packing, which clears the entire
+**            frame and copies the data byte by byte.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
+**            29-bit.
+** \param     len Number of CAN message data bytes.
+** \param     data Pointer to array with data bytes.
+** \param     flags Bit flags with additional information about the message.
+** \param     fd_enabled CANCOMM_TRUE if CAN FD frames are allowed.
+** \param     raw Pointer to where the constructed frame is stored.
+** \param     size Pointer to where the number of bytes to write is stored.
+** \return    CANCOMM_TRUE if the frame was constructed, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t MicroRefPack(uint32_t id, uint8_t ext, uint8_t len, uint8_t const * data,
+                            uint8_t flags, uint8_t fd_enabled, struct canfd_frame * raw,
+                            size_t * size)
+{
+  uint8_t result = CANCOMM_FALSE;
+  uint8_t frameLenMax = CAN_MAX_DLEN;
+
+  memset(raw, 0, sizeof(struct canfd_frame));
+  *size = CAN_MTU;
+  if ((fd_enabled) && (flags & CANCOMM_FLAG_CANFD_MSG))
+  {
+    frameLenMax = CANFD_MAX_DLEN;
+    *size = CANFD_MTU;
+    raw->flags |= CANFD_BRS;
+  }
+  if (len <= frameLenMax)
+  {
+    raw->can_id = id;
+    if (ext == CANCOMM_TRUE)
+    {
+      raw->can_id |= CAN_EFF_FLAG;
+    }
+    raw->len = MicroRefLenSanitize(len);
+    for (uint8_t idx = 0; idx < len; idx++)
+    {
+      raw->data[idx] = data[idx];
+    }
+    result = CANCOMM_TRUE;
+  }
+  return result;
+} /*** end of MicroRefPack ***/
+
+
+/************************************************************************************//**
+** \brief     Reference implementation of the frame unpacking, which copies the data
+**            byte by byte.
+** \param     raw Pointer to the frame as received from the socket.
+** \param     size Number of bytes that the socket returned for the frame.
+** \param     frame Pointer to where the converted frame is stored.
+** \return    CANCOMM_TRUE if the frame was converted, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t MicroRefUnpack(struct canfd_frame const * raw, size_t size,
+                              cancomm_frame_t * frame)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  if (((size == CANFD_MTU) || (size == CAN_MTU)) && (!(raw->can_id & CAN_RTR_FLAG)))
+  {
+    frame->flags = (size == CANFD_MTU) ? CANCOMM_FLAG_CANFD_MSG : 0;
+    frame->ext = (raw->can_id & CAN_EFF_FLAG) ? CANCOMM_TRUE : CANCOMM_FALSE;
+    frame->id = raw->can_id & ~CAN_EFF_FLAG;
+    frame->len = raw->len;
+    for (uint8_t idx = 0; idx < raw->len; idx++)
+    {
+      frame->data[idx] = raw->data[idx];
+    }
+    result = CANCOMM_TRUE;
+  }
+  return result;
+} /*** end of MicroRefUnpack ***/
+
+
+/************************************************************************************//**
+** \brief     Calls the inline frame packing through a function pointer, just like the
+**            reference implementation, for a fair comparison.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
+**            29-bit.
+** \param     len Number of CAN message data bytes.
+** \param     data Pointer to array with data bytes.
+** \param     flags Bit flags with additional information about the message.
+** \param     fd_enabled CANCOMM_TRUE if CAN FD frames are allowed.
+** \param     raw Pointer to where the constructed frame is stored.
+** \param     size Pointer to where the number of bytes to write is stored.
+** \return    CANCOMM_TRUE if the frame was constructed, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t MicroInlinePack(uint32_t id, uint8_t ext, uint8_t len,
+                               uint8_t const * data, uint8_t flags, uint8_t fd_enabled,
+                               struct canfd_frame * raw, size_t * size)
+{
+  return cancomm_inline_frame_pack(id, ext, len, data, flags, fd_enabled, raw, size);
+} /*** end of MicroInlinePack ***/
+
+
+/************************************************************************************//**
+** \brief     Calls the inline frame unpacking through a function pointer, just like the
+**            reference implementation, for a fair comparison.
+** \param     raw Pointer to the frame as received from the socket.
+** \param     size Number of bytes that the socket returned for the frame.
+** \param     frame Pointer to where the converted frame is stored.
+** \return    CANCOMM_TRUE if the frame was converted, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t MicroInlineUnpack(struct canfd_frame const * raw, size_t size,
+                                 cancomm_frame_t * frame)
+{
+  return cancomm_inline_frame_unpack(raw, size, frame);
+} /*** end of MicroInlineUnpack ***/
+
+
+/************************************************************************************//**
+** \brief     Measures the time of a frame pack implementation.
+** \param     fn Frame pack implementation.
+** \param     len Number of data bytes of the frames.
+** \param     fd True for CAN FD frames, false for CAN classic frames.
+** \param     iterations Number of conversions to measure.
+** \return    Average time of a conversion in nanoseconds.
+**
+****************************************************************************************/
+static double MicroPack(tMicroPackFn fn, uint8_t len, uint8_t fd, uint32_t iterations)
+{
+  static cancomm_frame_t frames[MICRO_FRAME_CNT];
+  struct canfd_frame raw;
+  size_t size;
+  uint32_t sum = 0;
+  uint64_t startNs;
+  uint64_t stopNs;
+
+  /* Prepare the frames to convert. */
+  for (uint32_t idx = 0; idx < MICRO_FRAME_CNT; idx++)
+  {
+    frames[idx].id = 0x100U + idx;
+    frames[idx].ext = CANCOMM_FALSE;
+    frames[idx].len = len;
+    frames[idx].flags = (fd != CANCOMM_FALSE) ? CANCOMM_FLAG_CANFD_MSG : 0;
+    memset(frames[idx].data, (int)idx, sizeof(frames[idx].data));
+  }
+
+  /* Convert the frames and time it. */
+  startNs = MicroTimeNs();
+  for (uint32_t idx = 0; idx < iterations; idx++)
+  {
+    cancomm_frame_t const * frame = &frames[idx % MICRO_FRAME_CNT];
+
+    (void)fn(frame->id, frame->ext, frame->len, frame->data, frame->flags, fd, &raw,
+             &size);
+    sum += raw.data[idx % CAN_MAX_DLEN] + (uint32_t)size;
+  }
+  stopNs = MicroTimeNs();
+  microSink = sum;
+
+  return (double)(stopNs - startNs) / (double)iterations;
+} /*** end of MicroPack ***/
+
+
+/************************************************************************************//**
+** \brief     Measures the time of a frame unpack implementation.
+** \param     fn Frame unpack implementation.
+** \param     len Number of data bytes of the frames.
+** \param     fd True for CAN FD frames, false for CAN classic frames.
+** \param     iterations Number of conversions to measure.
+** \return    Average time of a conversion in nanoseconds.
+**
+****************************************************************************************/
+static double MicroUnpack(tMicroUnpackFn fn, uint8_t len, uint8_t fd,
+                          uint32_t iterations)
+{
+  static struct canfd_frame raws[MICRO_FRAME_CNT];
+  cancomm_frame_t frame;
+  size_t size = (fd != CANCOMM_FALSE) ? CANFD_MTU : CAN_MTU;
+  uint32_t sum = 0;
+  uint64_t startNs;
+  uint64_t stopNs;
+
+  /* Prepare the frames to convert. */
+  for (uint32_t idx = 0; idx < MICRO_FRAME_CNT; idx++)
+  {
+    memset(&raws[idx], (int)idx, sizeof(raws[idx]));
+    raws[idx].can_id = 0x100U + idx;
+    raws[idx].len = len;
+  }
+
+  /* Convert the frames and time it. */
+  startNs = MicroTimeNs();
+  for (uint32_t idx = 0; idx < iterations; idx++)
+  {
+    (void)fn(&raws[idx % MICRO_FRAME_CNT], size, &frame);
+    sum += frame.data[idx % CAN_MAX_DLEN] + frame.len;
+  }
+  stopNs = MicroTimeNs();
+  microSink = sum;
+
+  return (double)(stopNs - startNs) / (double)iterations;
+} /*** end of MicroUnpack ***/
+
+
+/*********************************** end of microbench.c *******************************/
@@ -143,9 +143,11 @@ int main(int argc, char const * const argv[])
     printf("[INFO] Entering message reception loop. Press CTRL+C to exit.\n");
     while (!atomic_load(&appExitProgram))
     {
-      /* Check for the reception of a CAN message. */
-      if (cancomm_receive(canCommCtx, &canId, &canExt, &canLen, &canData[0], &canFlags, 
-                          &canTimestamp) == CANCOMM_TRUE)
+      /* Wait for the reception of a CAN message. The timeout makes sure the loop
+       * regularly checks the exit request.
+       */
+      if (cancomm_receive_timeout(canCommCtx, &canId, &canExt, &canLen, &canData[0], 
+                                  &canFlags, &canTimestamp, 100000) == CANCOMM_TRUE)
       {
         printf("[PING] Received CAN message with ID %Xh.\n", canId);
         /* Send the same message back but with an incremented identifier. */
@@ -26,21 +26,45 @@
 /****************************************************************************************
 * Include files
 ****************************************************************************************/
+#define _GNU_SOURCE                         /* for ppoll() and related Linux extensions */
 #include <assert.h>                         /* for assertions                          */
 #include <stddef.h>                         /* for NULL declaration                    */
 #include <stdlib.h>                         /* for standard library                    */
 #include <string.h>                         /* for string library                      */
+#include <stdio.h>                          /* for file streams and formatting         */
+#include <inttypes.h>                       /* for format specifiers of integer types  */
+#include <errno.h>                          /* for error numbers                       */
 #include <fcntl.h>                          /* File control operations                 */
 #include <unistd.h>                         /* UNIX standard functions                 */
+#include <poll.h>                           /* waiting for file descriptor events      */
+#include <time.h>                           /* clock functions                         */
+#include <pthread.h>                        /* POSIX threads                           */
+#include <stdatomic.h>                      /* Atomic operations                       */
+#include <stdbool.h>                        /* for boolean type                        */
 #include <net/if.h>                         /* network interfaces                      */
 #include <linux/if_arp.h>                   /* ARP definitions                         */
+#include <linux/if_packet.h>                /* Packet socket definitions               */
+#include <linux/if_ether.h>                 /* Ethernet protocol identifiers           */
+#include <arpa/inet.h>                      /* Byte order conversions                  */
 #include <linux/can.h>                      /* CAN kernel definitions                  */
 #include <linux/can/raw.h>                  /* CAN raw definitions                     */
+#include <linux/can/bcm.h>                  /* CAN broadcast manager definitions       */
+#include <linux/can/isotp.h>                /* CAN ISO-TP definitions                  */
+#include <linux/can/netlink.h>              /* CAN netlink definitions                 */
+#include <linux/can/gw.h>                   /* CAN gateway netlink definitions         */
 #include <linux/sockios.h>                  /* Socket I/O                              */
+#include <linux/net_tstamp.h>               /* Timestamping definitions                */
+#include <linux/io_uring.h>                 /* io_uring definitions                    */
 #include <sys/ioctl.h>                      /* I/O control operations                  */
-#include <sys/time.h>                       /* System time utilities                   */
-#include <ifaddrs.h>                        /* Listing network interfaces.             */
+#include <sys/socket.h>                     /* Socket functions                        */
+#include <sys/eventfd.h>                    /* Event notification file descriptors     */
+#include <sys/mman.h>                       /* Memory mapping                          */
+#include <sys/stat.h>                       /* File status                             */
+#include <sys/syscall.h>                    /* System call numbers                     */
+#include <linux/netlink.h>                  /* Netlink sockets                         */
+#include <linux/rtnetlink.h>                /* Routing netlink for network interfaces  */
 #include "cancomm.h"                        /* SocketCAN communication library         */
+#include "cancomm_inline.h"                 /* Inline frame conversion fast path       */
 
 
 /****************************************************************************************
@@ -49,10 +73,563 @@
 /** \brief Value of an invalid socket. */
 #define CANCOMM_INVALID_SOCKET         (-1)
 
+/** \brief Maximum number of frames that cancomm_receive_batch() requests from the kernel
+ *         with a single recvmmsg() call. Bounds the stack usage of the function.
+ */
+#define CANCOMM_BATCH_CHUNK_SIZE       (32U)
+
+/** \brief Size of the buffer for the control messages (ancillary data) that the kernel
+ *         passes along with each received frame.
+ */
+#define CANCOMM_CMSG_BUF_SIZE          (CMSG_SPACE(3 * sizeof(struct timespec)) + \
+                                        CMSG_SPACE(sizeof(uint32_t)))
+
+/** \brief Size of a cache line. Used to keep data that is written by different threads
+ *         apart, such that the threads do not invalidate each other's caches.
+ */
+#define CANCOMM_CACHE_LINE_SIZE        (64U)
+
+/** \brief Size of a block in the memory mapped ring of the packet mmap backend. The
+ *         kernel hands the ring over block by block. One block holds a few hundred CAN
+ *         FD frames.
+ */
+#define CANCOMM_PACKET_BLOCK_SIZE      (1U << 16)
+
+/** \brief Number of blocks in the memory mapped ring of the packet mmap backend. */
+#define CANCOMM_PACKET_BLOCK_NR        (64U)
+
+/** \brief Frame size that the kernel uses for sizing the memory mapped ring. Frames are
+ *         stored back to back with TPACKET_V3, so this is just a lower bound for the
+ *         kernel's frame count bookkeeping.
+ */
+#define CANCOMM_PACKET_FRAME_SIZE      (256U)
+
+/** \brief Time in milliseconds after which the kernel retires a partially filled block
+ *         of the memory mapped ring, such that its frames become available.
+ */
+#define CANCOMM_PACKET_BLOCK_TMO_MS    (1U)
+
+/** \brief Number of submission queue entries of the io_uring backend. */
+#define CANCOMM_URING_ENTRIES          (256U)
+
+/** \brief Number of receive buffers that the io_uring backend provides to the kernel.
+ *         Must be a power of two.
+ */
+#define CANCOMM_URING_RX_BUFS          (256U)
+
+/** \brief Size of a receive buffer of the io_uring backend. Fits the receive header of
+ *         io_uring, the source address, the ancillary data and a CAN FD frame.
+ */
+#define CANCOMM_URING_RX_BUF_SIZE      (256U)
+
+/** \brief Number of transmissions that the io_uring backend can have in flight. */
+#define CANCOMM_URING_TX_SLOTS         (128U)
+
+/** \brief Request identifier of the io_uring backend's multishot receive request. The
+ *         transmit requests use the index of their transmit slot.
+ */
+#define CANCOMM_URING_RX_TAG           (UINT64_MAX)
+
+/** \brief Identification at the start of each recording file. */
+#define CANCOMM_RECORD_MAGIC           "CANCOMMR"
+
+/** \brief Version of the recording file format. */
+#define CANCOMM_RECORD_VERSION         (1U)
+
+/** \brief Number of bytes reserved for the header at the start of a recording file. The
+ *         fixed size records follow directly after it.
+ */
+#define CANCOMM_RECORD_HEADER_SIZE     (512U)
+
+/** \brief Maximum number of CAN devices that a recording file holds the names of. */
+#define CANCOMM_RECORD_DEVICES_MAX     (16U)
+
+/** \brief Maximum number of frames that cancomm_recorder_capture() receives at once. */
+#define CANCOMM_RECORDER_BATCH_SIZE    (64U)
+
+/** \brief Time in nanoseconds to pause when the transmit queue of the CAN device is
+ *         full. Roughly the time it takes to transmit a few frames.
+ */
+#define CANCOMM_TX_BACKOFF_NS          (100000ULL)
+
+/** \brief Size of the buffer for receiving routing netlink messages. Large enough for
+ *         the kernel's netlink messages, which it sizes to a page or 8 KiB.
+ */
+#define CANCOMM_NETLINK_BUF_SIZE       (16384U)
+
+/** \brief Number of CAN devices that the list of CAN devices initially holds. */
+#define CANCOMM_DEVICES_CAPACITY_MIN   (8U)
+
+/** \brief Size of the space for the attributes of a routing netlink request about a
+ *         CAN device or a CAN gateway route. Large enough for all the attributes of a
+ *         complete configuration or route, including its CAN FD modifications.
+ */
+#define CANCOMM_LINK_ATTRS_SIZE        (1024U)
+
+/** \brief Index of the AND operation in the modifications of a route. The operations
+ *         are applied in the order of their index, the same way as the kernel does.
+ */
+#define CANCOMM_GW_OP_AND              (0U)
+
+/** \brief Index of the OR operation in the modifications of a route. */
+#define CANCOMM_GW_OP_OR               (1U)
+
+/** \brief Index of the XOR operation in the modifications of a route. */
+#define CANCOMM_GW_OP_XOR              (2U)
+
+/** \brief Index of the SET operation in the modifications of a route. */
+#define CANCOMM_GW_OP_SET              (3U)
+
+/** \brief Number of operations in the modifications of a route. */
+#define CANCOMM_GW_OPS                 (4U)
+
+/** \brief Maximum number of frames that cancomm_forwarder_run() receives and transmits
+ *         at once.
+ */
+#define CANCOMM_FORWARDER_BATCH_SIZE   (64U)
+
 
 /****************************************************************************************
 * Structure definitions
 ****************************************************************************************/
+/** \brief Lock-free single producer single consumer ring buffer with received frames.
+ *         The background reader thread is the producer. The head and tail indices run
+ *         freely and are masked upon access, so a full ring is head - tail == capacity.
+ *         Each index lives on its own cache line, next to a cached copy of the other
+ *         index. This way the threads only touch each other's cache line when the 
+ *         cached copy says that the ring appears to be full or empty.
+ */
+struct cancomm_ring
+{
+  /** \brief Index of the next slot to write. Only written by the producer. */
+  _Alignas(CANCOMM_CACHE_LINE_SIZE) atomic_size_t head;
+  /** \brief Producer's cached copy of the tail index. */
+  size_t tail_cached;
+  /** \brief Index of the next slot to read. Only written by the consumer. */
+  _Alignas(CANCOMM_CACHE_LINE_SIZE) atomic_size_t tail;
+  /** \brief Consumer's cached copy of the head index. */
+  size_t head_cached;
+  /** \brief Number of frames that were dropped, because the ring was full. */
+  _Alignas(CANCOMM_CACHE_LINE_SIZE) atomic_uint_fast64_t drops;
+  /** \brief Boolean flag to request the reader thread to stop. */
+  atomic_bool stop;
+  /** \brief Number of slots minus one. The number of slots is a power of two. */
+  size_t mask;
+  /** \brief Pointer to the array with the slots. Allocated together with the ring. */
+  cancomm_frame_t * slots;
+  /** \brief Number of slots that were allocated. Can be more than mask + 1, when a
+   *         reserved ring is used for a smaller capacity.
+   */
+  size_t slots_allocated;
+};
+
+/** \brief Entry of the snapshot table with the latest received frame of one CAN
+ *         message. The receive path is the only writer. Readers use the sequence
+ *         counter as a seqlock: it is odd while the entry is being written, so readers
+ *         retry instead of ever blocking the receive path.
+ */
+struct cancomm_snapshot_entry
+{
+  /** \brief Key of the entry, zero if unused. Holds the interface index in the upper
+   *         32 bits and the kernel's CAN identifier, including CAN_EFF_FLAG, in the
+   *         lower 32 bits. Published after the entry's first write.
+   */
+  atomic_uint_fast64_t key;
+  /** \brief Sequence counter of the seqlock. */
+  atomic_uint seq;
+  /** \brief Number of CAN message data bytes. */
+  uint8_t  len;
+  /** \brief Bit flags of the frame. */
+  uint8_t  flags;
+  /** \brief Number of times that the CAN message was received. */
+  uint64_t count;
+  /** \brief Timestamp of the latest reception. */
+  uint64_t timestamp;
+  /** \brief Data bytes of the latest reception. */
+  uint8_t  data[CANCOMM_DATA_LEN_MAX];
+};
+
+/** \brief Snapshot table with the latest received frame of each CAN message. A flat
+ *         array with open addressing and linear probing. Entries are never removed,
+ *         so a lookup stops at the first unused entry.
+ */
+struct cancomm_snapshot
+{
+  /** \brief Number of entries in the array minus one. The number of entries is a power
+   *         of two and at least twice the maximum number of CAN messages, which keeps
+   *         the probe sequences short.
+   */
+  size_t mask;
+  /** \brief Maximum number of CAN messages in the table. */
+  size_t max;
+  /** \brief Number of CAN messages in the table. Only accessed by the writer. */
+  size_t used;
+  /** \brief The entries. Allocated together with the table. */
+  struct cancomm_snapshot_entry entries[];
+};
+
+/** \brief Transmit slot of the io_uring backend. Holds a copy of a frame, until the
+ *         kernel reports that the asynchronous transmission completed.
+ */
+struct cancomm_uring_tx
+{
+  /** \brief The frame to transmit. */
+  struct canfd_frame frame;
+  /** \brief Destination address of the frame. */
+  struct sockaddr_can addr;
+  /** \brief I/O vector that points to the frame. */
+  struct iovec iov;
+  /** \brief Message header for the send request. */
+  struct msghdr msg;
+};
+
+/** \brief State of the io_uring backend. The submission and completion queues are
+ *         shared with the kernel. Frames are received with a single multishot receive
+ *         request, that stays armed and stores each frame in one of the buffers that
+ *         the library provides to the kernel through a buffer ring.
+ */
+struct cancomm_uring
+{
+  /** \brief File descriptor of the io_uring instance. */
+  int fd;
+  /** \brief Mutex that serializes the access to the submission queue and to the
+   *         transmit slots, as any number of threads may transmit. The receiving
+   *         thread only takes it for re-arming the multishot receive request.
+   */
+  pthread_mutex_t sq_lock;
+  /** \brief Flag that is set while a thread processes the completion queue. Usually
+   *         the receiving thread does so, but a transmitting thread that runs short on
+   *         transmit slots does as well. A thread that finds the flag set, skips it.
+   */
+  atomic_bool cq_busy;
+  /** \brief Memory mapping of the submission queue ring. */
+  void * sq_map;
+  /** \brief Size of the memory mapping of the submission queue ring. */
+  size_t sq_map_size;
+  /** \brief Memory mapping of the completion queue ring. Same as sq_map, if the kernel
+   *         maps both rings at once.
+   */
+  void * cq_map;
+  /** \brief Size of the memory mapping of the completion queue ring. */
+  size_t cq_map_size;
+  /** \brief Array with the submission queue entries. */
+  struct io_uring_sqe * sqes;
+  /** \brief Size of the memory mapping of the submission queue entries. */
+  size_t sqes_size;
+  /** \brief Pointers into the submission queue ring. */
+  uint32_t * sq_head;
+  uint32_t * sq_tail;
+  uint32_t * sq_array;
+  uint32_t   sq_mask;
+  uint32_t   sq_entries;
+  /** \brief Local copy of the submission queue tail, including the queued entries that
+   *         were not yet published to the kernel.
+   */
+  uint32_t   sq_tail_local;
+  /** \brief Pointers into the completion queue ring. */
+  uint32_t * cq_head;
+  uint32_t * cq_tail;
+  uint32_t   cq_mask;
+  struct io_uring_cqe * cqes;
+  /** \brief Boolean flag to determine if the multishot receive request is armed. */
+  atomic_bool rx_armed;
+  /** \brief Message header template for the multishot receive request. */
+  struct msghdr rx_msg;
+  /** \brief Memory mapping with the buffer ring, followed by the receive buffers. */
+  uint8_t * rx_map;
+  /** \brief Buffer ring for providing the receive buffers to the kernel. */
+  struct io_uring_buf_ring * buf_ring;
+  /** \brief Local copy of the tail index of the buffer ring. */
+  uint16_t buf_tail;
+  /** \brief FIFO with the identifiers of the receive buffers that hold a received
+   *         frame, which was not yet read by the application.
+   */
+  uint16_t rx_pending[CANCOMM_URING_RX_BUFS];
+  /** \brief Free running read and write indices of the rx_pending FIFO. Only the
+   *         receiving thread reads from the FIFO. The thread that processes the 
+   *         completion queue writes to it.
+   */
+  uint32_t    rx_pending_head;
+  atomic_uint rx_pending_tail;
+  /** \brief Transmit slots. */
+  struct cancomm_uring_tx tx[CANCOMM_URING_TX_SLOTS];
+  /** \brief Stack with the indices of the free transmit slots. */
+  uint16_t tx_free[CANCOMM_URING_TX_SLOTS];
+  /** \brief Number of entries on the tx_free stack. */
+  uint32_t tx_free_cnt;
+  /** \brief FIFO with the indices of the transmit slots, whose transmission completed.
+   *         The thread that processes the completion queue writes to it. The 
+   *         transmitting threads move them back to the tx_free stack.
+   */
+  uint16_t tx_done[CANCOMM_URING_TX_SLOTS];
+  /** \brief Free running read and write indices of the tx_done FIFO. */
+  uint32_t    tx_done_head;
+  atomic_uint tx_done_tail;
+  /** \brief Number of asynchronous transmissions that the kernel reported as failed. */
+  atomic_uint_fast64_t tx_errors;
+};
+
+/** \brief Structure with a frame that was prepared for repeated transmission. Basically
+ *         the non-opaque counter part of cancomm_prepared_t.
+ */
+struct cancomm_prepared
+{
+  /** \brief The frame, as passed to the kernel. */
+  struct canfd_frame frame;
+  /** \brief Number of bytes of the frame to pass to the kernel. */
+  size_t size;
+  /** \brief Destination address of the frame. Only used when the frame does not go to
+   *         the device that the socket is bound to.
+   */
+  struct sockaddr_can addr;
+  /** \brief I/O vector that points to the frame. */
+  struct iovec iov;
+  /** \brief Message header for passing the frame to the kernel. */
+  struct msghdr msg;
+};
+
+/** \brief Structure with an ISO-TP channel. Basically the non-opaque counter part of
+ *         cancomm_isotp_t.
+ */
+struct cancomm_isotp
+{
+  /** \brief CAN ISO-TP socket handle. */
+  int fd;
+  /** \brief Duplicate of the shutdown event file descriptor of the context that
+   *         opened the channel. It keeps waking up the blocking calls on the channel
+   *         after the context disconnects and closes its own descriptor.
+   */
+  int shutdown_fd;
+};
+
+/** \brief Fixed size record with a single frame in a recording file. All members are
+ *         stored in the byte order of the host.
+ */
+struct cancomm_record
+{
+  /** \brief Timestamp of the frame, in the unit of the timestamp mode in the header. */
+  uint64_t timestamp;
+  /** \brief CAN message identifier. */
+  uint32_t id;
+  /** \brief Interface index of the CAN device that the frame was received on. */
+  uint32_t ifindex;
+  /** \brief CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for 29-bit. */
+  uint8_t  ext;
+  /** \brief Number of data bytes. */
+  uint8_t  len;
+  /** \brief Bit flags (CANCOMM_FLAG_xxx). */
+  uint8_t  flags;
+  /** \brief Reserved for future use. Always zero. */
+  uint8_t  reserved[5];
+  /** \brief Data bytes. */
+  uint8_t  data[CANCOMM_DATA_LEN_MAX];
+};
+
+/** \brief Name of a CAN device in the header of a recording file. */
+struct cancomm_record_device
+{
+  /** \brief Interface index of the CAN device. */
+  uint32_t ifindex;
+  /** \brief Zero terminated name of the CAN device. */
+  char     name[IF_NAMESIZE];
+};
+
+/** \brief Header at the start of a recording file. */
+struct cancomm_record_header
+{
+  /** \brief File identification (CANCOMM_RECORD_MAGIC), without zero termination. */
+  char     magic[8];
+  /** \brief Version of the file format (CANCOMM_RECORD_VERSION). */
+  uint32_t version;
+  /** \brief Size of a single record in bytes. */
+  uint32_t record_size;
+  /** \brief Number of valid records in the file. Updated after each written batch. */
+  uint64_t record_count;
+  /** \brief Sequence number of the file within the recording, starting at zero. */
+  uint64_t sequence;
+  /** \brief Time of creation of the file, in seconds since the epoch. */
+  uint64_t created;
+  /** \brief Timestamp mode of the frames (CANCOMM_TIMESTAMP_xxx). */
+  uint32_t timestamp_mode;
+  /** \brief Number of entries in the devices array. */
+  uint32_t devices_cnt;
+  /** \brief Names of the CAN devices that the frames were received on. */
+  struct cancomm_record_device devices[CANCOMM_RECORD_DEVICES_MAX];
+};
+
+_Static_assert(sizeof(struct cancomm_record_header) <= CANCOMM_RECORD_HEADER_SIZE,
+               "recording file header does not fit in its reserved space");
+
+/** \brief Structure with the info of a recording file that is mapped for reading. */
+struct cancomm_recording_map
+{
+  /** \brief Pointer to the memory mapping of the file. */
+  void * map;
+  /** \brief Size of the memory mapping. */
+  size_t size;
+  /** \brief Pointer to the header of the file, inside the memory mapping. */
+  struct cancomm_record_header const * header;
+  /** \brief Pointer to the records of the file, inside the memory mapping. */
+  struct cancomm_record const * records;
+  /** \brief Number of valid records. */
+  uint64_t count;
+};
+
+/** \brief Structure with the state of a recorder. Basically the non-opaque counter part
+ *         of cancomm_recorder_t.
+ */
+struct cancomm_recorder
+{
+  /** \brief CAN communication context that the recorder captures frames from. */
+  struct cancomm_ctx * ctx;
+  /** \brief Base path of the recording files. Memory is allocated dynamically. */
+  char * path;
+  /** \brief Number of records that fit in a single file. */
+  uint64_t records_max;
+  /** \brief Number of files to rotate through. */
+  uint32_t file_count;
+  /** \brief Interval in nanoseconds for starting the write back of recorded data. */
+  uint64_t sync_interval;
+  /** \brief Sequence number of the current file. */
+  uint64_t sequence;
+  /** \brief File descriptor of the current file. -1 if not open. */
+  int fd;
+  /** \brief Size of the memory mapping of the current file. */
+  size_t map_size;
+  /** \brief Pointer to the memory mapping of the current file. */
+  uint8_t * map;
+  /** \brief Pointer to the header of the current file, inside the memory mapping. */
+  struct cancomm_record_header * header;
+  /** \brief Pointer to the records of the current file, inside the memory mapping. */
+  struct cancomm_record * records;
+  /** \brief Number of records, of which the write back was started. */
+  uint64_t records_synced;
+  /** \brief Time (CLOCK_MONOTONIC nanoseconds) at which the write back was last 
+   *         started.
+   */
+  uint64_t sync_time;
+  /** \brief Storage for the frames of cancomm_recorder_capture(). */
+  cancomm_frame_t frames[CANCOMM_RECORDER_BATCH_SIZE];
+};
+
+/** \brief Route of a forwarder, compiled for applying it to the received frames. */
+struct cancomm_forwarder_route
+{
+  /** \brief Interface index of the CAN device to forward the frames from. */
+  uint32_t src_ifindex;
+  /** \brief Interface index of the CAN device to forward the frames to. */
+  uint32_t dst_ifindex;
+  /** \brief Key of the route in the hash table, as constructed by 
+   *         cancomm_frame_key(). Zero if the route's filter does not select a single
+   *         CAN identifier, in which case the route is matched by scanning.
+   */
+  uint64_t key;
+  /** \brief Filter in the format of the kernel. Passes all frames if the route has no
+   *         filter.
+   */
+  struct can_filter filter;
+  /** \brief CANCOMM_FLAG_CANFD_MSG if the route forwards CAN FD frames, zero if it
+   *         forwards CAN classic frames.
+   */
+  uint8_t  fd_flag;
+  /** \brief Modifications, indexed by their operation (CANCOMM_GW_OP_xxx). */
+  cancomm_gw_mod_t mods[CANCOMM_GW_OPS];
+  /** \brief XOR checksum. */
+  cancomm_gw_csum_t csum_xor;
+  /** \brief CRC8 checksum. */
+  cancomm_gw_csum_t csum_crc8;
+  /** \brief Lookup table of the CRC8 checksum, for its polynomial. */
+  uint8_t  crc8_table[256];
+  /** \brief Index plus one of the next route with the same key. Zero if none. */
+  uint32_t next;
+};
+
+/** \brief Entry of the hash table of a forwarder. */
+struct cancomm_forwarder_bucket
+{
+  /** \brief Key of the entry, zero if unused. */
+  uint64_t key;
+  /** \brief Index plus one of the first route with this key. */
+  uint32_t route;
+};
+
+/** \brief Structure with a forwarder. Basically the non-opaque counter part of 
+ *         cancomm_forwarder_t. Routes that select a single CAN identifier are found
+ *         through a hash table with open addressing and linear probing. The other 
+ *         routes are matched by scanning them.
+ */
+struct cancomm_forwarder
+{
+  /** \brief CAN communication context that the forwarder receives and transmits on. */
+  struct cancomm_ctx * ctx;
+  /** \brief The compiled routes. Memory is allocated dynamically. */
+  struct cancomm_forwarder_route * routes;
+  /** \brief Indices of the routes that are matched by scanning. Memory is allocated
+   *         dynamically.
+   */
+  uint32_t * scan;
+  /** \brief Number of entries in the scan array. */
+  size_t scan_cnt;
+  /** \brief Entries of the hash table. Memory is allocated dynamically. */
+  struct cancomm_forwarder_bucket * buckets;
+  /** \brief Number of entries of the hash table minus one. The number of entries is a 
+   *         power of two and at least twice the number of keys.
+   */
+  size_t buckets_mask;
+  /** \brief Storage for the received frames. */
+  cancomm_frame_t rx_frames[CANCOMM_FORWARDER_BATCH_SIZE];
+  /** \brief Storage for the frames to transmit. */
+  cancomm_frame_t tx_frames[CANCOMM_FORWARDER_BATCH_SIZE];
+  /** \brief Number of frames in the tx_frames array. */
+  size_t tx_cnt;
+};
+
+/** \brief Structure with the counters of the statistics of a context. Updated with
+ *         relaxed atomic operations, such that the background reader thread can update
+ *         them, while another thread reads them.
+ */
+struct cancomm_stats_counters
+{
+  /** \brief Number of received frames that were handed over to the application. */
+  atomic_uint_fast64_t rx_frames;
+  /** \brief Number of received frames that were discarded, because they were invalid.
+   *         For example remote frames or frames with an unexpected size.
+   */
+  atomic_uint_fast64_t rx_dropped;
+  /** \brief Number of receive attempts that found no frames to read. */
+  atomic_uint_fast64_t rx_empty;
+  /** \brief Number of frames that the kernel dropped, because the receive queue of the
+   *         socket was full.
+   */
+  atomic_uint_fast64_t rx_overflows;
+  /** \brief Number of frames that were submitted for transmission. */
+  atomic_uint_fast64_t tx_frames;
+  /** \brief Number of transmit attempts that failed, because the transmit queue was
+   *         full.
+   */
+  atomic_uint_fast64_t tx_queue_full;
+  /** \brief Number of transmit attempts that failed for another reason. */
+  atomic_uint_fast64_t tx_errors;
+};
+
+/** \brief Structure with a routing netlink request about a single CAN device or about
+ *         a CAN gateway route.
+ */
+struct cancomm_link_msg
+{
+  /** \brief Netlink message header. */
+  struct nlmsghdr  nlh;
+  union
+  {
+    /** \brief Link information header, for requests about a CAN device. */
+    struct ifinfomsg ifm;
+    /** \brief CAN gateway header, for requests about a CAN gateway route. */
+    struct rtcanmsg  rtcan;
+  };
+  /** \brief Space for the attributes of the request. */
+  char             attrs[CANCOMM_LINK_ATTRS_SIZE];
+};
+
 /** \brief Structure for grouping all CAN communication context related data. Basically
  *         the non-opaque counter part of cancomm_t.
  */
@@ -62,27 +639,328 @@ struct cancomm_ctx
    *         internally. CANCOMM_INVALID_SOCKET if not connected, any other value if
    *         connected.
    */
-  uint32_t socket;
+  int      socket;
   /** \brief Boolean flag to determine if the CAN device is CAN classic or CAN FD. */
   uint8_t  fd_enabled;
-  /** \brief System time at which this module connected to the CAN network. Used to
-   *         calculated zero based CAN message timestamps.
+  /** \brief Boolean flag to determine if launch times (SO_TXTIME) are enabled on the
+   *         socket. Atomic, because multiple transmitting threads may enable them.
+   */
+  atomic_bool txtime_enabled;
+  /** \brief Boolean flag that cancomm_shutdown() sets to stop the receivers and
+   *         transmitters. Cleared upon connect.
+   */
+  atomic_bool shutdown_requested;
+  /** \brief Event file descriptor that becomes readable upon cancomm_shutdown(), for
+   *         waking up the threads that sleep in a blocking call. -1 if not connected.
+   */
+  int      shutdown_fd;
+  /** \brief Interface index that the socket is bound to. Zero when bound to all CAN
+   *         devices, which is the case when connected to a set of devices.
+   */
+  uint32_t ifindex;
+  /** \brief Interface index of the CAN device used for transmission, unless a frame
+   *         specifies otherwise. Zero if there is no default device.
+   */
+  uint32_t tx_ifindex;
+  /** \brief Number of entries in the rx_ifindexes array. Zero if frames from all CAN
+   *         devices are accepted.
+   */
+  uint32_t rx_ifindexes_cnt;
+  /** \brief Pointer to an array with the interface indices of the CAN devices, from
+   *         which received frames are accepted. Memory is allocated dynamically and
+   *         kept upon disconnect, such that a reconnect can reuse it.
+   */
+  uint32_t * rx_ifindexes;
+  /** \brief Number of interface indices that the rx_ifindexes array holds. */
+  uint32_t rx_ifindexes_capacity;
+  /** \brief Time (nanoseconds) of the configured clock at which this module connected
+   *         to the CAN network. Used to calculated zero based CAN message timestamps.
    */
   uint64_t connectTime;
+  /** \brief Configured timestamp mode (CANCOMM_TIMESTAMP_xxx). Applied upon connect. */
+  uint32_t opt_timestamp;
+  /** \brief Identifier of the clock for timestamps (CLOCK_xxx). Applied upon connect. */
+  clockid_t opt_clock;
+  /** \brief Configured receive backend (CANCOMM_BACKEND_xxx). Applied upon connect. */
+  uint32_t opt_backend;
+  /** \brief Configured size of the socket's send buffer in bytes. Zero for the default
+   *         of the kernel. Applied upon connect.
+   */
+  uint32_t opt_sndbuf;
+  /** \brief Configured size of the socket's receive buffer in bytes. Zero for the
+   *         default of the kernel. Applied upon connect.
+   */
+  uint32_t opt_rcvbuf;
+  /** \brief Configured number of frames that cancomm_receive_batch_timeout() waits
+   *         for. Zero or one to not wait for more than one frame.
+   */
+  uint32_t opt_coalesce_frames;
+  /** \brief Configured time in microseconds that cancomm_receive_batch_timeout() waits
+   *         for more frames, after the first one arrived.
+   */
+  uint32_t opt_coalesce_us;
+  /** \brief Configured time in microseconds that cancomm_replay() queues the frames
+   *         ahead of their launch time. Zero to sleep until each frame is due.
+   */
+  uint32_t opt_replay_txtime_us;
+  /** \brief Estimated time in nanoseconds between the arrival of two frames, as
+   *         measured by cancomm_receive_batch_timeout(). Zero if not yet known. Only
+   *         accessed by the thread that receives the frames.
+   */
+  uint64_t coalesce_interval;
+  /** \brief Packet socket handle of the packet mmap backend. -1 if not used. */
+  int pkt_fd;
+  /** \brief Pointer to the memory mapped ring of the packet mmap backend. */
+  uint8_t * pkt_map;
+  /** \brief Index of the block in the memory mapped ring to read from next. */
+  uint32_t pkt_block_idx;
+  /** \brief Number of frames in the current block that were not yet read. */
+  uint32_t pkt_pkts_left;
+  /** \brief Pointer to the next frame to read in the current block. */
+  uint8_t * pkt_current;
+  /** \brief Pointer to the state of the io_uring backend. NULL if not used. */
+  struct cancomm_uring * uring;
+  /** \brief Socket handle of the broadcast manager (CAN_BCM). Opened upon first use.
+   *         -1 if not open.
+   */
+  int bcm_fd;
+  /** \brief Socket handle for the transactions of cancomm_transact(). Opened upon first
+   *         use. -1 if not open.
+   */
+  int txn_fd;
+  /** \brief Interface index of the CAN device that the transaction socket is bound to. */
+  uint32_t txn_ifindex;
+  /** \brief Boolean flag to determine if acceptance filters were configured. If not, 
+   *         all CAN messages are received.
+   */
+  uint8_t  filters_set;
+  /** \brief Number of configured acceptance filters. */
+  uint32_t filters_cnt;
+  /** \brief Pointer to an array with the configured acceptance filters, in the format
+   *         of the kernel. Memory is allocated dynamically and only grows.
+   */
+  struct can_filter * filters;
+  /** \brief Number of acceptance filters that the filters array holds. */
+  uint32_t filters_capacity;
+  /** \brief Bit mask with the CAN error frame classes to receive. */
+  uint32_t err_mask;
+  /** \brief Pointer to the ring buffer that the background reader thread fills. NULL
+   *         if the background reader is not running.
+   */
+  struct cancomm_ring * ring;
+  /** \brief Pointer to a ring buffer that is allocated, but not in use. The background
+   *         reader keeps its ring here upon stop and reuses it upon the next start, if
+   *         large enough. NULL if there is none.
+   */
+  struct cancomm_ring * ring_spare;
+  /** \brief Boolean flag to determine if the context's memory was allocated by
+   *         cancomm_new(), as opposed to provided by the caller to cancomm_init().
+   */
+  uint8_t  ctx_allocated;
+  /** \brief Pointer to the snapshot table with the latest received frame of each CAN
+   *         message. NULL if not enabled.
+   */
+  struct cancomm_snapshot * snapshot;
+  /** \brief Handle of the background reader thread. */
+  pthread_t reader_thread;
+  /** \brief Event file descriptor for waking up the background reader thread. */
+  int reader_wakefd;
   /** \brief Holds the number of CAN devices that were detected on the system. */
   uint32_t devices_cnt;
   /** \brief Pointer to an array of strings with the names of CAN devices that were
    *         detected on the system. Memory is allocated dynamically.
    */
   char * devices_list;
+  /** \brief Pointer to an array with the interface indices of the CAN devices, in the
+   *         same order as the names. Identifies a device, even when it gets renamed.
+   */
+  uint32_t * devices_ifindexes;
+  /** \brief Number of CAN devices that the allocated arrays hold. */
+  uint32_t devices_capacity;
+  /** \brief Routing netlink socket that receives the notifications about appearing and
+   *         disappearing CAN devices. -1 if the monitor does not run.
+   */
+  int devices_monitor_fd;
+  /** \brief Routing netlink socket for configuring CAN devices and for querying their
+   *         bus state. Opened upon the first request. -1 if not open.
+   */
+  int link_fd;
+  /** \brief Sequence number of the last request on the routing netlink socket. */
+  uint32_t link_seq;
+  /** \brief Counters of the statistics, as obtained with cancomm_get_stats(). */
+  struct cancomm_stats_counters stats;
+  /** \brief Number of dropped frames that the kernel last reported for the socket. The
+   *         kernel reports a running total, of which the increase gets counted.
+   */
+  uint32_t rxq_drops;
 };
 
 
 /****************************************************************************************
 * Function prototypes
 ****************************************************************************************/
-static uint8_t cancomm_devices_is_can(char const * name);
-static uint8_t cancomm_sanitize_frame_len(uint8_t len);
+static void    cancomm_ctx_setup(struct cancomm_ctx * ctx);
+static uint8_t cancomm_ifindexes_reserve(struct cancomm_ctx * ctx, size_t capacity);
+static uint8_t cancomm_filters_reserve(struct cancomm_ctx * ctx, size_t capacity);
+static struct cancomm_ring * cancomm_ring_alloc(size_t slotCnt);
+static void    cancomm_ring_release(struct cancomm_ctx * ctx, struct cancomm_ring * ring);
+static uint8_t cancomm_devices_dump(struct cancomm_ctx * ctx);
+static uint8_t cancomm_devices_apply(struct cancomm_ctx * ctx, 
+                                     struct nlmsghdr const * nlh);
+static uint8_t cancomm_devices_reserve(struct cancomm_ctx * ctx, uint32_t capacity);
+static void    cancomm_link_msg_init(struct cancomm_link_msg * msg, uint16_t type, 
+                                     char const * device);
+static struct rtattr * cancomm_link_attr_add(struct cancomm_link_msg * msg, 
+                                             uint16_t type, void const * data, 
+                                             size_t len);
+static void    cancomm_link_attr_end(struct cancomm_link_msg * msg, struct rtattr * nest);
+static uint8_t cancomm_link_request(struct cancomm_ctx * ctx, 
+                                    struct cancomm_link_msg * msg, void * buf, 
+                                    size_t size, struct nlmsghdr const ** reply);
+static uint8_t cancomm_link_query(struct cancomm_ctx * ctx, char const * device,
+                                  cancomm_link_config_t * config, 
+                                  cancomm_link_state_t * state);
+static void    cancomm_link_parse(struct nlmsghdr const * nlh, 
+                                  cancomm_link_config_t * config, 
+                                  cancomm_link_state_t * state);
+static void    cancomm_link_parse_data(struct rtattr const * data, 
+                                       cancomm_link_config_t * config, 
+                                       cancomm_link_state_t * state);
+static void    cancomm_gw_msg_init(struct cancomm_link_msg * msg, uint16_t type, 
+                                uint8_t flags);
+static uint8_t cancomm_gw_msg_build(struct cancomm_link_msg * msg, uint16_t type,
+                                    cancomm_gw_route_t const * route);
+static void    cancomm_gw_mod_attr_add(struct cancomm_link_msg * msg, uint32_t op, 
+                                       cancomm_gw_mod_t const * mod, uint8_t fd);
+static canid_t cancomm_gw_mod_id(uint32_t op, cancomm_gw_mod_t const * mod);
+static uint32_t cancomm_gw_op(uint32_t op, uint32_t value, uint32_t operand);
+static void    cancomm_gw_crc8_table(uint8_t poly, uint8_t * table);
+static uint8_t cancomm_gw_csum_valid(cancomm_gw_csum_t const * csum, uint8_t lenMax);
+static void    cancomm_gw_csum_apply(cancomm_gw_csum_t const * csum, 
+                                     uint8_t const * crc8Table, uint8_t * data, 
+                                     uint8_t len);
+static uint8_t cancomm_forwarder_compile(cancomm_gw_route_t const * route,
+                                         struct cancomm_forwarder_route * compiled);
+static struct cancomm_forwarder_bucket * cancomm_forwarder_find(
+  struct cancomm_forwarder * forwarder, uint64_t key);
+static void    cancomm_forwarder_route(struct cancomm_forwarder * forwarder,
+                                       struct cancomm_forwarder_route const * route,
+                                       cancomm_frame_t const * frame,
+                                       struct timespec const * deadline,
+                                       size_t * forwarded);
+static void    cancomm_forwarder_flush(struct cancomm_forwarder * forwarder,
+                                       struct timespec const * deadline,
+                                       size_t * forwarded);
+static void    cancomm_filter_convert(cancomm_filter_t const * filter, 
+                                      struct can_filter * canFilter);
+static uint8_t cancomm_filters_apply(struct cancomm_ctx const * ctx);
+static uint8_t cancomm_frames_send(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                   size_t count, size_t * sent, uint8_t scheduled);
+static uint8_t cancomm_txtime_enable(struct cancomm_ctx * ctx);
+static void    cancomm_buffers_apply(struct cancomm_ctx const * ctx);
+static void    cancomm_stats_add(atomic_uint_fast64_t * counter, uint64_t value);
+static void    cancomm_stats_tx(struct cancomm_ctx * ctx, size_t sent, uint8_t result,
+                                 uint8_t queueFull);
+static void    cancomm_stats_packet_drops(struct cancomm_ctx * ctx);
+static uint8_t cancomm_tx_queue_full(void);
+static uint8_t cancomm_frame_pack(struct cancomm_ctx const * ctx, uint32_t id, 
+                                  uint8_t ext, uint8_t len, uint8_t const * data, 
+                                  uint8_t flags, struct canfd_frame * raw, size_t * size);
+static void    cancomm_timestamping_enable(struct cancomm_ctx const * ctx, 
+                                           char const * const * devices, size_t count);
+static uint8_t cancomm_device_probe(int canSocket, char const * device, 
+                                    uint32_t * ifindex, int32_t * mtu);
+static uint8_t cancomm_filters_match(struct cancomm_ctx const * ctx, canid_t canId);
+static uint8_t cancomm_ifindex_accepted(struct cancomm_ctx const * ctx, 
+                                        uint32_t ifindex);
+static uint8_t cancomm_txn_open(struct cancomm_ctx * ctx, uint32_t ifindex);
+static void    cancomm_txn_close(struct cancomm_ctx * ctx);
+static uint64_t cancomm_frame_key(uint32_t id, uint8_t ext, uint32_t ifindex);
+static struct cancomm_snapshot_entry * cancomm_snapshot_find(
+  struct cancomm_snapshot * snapshot, uint64_t key, uint8_t insert);
+static void    cancomm_snapshot_update(struct cancomm_ctx * ctx, 
+                                       cancomm_frame_t const * frames, size_t count);
+static size_t  cancomm_raw_receive(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                   size_t max);
+static uint8_t cancomm_packet_open(struct cancomm_ctx * ctx, uint32_t ifindex);
+static void    cancomm_packet_close(struct cancomm_ctx * ctx);
+static size_t  cancomm_packet_receive(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                      size_t max);
+static int     cancomm_rx_fd(struct cancomm_ctx const * ctx);
+static uint8_t cancomm_uring_open(struct cancomm_ctx * ctx);
+static void    cancomm_uring_close(struct cancomm_ctx * ctx);
+static struct io_uring_sqe * cancomm_uring_get_sqe(struct cancomm_uring * uring);
+static uint8_t cancomm_uring_submit(struct cancomm_uring * uring, uint32_t flags);
+static uint8_t cancomm_uring_arm(struct cancomm_ctx * ctx);
+static void    cancomm_uring_recycle(struct cancomm_uring * uring, uint16_t bid);
+static uint32_t cancomm_uring_reap(struct cancomm_uring * uring);
+static size_t  cancomm_uring_receive(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                     size_t max);
+static size_t  cancomm_uring_transmit(struct cancomm_ctx * ctx, 
+                                      struct mmsghdr const * msgs, size_t count);
+static uint8_t cancomm_bcm_open(struct cancomm_ctx * ctx);
+static void    cancomm_bcm_close(struct cancomm_ctx * ctx);
+static uint32_t cancomm_bcm_tx_ifindex(struct cancomm_ctx const * ctx, 
+                                       cancomm_frame_t const * frame);
+static uint8_t cancomm_bcm_send(struct cancomm_ctx * ctx, uint32_t opcode, 
+                                uint32_t flags, uint32_t count, uint32_t ival1_us, 
+                                uint32_t ival2_us, cancomm_frame_t const * frame,
+                                uint32_t ifindex);
+static void *  cancomm_reader_thread(void * arg);
+static uint64_t cancomm_timestamp_convert(struct cancomm_ctx const * ctx, 
+                                          uint64_t systemTime);
+static uint64_t cancomm_timestamp_from_cmsg(struct cancomm_ctx * ctx,
+                                            struct msghdr const * msg, 
+                                            int64_t clockOffset);
+static uint64_t cancomm_timestamp_now(struct cancomm_ctx const * ctx);
+static uint8_t cancomm_clock_read(struct cancomm_ctx const * ctx, uint64_t * now);
+static int64_t cancomm_clock_offset(struct cancomm_ctx const * ctx);
+static void    cancomm_deadline_init(struct timespec * deadline, uint32_t timeout_us);
+static uint64_t cancomm_monotonic_ns(void);
+static uint8_t cancomm_wait_event(struct cancomm_ctx const * ctx, short events,
+                                  struct timespec const * deadline);
+static uint8_t cancomm_wait_fd(int fd, int wakeFd, short events, 
+                               struct timespec const * deadline);
+static uint8_t cancomm_tx_space_wait(struct cancomm_ctx const * ctx, 
+                                     struct timespec const * deadline);
+static uint8_t cancomm_recorder_file_open(struct cancomm_recorder * recorder);
+static void    cancomm_recorder_file_close(struct cancomm_recorder * recorder, 
+                                           uint8_t final);
+static void    cancomm_recorder_sync(struct cancomm_recorder * recorder);
+static void    cancomm_recorder_device_add(struct cancomm_record_header * header, 
+                                           uint32_t ifindex);
+static uint32_t cancomm_export_device(struct cancomm_record_header const * header,
+                                      uint32_t ifindex);
+static uint64_t cancomm_export_time_us(struct cancomm_record_header const * header,
+                                       uint64_t timestamp);
+static void    cancomm_export_candump(FILE * logFile, 
+                                      struct cancomm_record_header const * header,
+                                      struct cancomm_record const * records, 
+                                      uint64_t count);
+static void    cancomm_export_asc(FILE * logFile, 
+                                  struct cancomm_record_header const * header,
+                                  struct cancomm_record const * records, uint64_t count);
+static uint8_t cancomm_recording_open(char const * path, 
+                                      struct cancomm_recording_map * recordingMap);
+static void    cancomm_recording_close(struct cancomm_recording_map * recordingMap);
+static uint64_t cancomm_recording_time_ns(struct cancomm_record_header const * header,
+                                          uint64_t timestamp);
+static uint64_t cancomm_replay_deadline(struct cancomm_recording_map const * recordingMap,
+                                        struct cancomm_record const * record,
+                                        uint64_t startTime, uint64_t firstTimestamp,
+                                        uint32_t speed);
+static uint8_t cancomm_replay_send(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                   size_t count, uint64_t * sent, uint8_t scheduled);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Flag that tells if the last transmit function, that the thread called, failed
+ *         because the transmit queue was full. Thread local, such that any number of 
+ *         threads can transmit on the same context and query it afterwards.
+ */
+static _Thread_local uint8_t cancomm_tx_queue_full_flag = CANCOMM_FALSE;
 
 
 /************************************************************************************//**
@@ -103,11 +981,8 @@ cancomm_t cancomm_new(void)
   if (newCtx != NULL)
   {
     /* Initialize the context members. */
-    newCtx->socket = CANCOMM_INVALID_SOCKET;
-    newCtx->fd_enabled = CANCOMM_FALSE;
-    newCtx->connectTime = 0;
-    newCtx->devices_cnt = 0;
-    newCtx->devices_list = NULL;
+    cancomm_ctx_setup(newCtx);
+    newCtx->ctx_allocated = CANCOMM_TRUE;
     /* Update the result. */
     result = (cancomm_t)newCtx;
   }
@@ -118,71 +993,93 @@ cancomm_t cancomm_new(void)
 
 
 /************************************************************************************//**
-** \brief     Releases the context. Should be called for each CAN communication
-**            context, created with function cancomm_new(), once you no longer need it.
-** \param     ctx CAN communication context.
+** \brief     Obtains the number of bytes that the storage of a CAN communication
+**            context needs, for creating a context in caller provided storage with
+**            cancomm_init().
+** \return    Size of a context in bytes.
 **
 ****************************************************************************************/
-void cancomm_free(cancomm_t ctx)
+size_t cancomm_ctx_size(void)
 {
-  struct cancomm_ctx * currentCtx;
+  /* Give the result back to the caller. */
+  return sizeof(struct cancomm_ctx);
+} /*** end of cancomm_ctx_size ***/
 
-  /* Verify parameter. */
-  assert(ctx != NULL);
 
-  /* Only continue with a valid parameter. */
-  if (ctx != NULL)
-  {
-    /* Cast the opaque pointer to its non-opaque counter part. */
-    currentCtx = (struct cancomm_ctx *)ctx;
+/************************************************************************************//**
+** \brief     Creates a new CAN communication context in caller provided storage, instead
+**            of allocating it on the heap like cancomm_new() does. Meant for real-time
+**            applications that do not allocate memory after startup. The storage must
+**            stay valid until cancomm_free() was called for the context, which releases
+**            everything but the storage itself.
+** \param     buffer Pointer to the storage for the context. Must be suitably aligned for
+**            any type, as memory from malloc() or a static array with
+**            alignas(max_align_t) is.
+** \param     size Size of the storage in bytes. Must be at least cancomm_ctx_size().
+** \return    Newly created context, if successful. NULL otherwise.
+**
+****************************************************************************************/
+cancomm_t cancomm_init(void * buffer, size_t size)
+{
+  cancomm_t result = NULL;
+  struct cancomm_ctx * newCtx;
 
-    /* Make sure to disconnect the CAN device. */
-    cancomm_disconnect(currentCtx);
-    /* Release memory allocated for the devices list. */
-    if (currentCtx->devices_list != NULL)
-    {
-      free(currentCtx->devices_list);
-      currentCtx->devices_list = NULL;
-      currentCtx->devices_cnt = 0;
-    }
+  /* Verify parameters. */
+  assert((buffer != NULL) && (size >= sizeof(struct cancomm_ctx)));
 
-    /* Release the context's allocated memory. */
-    free(currentCtx);
-    /* Reset the pointer to prevent a dangling pointer. */
-    currentCtx = NULL;
+  /* Only continue with valid parameters and properly aligned storage. */
+  if ((buffer != NULL) && (size >= sizeof(struct cancomm_ctx)) &&
+      (((uintptr_t)buffer % _Alignof(struct cancomm_ctx)) == 0))
+  {
+    /* Initialize the context members. */
+    newCtx = (struct cancomm_ctx *)buffer;
+    cancomm_ctx_setup(newCtx);
+    /* Update the result. */
+    result = (cancomm_t)newCtx;
   }
-} /*** end of cancomm_free ***/
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_init ***/
 
 
 /************************************************************************************//**
-** \brief     Connects to the specified SocketCAN device. Note that you can use the
-**            functions cancomm_devices_buildlist() and cancomm_devices_name() to
-**            determine the names of the SocketCAN devices known to the system. 
-**            Alternatively, you can run command "ip addr" in the terminal to find out
-**            about the SocketCAN devices know to the system.
-**            This function automatically figures out if the SocketCAN device supports
-**            CAN FD, in addition to CAN classic.
+** \brief     Allocates the internal buffers of the context up front, such that later
+**            calls do not need to allocate memory, as long as they stay within these
+**            sizes. This covers the list with CAN devices of cancomm_devices_buildlist()
+**            and its monitor, the interface indices of cancomm_connect_devices(), the
+**            acceptance filters of cancomm_set_filters() and the ring buffer of
+**            cancomm_reader_start(). The buffers only grow and are kept until
+**            cancomm_free(), also across a disconnect and reconnect. Buffers that the
+**            kernel maps upon connect, such as the rings of the packet mmap and io_uring
+**            backends, are set up by cancomm_connect() itself. Combined with
+**            cancomm_init() and mlockall(), nothing on the receive and transmit path
+**            allocates memory or page faults.
 ** \param     ctx CAN communication context.
-** \param     device Null terminated string with the SocketCAN device name, e.g. "can0".
-** \return    CANCOMM_TRUE if successfully connected to the SocketCAN device.
-**            CANCOMM_FALSE otherwise.
+** \param     devices Number of CAN devices to reserve space for, both for the devices
+**            list and for connecting to a set of CAN devices.
+** \param     filters Number of acceptance filters to reserve space for. Up to
+**            CANCOMM_FILTERS_MAX.
+** \param     ring_capacity Number of frames that the ring buffer of the background
+**            reader holds. Rounded up to the next power of two. Zero to not reserve it.
+**            The background reader only uses the reserved ring, if its capacity is not
+**            larger than this one.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
 **
 ****************************************************************************************/
-uint8_t cancomm_connect(cancomm_t ctx, char const * device)
+uint8_t cancomm_reserve(cancomm_t ctx, uint32_t devices, uint32_t filters, 
+                        uint32_t ring_capacity)
 {
   uint8_t result = CANCOMM_FALSE;
   struct cancomm_ctx * currentCtx;
-  struct sockaddr_can addr;
-  struct ifreq ifr;
-  int32_t flags;
-  int32_t deviceMtu;
-  struct timeval tv = { 0 };
+  struct cancomm_ring * ring;
+  size_t slotCnt = 1;
 
   /* Verify parameters. */
-  assert((ctx != NULL) && (device != NULL));
+  assert((ctx != NULL) && (filters <= CANCOMM_FILTERS_MAX));
 
-  /* Only continue with a valid parameters. */
-  if ((ctx != NULL) && (device != NULL))
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (filters <= CANCOMM_FILTERS_MAX))
   {
     /* Cast the opaque pointer to its non-opaque counter part. */
     currentCtx = (struct cancomm_ctx *)ctx;
@@ -190,131 +1087,54 @@ uint8_t cancomm_connect(cancomm_t ctx, char const * device)
     /* Set positive result at this point and negate upon error detection. */
     result = CANCOMM_TRUE;
 
-    /* Make sure we are not already connected to a CAN device. */
-    cancomm_disconnect(currentCtx);
-
-    /* Create an ifreq structure for passing data in and out of ioctl. */
-    strncpy(ifr.ifr_name, device, IFNAMSIZ - 1);
-    ifr.ifr_name[IFNAMSIZ - 1] = '\0';
-
-    /* Get current system time. */
-    if (gettimeofday(&tv, NULL) == 0)
-    {
-      /* Convert the current time to microseconds and store it as the connection start
-       * time. Needed for zero based timestamp. 
-       */
-      currentCtx->connectTime = ((int64_t)tv.tv_sec * 1000 * 1000ULL) +
-                               ((int64_t)tv.tv_usec);
-    }
-    else
+    /* Reserve the arrays. Each one leaves the current array as is upon failure. */
+    if ((cancomm_devices_reserve(currentCtx, devices) != CANCOMM_TRUE) ||
+        (cancomm_ifindexes_reserve(currentCtx, devices) != CANCOMM_TRUE) ||
+        (cancomm_filters_reserve(currentCtx, filters) != CANCOMM_TRUE))
     {
       result = CANCOMM_FALSE;
     }
 
-    if (result == CANCOMM_TRUE)
+    /* Reserve the ring buffer of the background reader, unless it is running or the
+     * spare one is already large enough.
+     */
+    if ((result == CANCOMM_TRUE) && (ring_capacity > 0) && (currentCtx->ring == NULL))
     {
-      /* Get open socket descriptor. */
-      if ((currentCtx->socket = socket(PF_CAN, (int)SOCK_RAW, CAN_RAW)) < 0)
+      while (slotCnt < ring_capacity)
       {
-        result = CANCOMM_FALSE;
+        slotCnt <<= 1;
       }
-    }
-
-    if (result == CANCOMM_TRUE)
-    {
-      /* Determine if the CAN device is configured for CAN classic or CAN FD mode. Do so
-       * by reading the MTU size of the CAN device. For CAN classic it will be CAN_MTU.
-       * For CAN FD it will be CANFD_MTU.
-       */
-      deviceMtu = CAN_MTU;
-      /* Attempt to read the MTU value from the CAN device. */
-      if (ioctl(currentCtx->socket, SIOCGIFMTU, &ifr) >= 0)
+      if ((currentCtx->ring_spare == NULL) || 
+          (currentCtx->ring_spare->slots_allocated < slotCnt))
       {
-        /* Only update the MTU value if it is a supported value. */
-        if ( (ifr.ifr_mtu == CAN_MTU) || (ifr.ifr_mtu == CANFD_MTU) )
+        ring = cancomm_ring_alloc(slotCnt);
+        if (ring != NULL)
         {
-          deviceMtu = ifr.ifr_mtu;
+          free(currentCtx->ring_spare);
+          currentCtx->ring_spare = ring;
         }
-      }
-      /* Use the MTU value to determine if the CAN device is operating in CAN classic or
-       * CAN FD mode. Note that the MTU value of the CAN device changes automatically to
-       * the value of CANFD_MTU, after the data bitrate was configured and the fd mode
-       * was turned on. Example:
-       *   ip link set can0 type can bitrate 500000 dbitrate 4000000 fd on
-       */
-      currentCtx->fd_enabled = (deviceMtu == CANFD_MTU) ? CANCOMM_TRUE : CANCOMM_FALSE;
-      
-      /* Attempt to switch socket into CAN FD mode, if the CAN device is configured for
-       * CAN FD.
-       */
-      if (currentCtx->fd_enabled == CANCOMM_TRUE)
-      {
-        int enable_canfd = 1;
-        if (setsockopt(currentCtx->socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, 
-            &enable_canfd, sizeof(enable_canfd)) != 0)
+        else
         {
-          /* Could not switch the socket into CAN FD mode. Fall back to CAN classic
-           * operation.
-           */
-          currentCtx->fd_enabled = CANCOMM_FALSE;
+          result = CANCOMM_FALSE;
         }
       }
     }
-
-    if (result == CANCOMM_TRUE)
-    {
-      /* Configure socket to work in non-blocking mode. */
-      flags = fcntl(currentCtx->socket, F_GETFL, 0);
-      if (flags == -1)
-      {
-        flags = 0;
-      }
-      if (fcntl(currentCtx->socket, F_SETFL, flags | O_NONBLOCK) == -1)
-      {
-        close(currentCtx->socket);
-        currentCtx->socket = CANCOMM_INVALID_SOCKET;
-        result = CANCOMM_FALSE;
-      }
-    }
-
-    if (result == CANCOMM_TRUE)
-    {
-      /* Obtain interface index. */
-      if (ioctl(currentCtx->socket, SIOCGIFINDEX, &ifr) < 0)
-      {
-        close(currentCtx->socket);
-        currentCtx->socket = CANCOMM_INVALID_SOCKET;
-        result = CANCOMM_FALSE;
-      }
-    }
-
-    if (result == CANCOMM_TRUE)
-    {
-      /* Set the address info. */
-      addr.can_family = AF_CAN;
-      addr.can_ifindex = ifr.ifr_ifindex;
-
-      /* Bind the socket. */
-      if (bind(currentCtx->socket, (struct sockaddr *)&addr, sizeof(addr)) < 0)
-      {
-        close(currentCtx->socket);
-        currentCtx->socket = CANCOMM_INVALID_SOCKET;
-        result = CANCOMM_FALSE;
-      }
-    }
-  }
+  }
 
   /* Give the result back to the caller. */
   return result;
-} /*** end of cancomm_connect ***/
+} /*** end of cancomm_reserve ***/
 
 
 /************************************************************************************//**
-** \brief     Disconnects from the SocketCAN device.
+** \brief     Releases the context. Should be called for each CAN communication
+**            context, created with function cancomm_new() or cancomm_init(), once you
+**            no longer need it. The storage of a context created with cancomm_init()
+**            stays with the caller.
 ** \param     ctx CAN communication context.
 **
 ****************************************************************************************/
-void cancomm_disconnect(cancomm_t ctx)
+void cancomm_free(cancomm_t ctx)
 {
   struct cancomm_ctx * currentCtx;
 
@@ -327,314 +1147,472 @@ void cancomm_disconnect(cancomm_t ctx)
     /* Cast the opaque pointer to its non-opaque counter part. */
     currentCtx = (struct cancomm_ctx *)ctx;
 
-    /* Only disconnect if actually connected. */
-    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    /* Make sure to disconnect the CAN device. */
+    cancomm_disconnect(currentCtx);
+    /* Close the routing netlink socket for the link requests. */
+    if (currentCtx->link_fd >= 0)
     {
-      close(currentCtx->socket);
-      currentCtx->socket = CANCOMM_INVALID_SOCKET;
+      close(currentCtx->link_fd);
+      currentCtx->link_fd = -1;
+    }
+    /* Stop the devices monitor. */
+    if (currentCtx->devices_monitor_fd >= 0)
+    {
+      close(currentCtx->devices_monitor_fd);
+      currentCtx->devices_monitor_fd = -1;
+    }
+    /* Release memory allocated for the devices list. */
+    if (currentCtx->devices_list != NULL)
+    {
+      free(currentCtx->devices_list);
+      currentCtx->devices_list = NULL;
+      currentCtx->devices_cnt = 0;
+    }
+    if (currentCtx->devices_ifindexes != NULL)
+    {
+      free(currentCtx->devices_ifindexes);
+      currentCtx->devices_ifindexes = NULL;
+    }
+    currentCtx->devices_capacity = 0;
+    /* Release memory allocated for the acceptance filters. */
+    if (currentCtx->filters != NULL)
+    {
+      free(currentCtx->filters);
+      currentCtx->filters = NULL;
+      currentCtx->filters_cnt = 0;
+    }
+    currentCtx->filters_capacity = 0;
+    /* Release memory allocated for the list of devices to receive from. */
+    if (currentCtx->rx_ifindexes != NULL)
+    {
+      free(currentCtx->rx_ifindexes);
+      currentCtx->rx_ifindexes = NULL;
+    }
+    currentCtx->rx_ifindexes_capacity = 0;
+    /* Release memory allocated for the spare ring buffer of the background reader. */
+    if (currentCtx->ring_spare != NULL)
+    {
+      free(currentCtx->ring_spare);
+      currentCtx->ring_spare = NULL;
+    }
+
+    /* Release memory allocated for the snapshot table. */
+    cancomm_snapshot_disable(currentCtx);
+
+    /* Release the context's allocated memory. Storage that the caller provided to
+     * cancomm_init() stays with the caller.
+     */
+    if (currentCtx->ctx_allocated == CANCOMM_TRUE)
+    {
+      free(currentCtx);
     }
+    /* Reset the pointer to prevent a dangling pointer. */
+    currentCtx = NULL;
   }
-} /*** end of cancomm_disconnect ***/
+} /*** end of cancomm_free ***/
 
 
 /************************************************************************************//**
-** \brief     Submits a CAN message for transmission.
+** \brief     Configures an option of the context. Options take effect the next time
+**            that cancomm_connect() is called.
 ** \param     ctx CAN communication context.
-** \param     id CAN message identifier.
-** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
-**            29-bit.
-** \param     len Number of CAN message data bytes.
-** \param     data Pointer to array with data bytes.
-** \param     flags Bit flags for providing additional information about how to transmit
-**            the message:
-**              CANCOMM_FLAG_CANFD_MSG - The message is CAN FD and not CAN classic. 
-**                                       Ignored for non CAN FD SocketCAN devices.
-** \param     timestamp Pointer to where the timestamp (microseconds) of the message is
-**            stored.
-** \return    CANCOMM_TRUE if successfully submitted the message for transmission.
-**            CANCOMM_FALSE otherwise.
+** \param     option The option to configure (CANCOMM_OPT_xxx).
+** \param     value The new value of the option:
+**              CANCOMM_OPT_TIMESTAMP - CANCOMM_TIMESTAMP_SW_US, CANCOMM_TIMESTAMP_SW_NS
+**                                      or CANCOMM_TIMESTAMP_HW_NS.
+**              CANCOMM_OPT_CLOCK     - CANCOMM_CLOCK_REALTIME, CANCOMM_CLOCK_MONOTONIC
+**                                      or CANCOMM_CLOCK_MONOTONIC_RAW.
+**              CANCOMM_OPT_COALESCE_FRAMES - Number of frames. Takes effect right away.
+**              CANCOMM_OPT_COALESCE_US     - Time in microseconds. Takes effect right 
+**                                            away.
+**              CANCOMM_OPT_REPLAY_TXTIME_US - Time in microseconds. Takes effect right
+**                                             away.
+** \return    CANCOMM_TRUE if successfully configured. CANCOMM_FALSE for an unknown option
+**            or an unsupported value.
 **
 ****************************************************************************************/
-uint8_t cancomm_transmit(cancomm_t ctx, uint32_t id, uint8_t ext, uint8_t len, 
-                         uint8_t const * data, uint8_t flags, uint64_t * timestamp)
+uint8_t cancomm_set_option(cancomm_t ctx, uint32_t option, uint32_t value)
 {
   uint8_t result = CANCOMM_FALSE;
   struct cancomm_ctx * currentCtx;
-  struct canfd_frame canTxFrame = { 0 };
-  struct timeval tv = { 0 };
-  uint8_t frameLenMax;
-  size_t frameSizeMax;
 
-  /* Verify parameters. */
-  assert((ctx != NULL) && (len <= CANFD_MAX_DLEN) && (data != NULL));
+  /* Verify parameter. */
+  assert(ctx != NULL);
 
-  /* Only continue with a valid parameters. */
-  if ((ctx != NULL) && (len <= CANFD_MAX_DLEN) && (data != NULL))
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
   {
     /* Cast the opaque pointer to its non-opaque counter part. */
     currentCtx = (struct cancomm_ctx *)ctx;
 
-    /* Only transmit if actually connected. */
-    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    /* Validate and store the option value. */
+    switch (option)
     {
-      /* Initialize the settings as if the message will be CAN classic. */
-      frameLenMax = CAN_MAX_DLEN;
-      frameSizeMax = CAN_MTU;
-      /* Should the message be transmitted as CAN FD? */
-      if ((currentCtx->fd_enabled) && (flags & CANCOMM_FLAG_CANFD_MSG))
-      {
-        /* Update the settings for the mesasge to be CAN FD. */
-        frameLenMax = CANFD_MAX_DLEN;
-        frameSizeMax = CANFD_MTU;
-        /* Configure the bit rate switch when transmitting messages in CAN FD mode. */
-        canTxFrame.flags |= CANFD_BRS;        
-      }
+      case CANCOMM_OPT_TIMESTAMP:
+        if ((value == CANCOMM_TIMESTAMP_SW_US) || (value == CANCOMM_TIMESTAMP_SW_NS) ||
+            (value == CANCOMM_TIMESTAMP_HW_NS))
+        {
+          currentCtx->opt_timestamp = value;
+          result = CANCOMM_TRUE;
+        }
+        break;
 
-      /* Only transmit if all the data actually fits. */
-      if (len <= frameLenMax)
-      {
-        /* Construct the transmit frame. */
-        canTxFrame.can_id = id;
-        if (ext == CANCOMM_TRUE)
+      case CANCOMM_OPT_CLOCK:
+        if (value == CANCOMM_CLOCK_REALTIME)
+        {
+          currentCtx->opt_clock = CLOCK_REALTIME;
+          result = CANCOMM_TRUE;
+        }
+        else if (value == CANCOMM_CLOCK_MONOTONIC)
         {
-          canTxFrame.can_id |= CAN_EFF_FLAG;
+          currentCtx->opt_clock = CLOCK_MONOTONIC;
+          result = CANCOMM_TRUE;
         }
-        /* Sanitize the frame length before storing it. */
-        canTxFrame.len = cancomm_sanitize_frame_len(len);
-        for (uint8_t idx = 0; idx < len; idx++)
+        else if (value == CANCOMM_CLOCK_MONOTONIC_RAW)
         {
-          canTxFrame.data[idx] = data[idx];
+          currentCtx->opt_clock = CLOCK_MONOTONIC_RAW;
+          result = CANCOMM_TRUE;
         }
+        break;
+
+      case CANCOMM_OPT_SNDBUF:
+        currentCtx->opt_sndbuf = value;
+        result = CANCOMM_TRUE;
+        break;
+
+      case CANCOMM_OPT_RCVBUF:
+        currentCtx->opt_rcvbuf = value;
+        result = CANCOMM_TRUE;
+        break;
+
+      case CANCOMM_OPT_COALESCE_FRAMES:
+        currentCtx->opt_coalesce_frames = value;
+        result = CANCOMM_TRUE;
+        break;
+
+      case CANCOMM_OPT_COALESCE_US:
+        currentCtx->opt_coalesce_us = value;
+        result = CANCOMM_TRUE;
+        break;
+
+      case CANCOMM_OPT_REPLAY_TXTIME_US:
+        currentCtx->opt_replay_txtime_us = value;
+        result = CANCOMM_TRUE;
+        break;
 
-        /* Request transmission of the frame. */
-        if (write(currentCtx->socket, &canTxFrame, frameSizeMax) == frameSizeMax)
+      case CANCOMM_OPT_BACKEND:
+        if ((value == CANCOMM_BACKEND_RAW) || (value == CANCOMM_BACKEND_PACKET_MMAP) ||
+            (value == CANCOMM_BACKEND_IO_URING))
         {
-          /* Get the timestamp of the transmit event. */
-          *timestamp = 0;
-          if (gettimeofday(&tv, NULL) == 0)
-          {
-            /* Convert the timestamp to microseconds. */
-            *timestamp = ((int64_t)tv.tv_sec * 1000 * 1000ULL) + ((int64_t)tv.tv_usec);
-            /* Make the timestamp relative to the connection time. */
-            *timestamp -= currentCtx->connectTime;
-          }
-          /* Successfully submitted for transmission. Update the result accordingly. */
+          currentCtx->opt_backend = value;
           result = CANCOMM_TRUE;
         }
-      }
+        break;
+
+      default:
+        /* Unknown option. */
+        break;
     }
   }
 
   /* Give the result back to the caller. */
   return result;
-} /*** end of cancomm_transmit ***/
+} /*** end of cancomm_set_option ***/
 
 
 /************************************************************************************//**
-** \brief     Reads a possibly received CAN message or CAN eror frame in a non-blocking
-**            manner.
+** \brief     Connects to the specified SocketCAN device. Note that you can use the
+**            functions cancomm_devices_buildlist() and cancomm_devices_name() to
+**            determine the names of the SocketCAN devices known to the system. 
+**            Alternatively, you can run command "ip addr" in the terminal to find out
+**            about the SocketCAN devices know to the system.
+**            This function automatically figures out if the SocketCAN device supports
+**            CAN FD, in addition to CAN classic.
 ** \param     ctx CAN communication context.
-** \param     id Pointer to where the CAN message identifier is stored.
-** \param     ext Pointer to where the CAN identifier type is stored. CANCOMM_FALSE for
-**            an 11-bit message identifier, CANCOMM_TRUE for 29-bit.
-** \param     len Pointer to where the number of CAN message data bytes is stored.
-** \param     data Pointer to array where the data bytes are stored.
-** \param     flags Pointer to where the bit flags are stored for providing additional
-**            information about the received message:
-**              CANCOMM_FLAG_CANFD_MSG - The message is CAN FD and not CAN classic.
-**              CANCOMM_FLAG_CANERR_MSG - The message is a CAN error frame.
-** \param     timestamp Pointer to where the timestamp (microseconds) of the message is
-**            stored.
-** \return    CANCOMM_TRUE if a new message was received and copied. CANCOMM_FALSE 
-**            otherwise.
+** \param     device Null terminated string with the SocketCAN device name, e.g. "can0".
+**            Use CANCOMM_DEVICE_ANY to receive from all SocketCAN devices at once. Refer
+**            to cancomm_connect_devices() for details.
+** \return    CANCOMM_TRUE if successfully connected to the SocketCAN device.
+**            CANCOMM_FALSE otherwise.
 **
 ****************************************************************************************/
-uint8_t cancomm_receive(cancomm_t ctx, uint32_t * id, uint8_t * ext, uint8_t * len, 
-                        uint8_t * data, uint8_t * flags, uint64_t * timestamp)
+uint8_t cancomm_connect(cancomm_t ctx, char const * device)
 {
   uint8_t result = CANCOMM_FALSE;
-  struct cancomm_ctx * currentCtx;
-  struct canfd_frame canRxFrame = { 0 };
-  struct timeval tv = { 0 };
-  size_t frameSize;
 
   /* Verify parameters. */
-  assert((ctx != NULL) && (id != NULL) && (ext != NULL) && (len != NULL) && 
-        (data != NULL) && (timestamp != NULL));
+  assert((ctx != NULL) && (device != NULL));
 
   /* Only continue with a valid parameters. */
-  if ((ctx != NULL) && (id != NULL) && (ext != NULL) && (len != NULL) && 
-      (data != NULL) && (timestamp != NULL))
+  if ((ctx != NULL) && (device != NULL))
   {
-    /* Cast the opaque pointer to its non-opaque counter part. */
-    currentCtx = (struct cancomm_ctx *)ctx;
-
-    /* Only receive if actually connected. */
-    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    /* Connecting to any device is the same as connecting to an empty device set. */
+    if (strcmp(device, CANCOMM_DEVICE_ANY) == 0)
     {
-      /* Attempt to read the next frame from the queue. */
-      frameSize = read(currentCtx->socket, &canRxFrame, CANFD_MTU);
-      /* CAN FD or CAN classic frames are the only valid ones. */
-      if ( (frameSize == CANFD_MTU) || (frameSize == CAN_MTU) )
-      {
-        /* Ignore remote frames. Pretty much no one actually uses these. */
-        if (!(canRxFrame.can_id & CAN_RTR_FLAG))
-        {
-          /* Reset the bit flags. */
-          *flags = 0;
-          /* Obtain the timestamp of the reception event. */
-          *timestamp = 0;
-          if (ioctl(currentCtx->socket, SIOCGSTAMP, &tv) == 0)
-          {
-            /* Convert the timestamp to microseconds. */
-            *timestamp = ((int64_t)tv.tv_sec * 1000 * 1000ULL) + ((int64_t)tv.tv_usec);
-            /* Make the timestamp relative to the connection time. */
-            *timestamp -= currentCtx->connectTime;
-          }
-
-          /* Was it an error frame? */
-          if (canRxFrame.can_id & CAN_ERR_FLAG)
-          {
-            /* Store error frame info. */
-            *flags |= CANCOMM_FLAG_CANERR_MSG;
-            *id = 0;
-            *ext = CANCOMM_FALSE;
-            *len = 0;
-          }
-          /* It was a regular data frame. Either CAN FD or CAN classic. */
-          else
-          {
-            /* Was it a CAN FD frame? */
-            if (frameSize == CANFD_MTU)
-            {
-              /* Flag the frame as a CAN FD frame for the caller. */
-              *flags |= CANCOMM_FLAG_CANFD_MSG;
-            }
-
-            /* Copy the CAN data frame. */
-            if (canRxFrame.can_id & CAN_EFF_FLAG)
-            {
-              *ext = CANCOMM_TRUE;
-            }
-            else
-            {
-              *ext = CANCOMM_FALSE;
-            }
-            *id = canRxFrame.can_id & ~CAN_EFF_FLAG;
-            *len = canRxFrame.len;
-            for (uint8_t idx = 0; idx < canRxFrame.len; idx++)
-            {
-              data[idx] = canRxFrame.data[idx];
-            }
-          }
-
-          /* Frame successfully read. Update the result accordingly. */
-          result = CANCOMM_TRUE;
-        }        
-      }
+      result = cancomm_connect_devices(ctx, NULL, 0);
+    }
+    else
+    {
+      result = cancomm_connect_devices(ctx, &device, 1);
     }
   }
 
   /* Give the result back to the caller. */
   return result;
-} /*** end of cancomm_receive ***/
+} /*** end of cancomm_connect ***/
 
 
 /************************************************************************************//**
-** \brief     Builds a list with all the CAN device names currently present on the
-**            system. Basically an internal array with strings such as can0, vcan0, etc.
-**            Afterwards, you can call cancomm_devices_name() to retrieve the name of a
-**            specific SocketCAN device, using its array index.
+** \brief     Connects to a set of SocketCAN devices at once, or to all SocketCAN devices
+**            on the system. This way a single context, and with it one thread and one
+**            call to cancomm_receive_batch(), serves multiple CAN buses. The ifindex
+**            member of each received frame reports the device that the frame came from.
+**            Frames from devices outside of the set are dropped. To transmit on a 
+**            specific device, set the ifindex member of the frame passed to
+**            cancomm_transmit_batch(). cancomm_transmit() uses the first device of the
+**            set. CAN FD is enabled if at least one device of the set supports it.
 ** \param     ctx CAN communication context.
-** \return    The total number of CAN devices currently present on the system, or 0 if
-**            none were found or in case of an error.
+** \param     devices Pointer to an array with null terminated SocketCAN device names.
+**            NULL to connect to all SocketCAN devices.
+** \param     count Number of device names in the array. 0 to connect to all SocketCAN
+**            devices.
+** \return    CANCOMM_TRUE if successfully connected to the SocketCAN devices.
+**            CANCOMM_FALSE otherwise.
 **
 ****************************************************************************************/
-uint8_t cancomm_devices_buildlist(cancomm_t ctx)
+uint8_t cancomm_connect_devices(cancomm_t ctx, char const * const * devices, 
+                                size_t count)
 {
-  uint8_t result = 0;
+  uint8_t result = CANCOMM_FALSE;
   struct cancomm_ctx * currentCtx;
-  struct ifaddrs *ifaddr;
-  char * deviceNameEntryPtr;
+  struct sockaddr_can addr = { 0 };
+  int32_t flags;
+  uint32_t * ifindexes = NULL;
+  int32_t deviceMtu;
+  int enable_canfd = 1;
+  int enable = 1;
 
-  /* Verify parameter. */
-  assert(ctx != NULL);
+  /* Verify parameters. */
+  assert((ctx != NULL) && ((devices != NULL) || (count == 0)));
 
-  /* Only continue with a valid parameter. */
-  if (ctx != NULL)
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && ((devices != NULL) || (count == 0)))
   {
     /* Cast the opaque pointer to its non-opaque counter part. */
     currentCtx = (struct cancomm_ctx *)ctx;
 
-    /* Reset the devices count in the context. */
-    currentCtx->devices_cnt = 0;
+    /* Set positive result at this point and negate upon error detection. */
+    result = CANCOMM_TRUE;
+
+    /* Make sure we are not already connected to a CAN device. */
+    cancomm_disconnect(currentCtx);
+
+    /* Get the current time of the configured clock and store it as the connection
+     * start time. Needed for zero based timestamp. 
+     */
+    if (cancomm_clock_read(currentCtx, &currentCtx->connectTime) != CANCOMM_TRUE)
+    {
+      result = CANCOMM_FALSE;
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Get open socket descriptor. */
+      if ((currentCtx->socket = socket(PF_CAN, (int)SOCK_RAW, CAN_RAW)) < 0)
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    if ((result == CANCOMM_TRUE) && (count > 0))
+    {
+      /* Make sure the array for the interface indices of the devices is large enough.
+       * It is kept upon disconnect, so a reconnect typically reuses it.
+       */
+      if (cancomm_ifindexes_reserve(currentCtx, count) == CANCOMM_TRUE)
+      {
+        ifindexes = currentCtx->rx_ifindexes;
+      }
+      else
+      {
+        close(currentCtx->socket);
+        currentCtx->socket = CANCOMM_INVALID_SOCKET;
+        result = CANCOMM_FALSE;
+      }
+    }
 
-    /* Attempt to obtain access to the linked list with network interfaces. */
-    if (getifaddrs(&ifaddr) == 0) 
+    if (result == CANCOMM_TRUE)
     {
-      /* Loop through the linked list, while maintaining head pointer, needed to free the
-       * list later on.
+      /* Determine the interface index of each CAN device and if it is configured for
+       * CAN classic or CAN FD mode.
        */
-      for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next)
+      currentCtx->fd_enabled = (count == 0) ? CANCOMM_TRUE : CANCOMM_FALSE;
+      for (size_t idx = 0; idx < count; idx++)
       {
-        /* We are interested in the ifa_name element, so only process the node, when this
-         * one is valid.
-        */
-        if (ifa->ifa_name != NULL)
+        if (cancomm_device_probe(currentCtx->socket, devices[idx], &ifindexes[idx],
+                                 &deviceMtu) != CANCOMM_TRUE)
         {
-          /* Check if this network interface is actually a CAN interface. */
-          if (cancomm_devices_is_can(ifa->ifa_name) == CANCOMM_TRUE)
-          {
-            /* Increment the devices count in the context. */
-            currentCtx->devices_cnt++;
-            /* Allocate memory in the devices list to store the device name. */
-            currentCtx->devices_list = realloc(currentCtx->devices_list, 
-                                               currentCtx->devices_cnt * IFNAMSIZ);
-            /* Check allocation results. */
-            if (currentCtx->devices_list == NULL)
-            {
-              /* Could not build the devices list due to an allocation issue. Reset
-               * the counter and break the loop. 
-               */
-              currentCtx->devices_cnt = 0;
-              break;
-            }
-            /* Still here so the allocation was successful. Now determine the address
-             * inside the device list, where to store the device name. It's basically
-             * the start of the newly allocated memory.
-             */
-            deviceNameEntryPtr = &currentCtx->devices_list[(currentCtx->devices_cnt - 1)
-                                                           * IFNAMSIZ]; 
-            /* Store the device name in the list. */
-            strncpy(deviceNameEntryPtr, ifa->ifa_name, IFNAMSIZ);
-          }
+          close(currentCtx->socket);
+          currentCtx->socket = CANCOMM_INVALID_SOCKET;
+          result = CANCOMM_FALSE;
+          break;
+        }
+        /* Use the MTU value to determine if the CAN device is operating in CAN classic
+         * or CAN FD mode. Note that the MTU value of the CAN device changes
+         * automatically to the value of CANFD_MTU, after the data bitrate was
+         * configured and the fd mode was turned on. Example:
+         *   ip link set can0 type can bitrate 500000 dbitrate 4000000 fd on
+         */
+        if (deviceMtu == CANFD_MTU)
+        {
+          currentCtx->fd_enabled = CANCOMM_TRUE;
         }
       }
-      /* Free the list, now that we are done with it. */
-      freeifaddrs(ifaddr);
-      /* Update the result. */
-      result = currentCtx->devices_cnt;
     }
-  }
-
-  /* Give the result back to the caller. */
-  return result;
-} /*** end of cancomm_devices_buildlist ***/
-
 
-/************************************************************************************//**
-** \brief     Obtains the CAN device name at the specified index of the internal list
-**            with CAN devices, created by function cancomm_devices_buildlist(). You
-**            could use this CAN device name when calling cancomm_connect().
-** \attention Call cancomm_devices_buildlist() prior to calling this function.
-** \param     ctx CAN communication context.
-** \param     idx Zero based index into the device list.
-** \return    The CAN device name at the specified index, or NULL in case of an error.
+    if (result == CANCOMM_TRUE)
+    {
+      /* Attempt to switch socket into CAN FD mode, if a CAN device is configured for
+       * CAN FD.
+       */
+      if (currentCtx->fd_enabled == CANCOMM_TRUE)
+      {
+        if (setsockopt(currentCtx->socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, 
+            &enable_canfd, sizeof(enable_canfd)) != 0)
+        {
+          /* Could not switch the socket into CAN FD mode. Fall back to CAN classic
+           * operation.
+           */
+          currentCtx->fd_enabled = CANCOMM_FALSE;
+        }
+      }
+
+      /* Request the kernel to pass the reception timestamp along with each frame as
+       * ancillary data. Saves a system call per frame and is the only way to obtain per
+       * frame timestamps, when multiple frames are read in one go.
+       */
+      cancomm_timestamping_enable(currentCtx, devices, count);
+
+      /* Size the socket buffers, if configured. */
+      cancomm_buffers_apply(currentCtx);
+
+      /* Request the kernel to report the number of frames that it dropped, because the
+       * socket's receive queue was full. Not critical, so errors are ignored.
+       */
+      (void)setsockopt(currentCtx->socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, 
+                       sizeof(enable));
+      currentCtx->rxq_drops = 0;
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Configure socket to work in non-blocking mode. */
+      flags = fcntl(currentCtx->socket, F_GETFL, 0);
+      if (flags == -1)
+      {
+        flags = 0;
+      }
+      if (fcntl(currentCtx->socket, F_SETFL, flags | O_NONBLOCK) == -1)
+      {
+        close(currentCtx->socket);
+        currentCtx->socket = CANCOMM_INVALID_SOCKET;
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Configure the acceptance filters before binding, such that unwanted CAN
+       * messages never make it into the socket's receive queue.
+       */
+      if (cancomm_filters_apply(currentCtx) != CANCOMM_TRUE)
+      {
+        close(currentCtx->socket);
+        currentCtx->socket = CANCOMM_INVALID_SOCKET;
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Set the address info. A single device binds the socket to just that device.
+       * Otherwise the socket is bound to all devices, with interface index 0.
+       */
+      addr.can_family = AF_CAN;
+      addr.can_ifindex = (count == 1) ? (int)ifindexes[0] : 0;
+
+      /* Bind the socket. */
+      if (bind(currentCtx->socket, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      {
+        close(currentCtx->socket);
+        currentCtx->socket = CANCOMM_INVALID_SOCKET;
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Store the device info. The first device is the default one for transmission. */
+      currentCtx->ifindex = (uint32_t)addr.can_ifindex;
+      currentCtx->tx_ifindex = (count > 0) ? ifindexes[0] : 0;
+      /* Only a set of multiple devices needs the list for dropping the frames that
+       * arrive from other devices.
+       */
+      if (count > 1)
+      {
+        currentCtx->rx_ifindexes_cnt = (uint32_t)count;
+      }
+      /* With the packet mmap backend, frames are received through the memory mapped
+       * ring of a packet socket. The raw socket then just transmits.
+       */
+      if (currentCtx->opt_backend == CANCOMM_BACKEND_PACKET_MMAP)
+      {
+        if (cancomm_packet_open(currentCtx, currentCtx->ifindex) != CANCOMM_TRUE)
+        {
+          cancomm_disconnect(currentCtx);
+          result = CANCOMM_FALSE;
+        }
+      }
+      /* With the io_uring backend, all I/O on the raw socket goes through the queues
+       * of an io_uring instance.
+       */
+      else if (currentCtx->opt_backend == CANCOMM_BACKEND_IO_URING)
+      {
+        if (cancomm_uring_open(currentCtx) != CANCOMM_TRUE)
+        {
+          cancomm_disconnect(currentCtx);
+          result = CANCOMM_FALSE;
+        }
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Create the event file descriptor that wakes up the threads, which sleep in a
+       * blocking call, upon cancomm_shutdown().
+       */
+      atomic_store(&currentCtx->shutdown_requested, false);
+      currentCtx->shutdown_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+      if (currentCtx->shutdown_fd < 0)
+      {
+        cancomm_disconnect(currentCtx);
+        result = CANCOMM_FALSE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_connect_devices ***/
+
+
+/************************************************************************************//**
+** \brief     Disconnects from the SocketCAN device.
+** \param     ctx CAN communication context.
 **
 ****************************************************************************************/
-char * cancomm_devices_name(cancomm_t ctx, uint8_t idx)
+void cancomm_disconnect(cancomm_t ctx)
 {
-  char * result = NULL;
   struct cancomm_ctx * currentCtx;
 
   /* Verify parameter. */
@@ -646,106 +1624,8470 @@ char * cancomm_devices_name(cancomm_t ctx, uint8_t idx)
     /* Cast the opaque pointer to its non-opaque counter part. */
     currentCtx = (struct cancomm_ctx *)ctx;
 
-    /* Only continue if the specified index is valid. */
-    if (idx < currentCtx->devices_cnt)
+    /* The background reader thread uses the socket, so stop it first. */
+    cancomm_reader_stop(currentCtx);
+
+    /* The io_uring backend has requests outstanding on the socket. Closing it cancels
+     * them, so close it before the socket.
+     */
+    cancomm_uring_close(currentCtx);
+    /* Closing the broadcast manager socket also ends its cyclic transmissions and
+     * subscriptions.
+     */
+    cancomm_bcm_close(currentCtx);
+    cancomm_txn_close(currentCtx);
+    /* Only disconnect if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
     {
-      /* Point the result to the CAN device name as the specified index. */
-      result = &currentCtx->devices_list[idx * IFNAMSIZ];
+      close(currentCtx->socket);
+      currentCtx->socket = CANCOMM_INVALID_SOCKET;
+      atomic_store_explicit(&currentCtx->txtime_enabled, false, memory_order_relaxed);
+    }
+    /* Close the packet socket and its ring, if the packet mmap backend is active. */
+    cancomm_packet_close(currentCtx);
+    /* Close the event file descriptor for the shutdown notification. */
+    if (currentCtx->shutdown_fd >= 0)
+    {
+      close(currentCtx->shutdown_fd);
+      currentCtx->shutdown_fd = -1;
+    }
+    /* Accept frames from all devices again. The array with the interface indices is
+     * kept for the next connect.
+     */
+    currentCtx->rx_ifindexes_cnt = 0;
+    currentCtx->ifindex = 0;
+    currentCtx->tx_ifindex = 0;
+  }
+} /*** end of cancomm_disconnect ***/
+
+
+/************************************************************************************//**
+** \brief     Requests the threads that use the context to stop, for a safe shutdown.
+**            This is the only function that another thread may call, while one
+**            thread receives and other threads transmit on the same context. Threads
+**            that sleep in a blocking call, such as cancomm_receive_timeout(),
+**            cancomm_wait_writable() or cancomm_transact(), wake up right away and the
+**            call returns CANCOMM_FALSE. So do all later blocking calls, until the next
+**            connect. Check cancomm_shutdown_requested() to end the loops of the
+**            threads. Once all of them returned, call cancomm_disconnect() from one
+**            thread. Never disconnect while other threads still use the context, because
+**            it closes the sockets underneath them.
+** \param     ctx CAN communication context.
+**
+****************************************************************************************/
+void cancomm_shutdown(cancomm_t ctx)
+{
+  struct cancomm_ctx * currentCtx;
+  uint64_t wakeValue = 1;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Set the flag first, such that a woken up thread sees it. */
+    atomic_store(&currentCtx->shutdown_requested, true);
+    /* The event file descriptor stays readable, because nobody reads it. This wakes up
+     * all the threads that sleep in a blocking call, now and later on.
+     */
+    if (currentCtx->shutdown_fd >= 0)
+    {
+      (void)write(currentCtx->shutdown_fd, &wakeValue, sizeof(wakeValue));
+    }
+  }
+} /*** end of cancomm_shutdown ***/
+
+
+/************************************************************************************//**
+** \brief     Determines if cancomm_shutdown() was called for the context, since it
+**            connected. Does not need a system call, so it is cheap enough for checking
+**            in each iteration of the loop of a receiving or transmitting thread.
+** \param     ctx CAN communication context.
+** \return    CANCOMM_TRUE if shutdown was requested, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_shutdown_requested(cancomm_t ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    if (atomic_load(&currentCtx->shutdown_requested))
+    {
+      result = CANCOMM_TRUE;
     }
   }
 
   /* Give the result back to the caller. */
   return result;
-} /*** end of cancomm_devices_name ***/
+} /*** end of cancomm_shutdown_requested ***/
 
 
 /************************************************************************************//**
-** \brief     Determines if the specified network interface name is a CAN device.
-** \param     name Network interface name. For example obtained by getifaddrs().
-** \return    CANCOMM_TRUE is the specified network interface name is a CAN device,
-**            CANCOMM_FALSE otherwise.
+** \brief     Submits a CAN message for transmission.
+** \param     ctx CAN communication context.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
+**            29-bit.
+** \param     len Number of CAN message data bytes.
+** \param     data Pointer to array with data bytes.
+** \param     flags Bit flags for providing additional information about how to transmit
+**            the message:
+**              CANCOMM_FLAG_CANFD_MSG - The message is CAN FD and not CAN classic. 
+**                                       Ignored for non CAN FD SocketCAN devices.
+** \param     timestamp Pointer to where the timestamp of the message is stored. In
+**            microseconds, unless configured otherwise with option CANCOMM_OPT_TIMESTAMP.
+**            Can be NULL, which saves reading the clock.
+** \return    CANCOMM_TRUE if successfully submitted the message for transmission.
+**            CANCOMM_FALSE otherwise. cancomm_last_tx_queue_full() then tells if the
+**            transmit queue was full.
 **
 ****************************************************************************************/
-static uint8_t cancomm_devices_is_can(char const * name)
+uint8_t cancomm_transmit(cancomm_t ctx, uint32_t id, uint8_t ext, uint8_t len, 
+                         uint8_t const * data, uint8_t flags, uint64_t * timestamp)
 {
   uint8_t result = CANCOMM_FALSE;
-  struct ifreq ifr;
-  int canSocket;
+  struct cancomm_ctx * currentCtx;
+  struct canfd_frame canTxFrame;
+  struct sockaddr_can addr = { 0 };
+  struct mmsghdr msg = { 0 };
+  struct iovec iov;
+  size_t frameSize;
+  ssize_t written = -1;
+  uint8_t queueFull = CANCOMM_FALSE;
 
-  /* Verify parameter. */
-  assert(name != NULL);
+  /* Verify parameters. */
+  assert((ctx != NULL) && (len <= CANFD_MAX_DLEN) && (data != NULL));
 
-  /* Only continue with valid parameter and acceptable length of the interface name. */
-  if ( (name != NULL) && (strlen(name) < IFNAMSIZ) )
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (len <= CANFD_MAX_DLEN) && (data != NULL))
   {
-    /* Create an ifreq structure for passing data in and out of ioctl. */
-    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
-    ifr.ifr_name[IFNAMSIZ - 1] = '\0';
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
 
-    /* Get open socket descriptor */
-    if ((canSocket = socket(PF_CAN, (int)SOCK_RAW, CAN_RAW)) != -1)
+    /* Only transmit if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
     {
-      /* Obtain the hardware address information. */
-      if (ioctl(canSocket, SIOCGIFHWADDR, &ifr) != -1)
+      /* Construct the transmit frame. Only transmit if all the data actually fits. */
+      if (cancomm_frame_pack(currentCtx, id, ext, len, data, flags, &canTxFrame, 
+                             &frameSize) == CANCOMM_TRUE)
       {
-        /* Is this a CAN device? */
-        if (ifr.ifr_hwaddr.sa_family == ARPHRD_CAN)
+        /* Request transmission of the frame. When not bound to a specific device, the
+         * frame needs to be addressed to the default device for transmission.
+         */
+        errno = 0;
+        if (currentCtx->uring != NULL)
+        {
+          /* The io_uring backend queues the frame for asynchronous transmission. */
+          iov.iov_base = &canTxFrame;
+          iov.iov_len = frameSize;
+          msg.msg_hdr.msg_iov = &iov;
+          msg.msg_hdr.msg_iovlen = 1;
+          if (currentCtx->ifindex == 0)
+          {
+            addr.can_family = AF_CAN;
+            addr.can_ifindex = (int)currentCtx->tx_ifindex;
+            msg.msg_hdr.msg_name = &addr;
+            msg.msg_hdr.msg_namelen = sizeof(addr);
+          }
+          if ((currentCtx->ifindex != 0) || (currentCtx->tx_ifindex != 0))
+          {
+            if (cancomm_uring_transmit(currentCtx, &msg, 1) == 1)
+            {
+              written = (ssize_t)frameSize;
+            }
+          }
+        }
+        else if (currentCtx->ifindex != 0)
+        {
+          written = write(currentCtx->socket, &canTxFrame, frameSize);
+        }
+        else if (currentCtx->tx_ifindex != 0)
+        {
+          addr.can_family = AF_CAN;
+          addr.can_ifindex = (int)currentCtx->tx_ifindex;
+          written = sendto(currentCtx->socket, &canTxFrame, frameSize, 0,
+                           (struct sockaddr *)&addr, sizeof(addr));
+        }
+        if ((written > 0) && ((size_t)written == frameSize))
         {
-          /* Update the result accordingly. */
+          /* Get the timestamp of the transmit event, unless the caller is not
+           * interested in it.
+           */
+          if (timestamp != NULL)
+          {
+            *timestamp = cancomm_timestamp_now(currentCtx);
+          }
+          /* Successfully submitted for transmission. Update the result accordingly. */
           result = CANCOMM_TRUE;
         }
+        else
+        {
+          queueFull = cancomm_tx_queue_full();
+        }
       }
-      /* Close the socket, now that we are done with it. */
-      close(canSocket);
     }
+    /* Account the transmit attempt. */
+    cancomm_stats_tx(currentCtx, (result == CANCOMM_TRUE) ? 1U : 0U, result, queueFull);
   }
- 
+
   /* Give the result back to the caller. */
   return result;
-} /*** end of cancomm_devices_is_can ***/
+} /*** end of cancomm_transmit ***/
 
 
 /************************************************************************************//**
-** \brief     Helper function to sanitize the CAN frame length, specifically for CAN FD.
-**            On CAN FD, the frame lengths can be: 0..8, 12, 16, 20, 24, 32, 48, 64.
-**            This means that if a frame length of 14 is specified, it should be rounded
-**            up to the next supported frame length value, 16 in this case.
-** \param     len Unsanitized frame length. 0..64.
-** \return    Sanitized frame length in the range 0..8, 12, 16, 20, 24, 32, 48, 64.
+** \brief     Submits multiple CAN messages for transmission. Compared to calling
+**            cancomm_transmit() repeatedly, this function needs far fewer system calls,
+**            as it hands multiple frames over to the kernel at once. Frames are submitted
+**            in array order. Submission stops at the first frame that the kernel did not
+**            accept, for example because its transmit queue is full, or at the first
+**            frame with an invalid length. The number of submitted frames tells the
+**            caller where to resume.
+** \param     ctx CAN communication context.
+** \param     frames Pointer to the array with frames to transmit. The identifier,
+**            identifier type, length, data and CANCOMM_FLAG_CANFD_MSG flag are used
+**            in the same way as the parameters of cancomm_transmit(). The ifindex
+**            member selects the CAN device to transmit on. Zero selects the connected
+**            device, or the first one of a device set. The timestamp of each submitted
+**            frame is written to its timestamp member.
+** \param     count Number of frames in the array.
+** \param     sent Pointer to where the number of frames that were actually submitted
+**            for transmission is written.
+** \return    CANCOMM_TRUE if all frames were successfully submitted for transmission.
+**            CANCOMM_FALSE otherwise. cancomm_last_tx_queue_full() then tells if
+**            submission stopped, because the transmit queue was full.
 **
 ****************************************************************************************/
-static uint8_t cancomm_sanitize_frame_len(uint8_t len)
+uint8_t cancomm_transmit_batch(cancomm_t ctx, cancomm_frame_t * frames, size_t count,
+                               size_t * sent)
 {
-  uint8_t result;
-  uint8_t frame_len;
-  uint8_t frame_dlc;
-  static const uint8_t len2dlc[] = 
-  {  0,  1,  2,  3,  4,  5,  6,  7,  8,    /*  0 -  8 */
-     9,  9,  9,  9,                        /*  9 - 12 */
-    10, 10, 10, 10,                        /* 13 - 16 */
-    11, 11, 11, 11,                        /* 17 - 20 */
-    12, 12, 12, 12,                        /* 21 - 24 */
-    13, 13, 13, 13, 13, 13, 13, 13,        /* 25 - 32 */
-    14, 14, 14, 14, 14, 14, 14, 14,        /* 33 - 40 */
-    14, 14, 14, 14, 14, 14, 14, 14,        /* 41 - 48 */
-    15, 15, 15, 15, 15, 15, 15, 15,        /* 49 - 56 */
-    15, 15, 15, 15, 15, 15, 15, 15         /* 57 - 64 */
-  };
-  static const uint8_t dlc2len[] = 
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (sent != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (sent != NULL))
+  {
+    result = cancomm_frames_send((struct cancomm_ctx *)ctx, frames, count, sent, 
+                                 CANCOMM_FALSE);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_transmit_batch ***/
+
+
+/************************************************************************************//**
+** \brief     Submits multiple CAN messages for transmission at specific points in time.
+**            The kernel holds each frame until its launch time is reached, for example
+**            with the earliest TxTime first (ETF) queuing discipline configured on the
+**            CAN device. This way the send times do not depend on the scheduling of the
+**            calling thread and a whole cycle of frames can be queued in advance. The
+**            launch times are absolute times of CLOCK_TAI in nanoseconds, as the ETF
+**            queuing discipline requires. Without a queuing discipline that supports
+**            launch times, the frames are transmitted right away. Submission stops in
+**            the same way as with cancomm_transmit_batch(). Requires kernel support for
+**            SO_TXTIME on CAN raw sockets.
+** \param     ctx CAN communication context.
+** \param     frames Pointer to the array with frames to transmit, in the same way as 
+**            with cancomm_transmit_batch(). The timestamp member holds the launch time.
+** \param     count Number of frames in the array.
+** \param     sent Pointer to where the number of frames that were actually submitted
+**            for transmission is written.
+** \return    CANCOMM_TRUE if all frames were successfully submitted for transmission.
+**            CANCOMM_FALSE otherwise. cancomm_last_tx_queue_full() then tells if
+**            submission stopped, because the transmit queue was full.
+**
+****************************************************************************************/
+uint8_t cancomm_transmit_scheduled(cancomm_t ctx, cancomm_frame_t * frames, 
+                                   size_t count, size_t * sent)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (sent != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (sent != NULL))
   {
-    0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64
-  };                                    
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+    /* Reset the submitted frame count. */
+    *sent = 0;
+
+    /* Launch times are enabled upon first use and only while connected. */
+    if (cancomm_txtime_enable(currentCtx) == CANCOMM_TRUE)
+    {
+      result = cancomm_frames_send(currentCtx, frames, count, sent, CANCOMM_TRUE);
+    }
+    else
+    {
+      /* Account the failed transmit attempt. */
+      cancomm_stats_tx(currentCtx, 0, result, CANCOMM_FALSE);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_transmit_scheduled ***/
+
+
+/************************************************************************************//**
+** \brief     Waits until the context can accept frames for transmission again, after
+**            cancomm_last_tx_queue_full() reported a full transmit queue. While waiting,
+**            the calling thread sleeps in the kernel. The wait is exact for a full 
+**            socket send buffer. A full queue of the CAN device does not wake up the
+**            thread, so limit the send buffer with option CANCOMM_OPT_SNDBUF such that
+**            it fills up first.
+** \param     ctx CAN communication context.
+** \param     timeout_us Maximum time in microseconds to wait. Zero to just check and
+**            CANCOMM_TIMEOUT_INFINITE to wait indefinitely.
+** \return    CANCOMM_TRUE if frames can be transmitted. CANCOMM_FALSE upon timeout, 
+**            signal interruption or error.
+**
+****************************************************************************************/
+uint8_t cancomm_wait_writable(cancomm_t ctx, uint32_t timeout_us)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
 
-  /* Make sure the specified len parameter is valid. If not, correct it. */
-  frame_len = (len > CANFD_MAX_DLEN) ? CANFD_MAX_DLEN : len;
-  /* Convert the lenght value to the CAN FD dlc value (0..15). */
-  frame_dlc = len2dlc[frame_len];
-  /* Convert the CAN FD dlc value to its representive frame length value. */
-  result = dlc2len[frame_dlc];
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only wait if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      /* Determine the absolute point in time at which to stop waiting. */
+      if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+      {
+        cancomm_deadline_init(&deadline, timeout_us);
+        deadlinePtr = &deadline;
+      }
+      /* The io_uring backend frees its transmit slots upon completion events. */
+      if (currentCtx->uring != NULL)
+      {
+        result = cancomm_wait_fd(currentCtx->uring->fd, currentCtx->shutdown_fd, POLLIN,
+                                 deadlinePtr);
+      }
+      else
+      {
+        result = cancomm_wait_event(currentCtx, POLLOUT, deadlinePtr);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_wait_writable ***/
+
+
+/************************************************************************************//**
+** \brief     Determines if the last transmit function, that the calling thread called,
+**            failed because the transmit queue was full. The transmit functions keep 
+**            their boolean result, so call this one after they returned CANCOMM_FALSE,
+**            to tell a full transmit queue apart from other errors. Try again later in
+**            that case, for example after cancomm_wait_writable(). The information is
+**            kept per thread, so it is safe while other threads transmit as well.
+** \return    CANCOMM_TRUE if the transmit queue was full, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_last_tx_queue_full(void)
+{
+  /* Give the result back to the caller. */
+  return cancomm_tx_queue_full_flag;
+} /*** end of cancomm_last_tx_queue_full ***/
+
+
+/************************************************************************************//**
+** \brief     Prepares a CAN message for repeated transmission. The frame, as passed to
+**            the kernel, gets constructed just once. Afterwards, only the data bytes
+**            need updating before each transmission, which makes this the most
+**            efficient way of sending periodic CAN messages. The prepared frame is
+**            based on the current connection, so prepare it after connecting and
+**            prepare it again after connecting to another CAN device.
+** \param     ctx CAN communication context.
+** \param     frame Pointer to the CAN message to prepare. The identifier, identifier
+**            type, length, data, CANCOMM_FLAG_CANFD_MSG flag and ifindex are used in
+**            the same way as with cancomm_transmit_batch().
+** \return    Handle to the prepared frame, if successful. NULL otherwise. Release it
+**            with cancomm_prepared_free() once you no longer need it.
+**
+****************************************************************************************/
+cancomm_prepared_t cancomm_prepare(cancomm_t ctx, cancomm_frame_t const * frame)
+{
+  cancomm_prepared_t result = NULL;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_prepared * newPrepared;
+  uint32_t ifindex;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only prepare if actually connected and if there is a device to transmit on. */
+    ifindex = (frame->ifindex != 0) ? frame->ifindex : currentCtx->tx_ifindex;
+    if ((currentCtx->socket != CANCOMM_INVALID_SOCKET) && (ifindex != 0))
+    {
+      /* Allocate memory for the prepared frame. */
+      newPrepared = malloc(sizeof(struct cancomm_prepared));
+      if (newPrepared != NULL)
+      {
+        /* Construct the frame. Only if all the data actually fits. */
+        if (cancomm_frame_pack(currentCtx, frame->id, frame->ext, frame->len, 
+                               frame->data, frame->flags, &newPrepared->frame, 
+                               &newPrepared->size) == CANCOMM_TRUE)
+        {
+          /* Build the message header, such that transmitting it just takes one 
+           * system call. Address the frame, unless it goes to the device the socket 
+           * is bound to.
+           */
+          memset(&newPrepared->msg, 0, sizeof(newPrepared->msg));
+          newPrepared->iov.iov_base = &newPrepared->frame;
+          newPrepared->iov.iov_len = newPrepared->size;
+          newPrepared->msg.msg_iov = &newPrepared->iov;
+          newPrepared->msg.msg_iovlen = 1;
+          if (ifindex != currentCtx->ifindex)
+          {
+            memset(&newPrepared->addr, 0, sizeof(newPrepared->addr));
+            newPrepared->addr.can_family = AF_CAN;
+            newPrepared->addr.can_ifindex = (int)ifindex;
+            newPrepared->msg.msg_name = &newPrepared->addr;
+            newPrepared->msg.msg_namelen = sizeof(newPrepared->addr);
+          }
+          /* Update the result. */
+          result = (cancomm_prepared_t)newPrepared;
+        }
+        else
+        {
+          free(newPrepared);
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_prepare ***/
+
+
+/************************************************************************************//**
+** \brief     Releases a prepared frame.
+** \param     prepared Handle to the prepared frame.
+**
+****************************************************************************************/
+void cancomm_prepared_free(cancomm_prepared_t prepared)
+{
+  /* Verify parameter. */
+  assert(prepared != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (prepared != NULL)
+  {
+    free(prepared);
+  }
+} /*** end of cancomm_prepared_free ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains a pointer to the data bytes of a prepared frame, for updating them
+**            in place before the next transmission. The number of data bytes that can
+**            be written is the length of the prepared frame.
+** \param     prepared Handle to the prepared frame.
+** \return    Pointer to the data bytes, NULL if the handle is invalid.
+**
+****************************************************************************************/
+uint8_t * cancomm_prepared_data(cancomm_prepared_t prepared)
+{
+  uint8_t * result = NULL;
+
+  /* Verify parameter. */
+  assert(prepared != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (prepared != NULL)
+  {
+    result = ((struct cancomm_prepared *)prepared)->frame.data;
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_prepared_data ***/
+
+
+/************************************************************************************//**
+** \brief     Updates a range of data bytes of a prepared frame.
+** \param     prepared Handle to the prepared frame.
+** \param     offset Index of the first data byte to update.
+** \param     data Pointer to array with the new data bytes.
+** \param     len Number of data bytes to update.
+** \return    CANCOMM_TRUE if successful. CANCOMM_FALSE if the range does not fit in the
+**            length of the prepared frame.
+**
+****************************************************************************************/
+uint8_t cancomm_prepared_update(cancomm_prepared_t prepared, uint8_t offset, 
+                                uint8_t const * data, uint8_t len)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_prepared * currentPrepared;
+
+  /* Verify parameters. */
+  assert((prepared != NULL) && (data != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((prepared != NULL) && (data != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentPrepared = (struct cancomm_prepared *)prepared;
+
+    /* Only update if the range fits. */
+    if (((uint32_t)offset + len) <= currentPrepared->frame.len)
+    {
+      memcpy(&currentPrepared->frame.data[offset], data, len);
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_prepared_update ***/
+
+
+/************************************************************************************//**
+** \brief     Submits a prepared frame for transmission.
+** \param     ctx CAN communication context, that the frame was prepared with.
+** \param     prepared Handle to the prepared frame.
+** \param     timestamp Pointer to where the timestamp of the message is stored. In
+**            microseconds, unless configured otherwise with option CANCOMM_OPT_TIMESTAMP.
+**            Can be NULL, which saves reading the clock.
+** \return    CANCOMM_TRUE if successfully submitted the message for transmission.
+**            CANCOMM_FALSE otherwise. cancomm_last_tx_queue_full() then tells if the
+**            transmit queue was full.
+**
+****************************************************************************************/
+uint8_t cancomm_prepared_transmit(cancomm_t ctx, cancomm_prepared_t prepared,
+                                  uint64_t * timestamp)
+{
+  uint8_t result;
+  size_t sent;
+
+  /* Transmit it as a batch of one. Same amount of work and just one code path. */
+  result = cancomm_prepared_transmit_batch(ctx, &prepared, 1, &sent);
+  if (result == CANCOMM_TRUE)
+  {
+    /* Get the timestamp of the transmit event, unless the caller is not interested
+     * in it.
+     */
+    if (timestamp != NULL)
+    {
+      *timestamp = cancomm_timestamp_now((struct cancomm_ctx *)ctx);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_prepared_transmit ***/
+
+
+/************************************************************************************//**
+** \brief     Submits multiple prepared frames for transmission, with as few system calls
+**            as possible. Frames are submitted in array order. Submission stops at the
+**            first frame that the kernel did not accept, for example because its
+**            transmit queue is full. The number of submitted frames tells the caller 
+**            where to resume.
+** \param     ctx CAN communication context, that the frames were prepared with.
+** \param     prepared Pointer to the array with handles to the prepared frames.
+** \param     count Number of handles in the array.
+** \param     sent Pointer to where the number of frames that were actually submitted
+**            for transmission is written.
+** \return    CANCOMM_TRUE if all frames were successfully submitted for transmission.
+**            CANCOMM_FALSE otherwise. cancomm_last_tx_queue_full() then tells if
+**            submission stopped, because the transmit queue was full.
+**
+****************************************************************************************/
+uint8_t cancomm_prepared_transmit_batch(cancomm_t ctx, 
+                                        cancomm_prepared_t const * prepared, 
+                                        size_t count, size_t * sent)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct mmsghdr msgs[CANCOMM_BATCH_CHUNK_SIZE];
+  size_t chunkSize;
+  uint8_t queueFull = CANCOMM_FALSE;
+  int msgCnt;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (prepared != NULL) && (sent != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (prepared != NULL) && (sent != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+    /* Reset the submitted frame count. */
+    *sent = 0;
+
+    /* Only transmit if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      /* Keep submitting chunks of frames, until all are submitted, or until the kernel
+       * does not accept more frames.
+       */
+      while (*sent < count)
+      {
+        /* The message headers are already built, so just collect them. */
+        chunkSize = count - *sent;
+        if (chunkSize > CANCOMM_BATCH_CHUNK_SIZE)
+        {
+          chunkSize = CANCOMM_BATCH_CHUNK_SIZE;
+        }
+        for (size_t idx = 0; idx < chunkSize; idx++)
+        {
+          assert(prepared[*sent + idx] != NULL);
+          msgs[idx].msg_hdr = ((struct cancomm_prepared const *)
+                               prepared[*sent + idx])->msg;
+          msgs[idx].msg_len = 0;
+        }
+        /* Hand the frames of this chunk over to the kernel with just one system call. */
+        if (currentCtx->uring != NULL)
+        {
+          msgCnt = (int)cancomm_uring_transmit(currentCtx, msgs, chunkSize);
+        }
+        else
+        {
+          errno = 0;
+          msgCnt = sendmmsg(currentCtx->socket, msgs, (unsigned int)chunkSize, 0);
+        }
+        /* Stop if the kernel did not accept a single frame. After a partial chunk, the
+         * next attempt reports why the kernel stopped accepting frames.
+         */
+        if (msgCnt <= 0)
+        {
+          queueFull = cancomm_tx_queue_full();
+          break;
+        }
+        *sent += (size_t)msgCnt;
+      }
+
+      /* Update the result. */
+      if (*sent == count)
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+    /* Account the transmit attempt. */
+    cancomm_stats_tx(currentCtx, *sent, result, queueFull);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_prepared_transmit_batch ***/
+
+
+/************************************************************************************//**
+** \brief     Starts the cyclic transmission of a CAN message. The kernel's broadcast
+**            manager (CAN_BCM) then transmits the message, without any involvement of
+**            the application. The transmission job is identified by the identifier, 
+**            identifier type and CAN device of the message. Starting a job that already
+**            exists, restarts it with the new settings.
+** \param     ctx CAN communication context.
+** \param     frame Pointer to the CAN message to transmit. The identifier, identifier
+**            type, length, data, CANCOMM_FLAG_CANFD_MSG flag and ifindex are used in
+**            the same way as with cancomm_transmit_batch().
+** \param     period_us Transmission period in microseconds. The first transmission takes
+**            place right away.
+** \param     count Number of times to transmit the message, after which the job ends
+**            automatically. Zero to keep transmitting until cancomm_cyclic_stop().
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_cyclic_start(cancomm_t ctx, cancomm_frame_t const * frame, 
+                             uint32_t period_us, uint32_t count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  uint32_t ival1_us = 0;
+  uint32_t ival2_us = period_us;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL) && (period_us > 0));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL) && (period_us > 0))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* A limited number of transmissions runs on the first interval of the broadcast
+     * manager. Without a second interval, the job then ends.
+     */
+    if (count > 0)
+    {
+      ival1_us = period_us;
+      ival2_us = 0;
+    }
+    /* Set up the job and start its timer. */
+    result = cancomm_bcm_send(currentCtx, TX_SETUP, 
+                              SETTIMER | STARTTIMER | TX_ANNOUNCE, count, ival1_us, 
+                              ival2_us, frame, cancomm_bcm_tx_ifindex(currentCtx, 
+                                                                      frame));
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_cyclic_start ***/
+
+
+/************************************************************************************//**
+** \brief     Updates the data of a running cyclic transmission job, in place. The next
+**            cyclic transmission already uses the new data. The timing of the job is not
+**            affected.
+** \param     ctx CAN communication context.
+** \param     frame Pointer to the CAN message with the new data. The identifier,
+**            identifier type and ifindex select the job.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_cyclic_update(cancomm_t ctx, cancomm_frame_t const * frame)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Setting up an existing job without the timer flags just replaces its data. */
+    result = cancomm_bcm_send(currentCtx, TX_SETUP, 0, 0, 0, 0, frame, 
+                              cancomm_bcm_tx_ifindex(currentCtx, frame));
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_cyclic_update ***/
+
+
+/************************************************************************************//**
+** \brief     Stops and removes a cyclic transmission job.
+** \param     ctx CAN communication context.
+** \param     frame Pointer to the CAN message of the job. Just the identifier, 
+**            identifier type and ifindex are used, for selecting the job.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE if the job does not exist.
+**
+****************************************************************************************/
+uint8_t cancomm_cyclic_stop(cancomm_t ctx, cancomm_frame_t const * frame)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Delete the job. */
+    result = cancomm_bcm_send(currentCtx, TX_DELETE, 0, 0, 0, 0, frame, 
+                              cancomm_bcm_tx_ifindex(currentCtx, frame));
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_cyclic_stop ***/
+
+
+/************************************************************************************//**
+** \brief     Subscribes to the content changes of a CAN message. The kernel's broadcast
+**            manager (CAN_BCM) then compares each reception of the message with the
+**            previous one and only reports it if one of the relevant data bits, or the
+**            length, changed. Optionally, it also reports when the message stopped
+**            arriving. Read the reports with cancomm_subscription_receive(). A 
+**            subscription is identified by the identifier, identifier type and CAN
+**            device of its message. Subscribing again replaces the subscription.
+** \param     ctx CAN communication context.
+** \param     mask Pointer to a CAN message, that selects the message to subscribe to
+**            with its identifier, identifier type, CANCOMM_FLAG_CANFD_MSG flag and
+**            ifindex. Zero for the ifindex selects the connected device, or all
+**            devices of a device set. The data holds the mask with the relevant data
+**            bits. A length of zero reports each reception, without comparing.
+** \param     timeout_us Time in microseconds after which a missing message is reported
+**            with the CANCOMM_FLAG_TIMEOUT_MSG flag. Zero to not monitor for timeouts.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_subscribe(cancomm_t ctx, cancomm_frame_t const * mask, 
+                          uint32_t timeout_us)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  uint32_t flags = RX_CHECK_DLC | RX_ANNOUNCE_RESUME;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (mask != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (mask != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Without a mask, each reception passes and there is nothing to compare. */
+    if (mask->len == 0)
+    {
+      flags = RX_FILTER_ID;
+    }
+    /* Let the kernel monitor the reception timeout. */
+    if (timeout_us > 0)
+    {
+      flags |= SETTIMER | STARTTIMER;
+    }
+    /* Set up the subscription. */
+    result = cancomm_bcm_send(currentCtx, RX_SETUP, flags, 0, timeout_us, 0, mask, 
+                              (mask->ifindex != 0) ? mask->ifindex : 
+                              currentCtx->ifindex);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_subscribe ***/
+
+
+/************************************************************************************//**
+** \brief     Removes a subscription to the content changes of a CAN message.
+** \param     ctx CAN communication context.
+** \param     mask Pointer to the CAN message of the subscription. Just the identifier,
+**            identifier type and ifindex are used, for selecting the subscription.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE if the subscription does not
+**            exist.
+**
+****************************************************************************************/
+uint8_t cancomm_unsubscribe(cancomm_t ctx, cancomm_frame_t const * mask)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (mask != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (mask != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Delete the subscription. */
+    result = cancomm_bcm_send(currentCtx, RX_DELETE, 0, 0, 0, 0, mask, 
+                              (mask->ifindex != 0) ? mask->ifindex : 
+                              currentCtx->ifindex);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_unsubscribe ***/
+
+
+/************************************************************************************//**
+** \brief     Reads the next report of the subscriptions, if any. This function does not
+**            wait for a report. Use cancomm_subscription_get_fd() for that.
+** \param     ctx CAN communication context.
+** \param     frame Pointer to where the reported CAN message is stored. For a timeout 
+**            report, the flags contain CANCOMM_FLAG_TIMEOUT_MSG and only the identifier,
+**            identifier type, ifindex and timestamp are valid.
+** \return    CANCOMM_TRUE if a report was read. CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_subscription_receive(cancomm_t ctx, cancomm_frame_t * frame)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  union
+  {
+    struct bcm_msg_head head;
+    uint8_t             buf[sizeof(struct bcm_msg_head) + sizeof(struct canfd_frame)];
+  } bcmMsg;
+  struct canfd_frame raw;
+  struct sockaddr_can addr;
+  struct iovec iov;
+  struct msghdr msg;
+  union
+  {
+    char           buf[CANCOMM_CMSG_BUF_SIZE];
+    struct cmsghdr align;
+  } ctrl;
+  ssize_t msgSize;
+  size_t frameSize;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only receive if there are subscriptions. Keep reading until a report is found
+     * that is meant for this context.
+     */
+    while ((currentCtx->bcm_fd >= 0) && (result == CANCOMM_FALSE))
+    {
+      /* Attempt to read the next report, together with its timestamp. */
+      iov.iov_base = &bcmMsg;
+      iov.iov_len = sizeof(bcmMsg);
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_name = &addr;
+      msg.msg_namelen = sizeof(addr);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = ctrl.buf;
+      msg.msg_controllen = sizeof(ctrl.buf);
+      msgSize = recvmsg(currentCtx->bcm_fd, &msg, 0);
+      if (msgSize < (ssize_t)sizeof(struct bcm_msg_head))
+      {
+        break;
+      }
+      /* Skip reports of devices outside of the connected device set. */
+      if (cancomm_ifindex_accepted(currentCtx, (uint32_t)addr.can_ifindex) 
+          != CANCOMM_TRUE)
+      {
+        continue;
+      }
+      /* A changed message holds the frame right after the header. */
+      if ((bcmMsg.head.opcode == RX_CHANGED) && (bcmMsg.head.nframes == 1))
+      {
+        frameSize = ((bcmMsg.head.flags & CAN_FD_FRAME) != 0) ? CANFD_MTU : CAN_MTU;
+        if ((size_t)msgSize >= (sizeof(struct bcm_msg_head) + frameSize))
+        {
+          memcpy(&raw, &bcmMsg.buf[sizeof(struct bcm_msg_head)], frameSize);
+          if (cancomm_inline_frame_unpack(&raw, frameSize, frame) == CANCOMM_TRUE)
+          {
+            frame->timestamp = cancomm_timestamp_from_cmsg(currentCtx, &msg, 
+                                                cancomm_clock_offset(currentCtx));
+            result = CANCOMM_TRUE;
+          }
+        }
+      }
+      /* A timeout report just holds the identifier. */
+      else if (bcmMsg.head.opcode == RX_TIMEOUT)
+      {
+        frame->id = bcmMsg.head.can_id & CAN_EFF_MASK;
+        frame->ext = ((bcmMsg.head.can_id & CAN_EFF_FLAG) != 0) ? CANCOMM_TRUE : 
+                     CANCOMM_FALSE;
+        frame->len = 0;
+        frame->flags = CANCOMM_FLAG_TIMEOUT_MSG;
+        frame->timestamp = cancomm_timestamp_now(currentCtx);
+        result = CANCOMM_TRUE;
+      }
+      if (result == CANCOMM_TRUE)
+      {
+        frame->ifindex = (uint32_t)addr.can_ifindex;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_subscription_receive ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the file descriptor that signals the reports of the subscriptions,
+**            for integration into an event loop. It signals POLLIN when at least one
+**            report is available. Read it with cancomm_subscription_receive(), until no 
+**            more reports are available. The descriptor is owned by the context. It 
+**            becomes invalid upon disconnect.
+** \param     ctx CAN communication context.
+** \return    The file descriptor if connected, -1 otherwise.
+**
+****************************************************************************************/
+int cancomm_subscription_get_fd(cancomm_t ctx)
+{
+  int result = -1;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Open the broadcast manager socket, such that the descriptor can already be
+     * added to the event loop before subscribing.
+     */
+    if (cancomm_bcm_open(currentCtx) == CANCOMM_TRUE)
+    {
+      result = currentCtx->bcm_fd;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_subscription_get_fd ***/
+
+
+/************************************************************************************//**
+** \brief     Transmits a request and waits for the matching response, such as with
+**            diagnostic services. The response is received on a separate socket, with
+**            an acceptance filter in the kernel. This way, unrelated CAN messages never
+**            wake up the caller and are not taken away from the regular reception.
+** \param     ctx CAN communication context.
+** \param     tx_frame Pointer to the request to transmit. The identifier, identifier
+**            type, length, data, CANCOMM_FLAG_CANFD_MSG flag and ifindex are used in
+**            the same way as with cancomm_transmit_batch(). The response is expected on
+**            the same CAN device.
+** \param     rx_id CAN message identifier of the response. Its identifier type must
+**            match the one of the request.
+** \param     rx_mask Bit mask with the identifier bits that must match.
+** \param     timeout_us Maximum time in microseconds to wait for the response. Use
+**            CANCOMM_TIMEOUT_INFINITE to wait indefinitely.
+** \param     rx_frame Pointer to where the response is stored.
+** \return    CANCOMM_TRUE if the response was received. CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_transact(cancomm_t ctx, cancomm_frame_t const * tx_frame, 
+                         uint32_t rx_id, uint32_t rx_mask, uint32_t timeout_us, 
+                         cancomm_frame_t * rx_frame)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct can_filter filter;
+  struct canfd_frame raw;
+  struct iovec iov;
+  struct msghdr msg;
+  union
+  {
+    char           buf[CANCOMM_CMSG_BUF_SIZE];
+    struct cmsghdr align;
+  } ctrl;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+  size_t frameSize;
+  ssize_t rxSize;
+  uint32_t ifindex;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (tx_frame != NULL) && (rx_frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (tx_frame != NULL) && (rx_frame != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Determine the device and make sure the transaction socket is open on it. */
+    ifindex = (tx_frame->ifindex != 0) ? tx_frame->ifindex : currentCtx->tx_ifindex;
+    if ((ifindex != 0) && (cancomm_txn_open(currentCtx, ifindex) == CANCOMM_TRUE) &&
+        (cancomm_frame_pack(currentCtx, tx_frame->id, tx_frame->ext, tx_frame->len, 
+                            tx_frame->data, tx_frame->flags, &raw, 
+                            &frameSize) == CANCOMM_TRUE))
+    {
+      /* Only let the response through, in the same way as cancomm_set_filters(). */
+      if (tx_frame->ext == CANCOMM_TRUE)
+      {
+        filter.can_id = (rx_id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+        filter.can_mask = (rx_mask & CAN_EFF_MASK);
+      }
+      else
+      {
+        filter.can_id = (rx_id & CAN_SFF_MASK);
+        filter.can_mask = (rx_mask & CAN_SFF_MASK);
+      }
+      filter.can_mask |= CAN_EFF_FLAG | CAN_RTR_FLAG;
+      if (setsockopt(currentCtx->txn_fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, 
+                     sizeof(filter)) == 0)
+      {
+        /* Discard responses that arrived too late for a previous transaction. */
+        while (recv(currentCtx->txn_fd, &raw.data[0], 0, MSG_DONTWAIT | MSG_TRUNC) >= 0)
+        {
+          /* Nothing else to do. */
+        }
+        /* Transmit the request. */
+        if (write(currentCtx->txn_fd, &raw, frameSize) == (ssize_t)frameSize)
+        {
+          /* Determine the absolute point in time at which to stop waiting. */
+          if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+          {
+            cancomm_deadline_init(&deadline, timeout_us);
+            deadlinePtr = &deadline;
+          }
+          /* Wait for the response. */
+          for (;;)
+          {
+            iov.iov_base = &raw;
+            iov.iov_len = sizeof(raw);
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = ctrl.buf;
+            msg.msg_controllen = sizeof(ctrl.buf);
+            rxSize = recvmsg(currentCtx->txn_fd, &msg, MSG_DONTWAIT);
+            if ((rxSize > 0) && 
+                (cancomm_inline_frame_unpack(&raw, (size_t)rxSize, 
+                                             rx_frame) == CANCOMM_TRUE))
+            {
+              rx_frame->ifindex = ifindex;
+              rx_frame->timestamp = cancomm_timestamp_from_cmsg(currentCtx, &msg,
+                                                  cancomm_clock_offset(currentCtx));
+              result = CANCOMM_TRUE;
+              break;
+            }
+            /* Sleep until the response arrives. Stop upon timeout, signal
+             * interruption or error.
+             */
+            if ((timeout_us == 0) || 
+                (cancomm_wait_fd(currentCtx->txn_fd, currentCtx->shutdown_fd, POLLIN, 
+                                 deadlinePtr) != CANCOMM_TRUE))
+            {
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_transact ***/
+
+
+/************************************************************************************//**
+** \brief     Opens an ISO-TP (ISO 15765-2) channel for transferring payloads of up to
+**            4095 bytes, such as diagnostic requests and responses. The kernel performs
+**            the segmentation into CAN messages, including the flow control. The channel
+**            uses the connected CAN device, or the first one of a device set. In CAN FD
+**            mode if the device supports it. The channel remains usable after the
+**            context disconnects.
+** \param     ctx CAN communication context.
+** \param     tx_id CAN message identifier for transmitting.
+** \param     rx_id CAN message identifier for receiving.
+** \param     ext CANCOMM_FALSE for 11-bit message identifiers, CANCOMM_TRUE for 29-bit.
+** \return    Handle to the ISO-TP channel, if successful. NULL otherwise. Release it with
+**            cancomm_isotp_free() once you no longer need it.
+**
+****************************************************************************************/
+cancomm_isotp_t cancomm_isotp_new(cancomm_t ctx, uint32_t tx_id, uint32_t rx_id, 
+                                  uint8_t ext)
+{
+  cancomm_isotp_t result = NULL;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_isotp * newIsotp;
+  struct sockaddr_can addr = { 0 };
+  struct can_isotp_ll_options llOpts = { 0 };
+  uint8_t success = CANCOMM_FALSE;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only open if connected and if there is a device to transfer on. */
+    if ((currentCtx->socket != CANCOMM_INVALID_SOCKET) && 
+        (currentCtx->tx_ifindex != 0))
+    {
+      newIsotp = malloc(sizeof(struct cancomm_isotp));
+      if (newIsotp != NULL)
+      {
+        newIsotp->fd = socket(PF_CAN, SOCK_DGRAM | SOCK_NONBLOCK, CAN_ISOTP);
+        /* Share the shutdown notification of the context, such that 
+         * cancomm_shutdown() also wakes up the threads that sleep on the channel.
+         */
+        newIsotp->shutdown_fd = fcntl(currentCtx->shutdown_fd, F_DUPFD_CLOEXEC, 0);
+        if ((newIsotp->fd >= 0) && (newIsotp->shutdown_fd >= 0))
+        {
+          success = CANCOMM_TRUE;
+          /* Use CAN FD frames with up to 64 data bytes, if the device supports it. */
+          if (currentCtx->fd_enabled == CANCOMM_TRUE)
+          {
+            llOpts.mtu = CANFD_MTU;
+            llOpts.tx_dl = CANFD_MAX_DLEN;
+            llOpts.tx_flags = CANFD_BRS;
+            if (setsockopt(newIsotp->fd, SOL_CAN_ISOTP, CAN_ISOTP_LL_OPTS, &llOpts, 
+                           sizeof(llOpts)) != 0)
+            {
+              success = CANCOMM_FALSE;
+            }
+          }
+        }
+        if (success == CANCOMM_TRUE)
+        {
+          /* Bind the channel to its identifiers and the device. */
+          addr.can_family = AF_CAN;
+          addr.can_ifindex = (int)currentCtx->tx_ifindex;
+          addr.can_addr.tp.tx_id = (ext == CANCOMM_TRUE) ? 
+                                   ((tx_id & CAN_EFF_MASK) | CAN_EFF_FLAG) : 
+                                   (tx_id & CAN_SFF_MASK);
+          addr.can_addr.tp.rx_id = (ext == CANCOMM_TRUE) ? 
+                                   ((rx_id & CAN_EFF_MASK) | CAN_EFF_FLAG) : 
+                                   (rx_id & CAN_SFF_MASK);
+          if (bind(newIsotp->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+          {
+            success = CANCOMM_FALSE;
+          }
+        }
+        /* Update the result, or clean up in case of an error. */
+        if (success == CANCOMM_TRUE)
+        {
+          result = (cancomm_isotp_t)newIsotp;
+        }
+        else
+        {
+          if (newIsotp->fd >= 0)
+          {
+            close(newIsotp->fd);
+          }
+          if (newIsotp->shutdown_fd >= 0)
+          {
+            close(newIsotp->shutdown_fd);
+          }
+          free(newIsotp);
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_isotp_new ***/
+
+
+/************************************************************************************//**
+** \brief     Closes an ISO-TP channel and releases its resources.
+** \param     isotp Handle to the ISO-TP channel.
+**
+****************************************************************************************/
+void cancomm_isotp_free(cancomm_isotp_t isotp)
+{
+  struct cancomm_isotp * currentIsotp;
+
+  /* Verify parameter. */
+  assert(isotp != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (isotp != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentIsotp = (struct cancomm_isotp *)isotp;
+
+    close(currentIsotp->fd);
+    close(currentIsotp->shutdown_fd);
+    free(currentIsotp);
+  }
+} /*** end of cancomm_isotp_free ***/
+
+
+/************************************************************************************//**
+** \brief     Transmits a payload on an ISO-TP channel. Waits until the kernel accepted
+**            the payload, which might take until a previous transfer completed.
+**            cancomm_shutdown() on the context that opened the channel ends the wait.
+** \param     isotp Handle to the ISO-TP channel.
+** \param     data Pointer to the payload.
+** \param     len Number of payload bytes.
+** \return    CANCOMM_TRUE if the payload was accepted for transmission. CANCOMM_FALSE
+**            upon a shutdown request or an error.
+**
+****************************************************************************************/
+uint8_t cancomm_isotp_transmit(cancomm_isotp_t isotp, uint8_t const * data, size_t len)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_isotp * currentIsotp;
+  ssize_t written;
+
+  /* Verify parameters. */
+  assert((isotp != NULL) && (data != NULL) && (len > 0));
+
+  /* Only continue with valid parameters. */
+  if ((isotp != NULL) && (data != NULL) && (len > 0))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentIsotp = (struct cancomm_isotp *)isotp;
+
+    /* Keep trying while a previous transfer is still in progress. The kernel ends a 
+     * stalled transfer by itself, so no timeout is needed here. A shutdown request
+     * still ends the wait right away.
+     */
+    for (;;)
+    {
+      written = write(currentIsotp->fd, data, len);
+      if ((written >= 0) && ((size_t)written == len))
+      {
+        result = CANCOMM_TRUE;
+        break;
+      }
+      if ((written >= 0) || (errno != EAGAIN) ||
+          (cancomm_wait_fd(currentIsotp->fd, currentIsotp->shutdown_fd, POLLOUT, 
+                           NULL) != CANCOMM_TRUE))
+      {
+        break;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_isotp_transmit ***/
+
+
+/************************************************************************************//**
+** \brief     Receives a payload on an ISO-TP channel. Waits for the payload to arrive
+**            completely, unless the timeout expires first. cancomm_shutdown() on the
+**            context that opened the channel also ends the wait.
+** \param     isotp Handle to the ISO-TP channel.
+** \param     data Pointer to where the payload is stored.
+** \param     max Maximum number of bytes that fit in the data buffer.
+** \param     len Pointer to where the number of received payload bytes is stored.
+** \param     timeout_us Maximum time in microseconds to wait for the payload. Zero to not
+**            wait and CANCOMM_TIMEOUT_INFINITE to wait indefinitely.
+** \return    CANCOMM_TRUE if a payload was received. CANCOMM_FALSE upon timeout, upon
+**            a shutdown request, or if the payload did not fit.
+**
+****************************************************************************************/
+uint8_t cancomm_isotp_receive(cancomm_isotp_t isotp, uint8_t * data, size_t max, 
+                              size_t * len, uint32_t timeout_us)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_isotp * currentIsotp;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+  ssize_t received;
+
+  /* Verify parameters. */
+  assert((isotp != NULL) && (data != NULL) && (len != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((isotp != NULL) && (data != NULL) && (len != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentIsotp = (struct cancomm_isotp *)isotp;
+
+    /* Determine the absolute point in time at which to stop waiting. */
+    if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+    {
+      cancomm_deadline_init(&deadline, timeout_us);
+      deadlinePtr = &deadline;
+    }
+    for (;;)
+    {
+      /* Attempt to read a payload. The kernel only reports complete payloads. */
+      received = recv(currentIsotp->fd, data, max, MSG_TRUNC);
+      if (received >= 0)
+      {
+        if ((size_t)received <= max)
+        {
+          *len = (size_t)received;
+          result = CANCOMM_TRUE;
+        }
+        break;
+      }
+      /* Sleep until the payload arrives. Stop upon timeout, shutdown request, signal
+       * interruption or error.
+       */
+      if ((errno != EAGAIN) || (timeout_us == 0) ||
+          (cancomm_wait_fd(currentIsotp->fd, currentIsotp->shutdown_fd, POLLIN, 
+                           deadlinePtr) != CANCOMM_TRUE))
+      {
+        break;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_isotp_receive ***/
+
+
+/************************************************************************************//**
+** \brief     Reads a possibly received CAN message or CAN eror frame in a non-blocking
+**            manner.
+** \param     ctx CAN communication context.
+** \param     id Pointer to where the CAN message identifier is stored.
+** \param     ext Pointer to where the CAN identifier type is stored. CANCOMM_FALSE for
+**            an 11-bit message identifier, CANCOMM_TRUE for 29-bit.
+** \param     len Pointer to where the number of CAN message data bytes is stored.
+** \param     data Pointer to array where the data bytes are stored.
+** \param     flags Pointer to where the bit flags are stored for providing additional
+**            information about the received message:
+**              CANCOMM_FLAG_CANFD_MSG - The message is CAN FD and not CAN classic.
+**              CANCOMM_FLAG_CANERR_MSG - The message is a CAN error frame.
+** \param     timestamp Pointer to where the timestamp of the message is stored. In
+**            microseconds, unless configured otherwise with option CANCOMM_OPT_TIMESTAMP.
+** \return    CANCOMM_TRUE if a new message was received and copied. CANCOMM_FALSE 
+**            otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_receive(cancomm_t ctx, uint32_t * id, uint8_t * ext, uint8_t * len, 
+                        uint8_t * data, uint8_t * flags, uint64_t * timestamp)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct canfd_frame canRxFrame;
+  cancomm_frame_t rxFrame;
+  struct sockaddr_can addr = { 0 };
+  struct iovec iov;
+  struct msghdr msg = { 0 };
+  union
+  {
+    char           buf[CANCOMM_CMSG_BUF_SIZE];
+    struct cmsghdr align;
+  } ctrl;
+  ssize_t frameSize;
+  uint8_t received = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (id != NULL) && (ext != NULL) && (len != NULL) && 
+        (data != NULL) && (timestamp != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (id != NULL) && (ext != NULL) && (len != NULL) && 
+      (data != NULL) && (timestamp != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only receive if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      /* The packet mmap backend reads the frame from its memory mapped ring. */
+      if (currentCtx->pkt_fd >= 0)
+      {
+        received = (cancomm_packet_receive(currentCtx, &rxFrame, 1) == 1) ?
+                   CANCOMM_TRUE : CANCOMM_FALSE;
+      }
+      /* The io_uring backend reads the frame from its completion queue. */
+      else if (currentCtx->uring != NULL)
+      {
+        received = (cancomm_uring_receive(currentCtx, &rxFrame, 1) == 1) ?
+                   CANCOMM_TRUE : CANCOMM_FALSE;
+      }
+      else
+      {
+        /* Attempt to read the next frame from the queue, together with its timestamp
+         * in the ancillary data.
+         */
+        iov.iov_base = &canRxFrame;
+        iov.iov_len = sizeof(canRxFrame);
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl.buf;
+        msg.msg_controllen = sizeof(ctrl.buf);
+        frameSize = recvmsg(currentCtx->socket, &msg, 0);
+        if (frameSize > 0)
+        {
+          /* Convert the frame. This also filters out invalid and remote frames. */
+          if (cancomm_inline_frame_unpack(&canRxFrame, (size_t)frameSize, 
+                                          &rxFrame) != CANCOMM_TRUE)
+          {
+            cancomm_stats_add(&currentCtx->stats.rx_dropped, 1);
+          }
+          else if (cancomm_ifindex_accepted(currentCtx, (uint32_t)addr.can_ifindex) 
+                   == CANCOMM_TRUE)
+          {
+            /* Obtain the timestamp of the reception event and the device it came
+             * from, as the snapshot table keys its entries on the device.
+             */
+            rxFrame.timestamp = cancomm_timestamp_from_cmsg(currentCtx, &msg, 
+                                                cancomm_clock_offset(currentCtx));
+            rxFrame.ifindex = (uint32_t)addr.can_ifindex;
+            cancomm_stats_add(&currentCtx->stats.rx_frames, 1);
+            received = CANCOMM_TRUE;
+          }
+        }
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+        {
+          cancomm_stats_add(&currentCtx->stats.rx_empty, 1);
+        }
+      }
+
+      if (received == CANCOMM_TRUE)
+      {
+        /* Keep the snapshot table up to date. */
+        cancomm_snapshot_update(currentCtx, &rxFrame, 1);
+        /* Copy the frame info to the caller's variables. */
+        *timestamp = rxFrame.timestamp;
+        *id = rxFrame.id;
+        *ext = rxFrame.ext;
+        *len = rxFrame.len;
+        *flags = rxFrame.flags;
+        memcpy(data, rxFrame.data, rxFrame.len);
+        /* Frame successfully read. Update the result accordingly. */
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_receive ***/
+
+
+/************************************************************************************//**
+** \brief     Reads a possibly received CAN message or CAN error frame. Blocks until a
+**            new message was received or until the specified timeout expired. While
+**            waiting, the calling thread sleeps in the kernel, so no CPU time is spent on
+**            polling.
+** \param     ctx CAN communication context.
+** \param     id Pointer to where the CAN message identifier is stored.
+** \param     ext Pointer to where the CAN identifier type is stored. CANCOMM_FALSE for
+**            an 11-bit message identifier, CANCOMM_TRUE for 29-bit.
+** \param     len Pointer to where the number of CAN message data bytes is stored.
+** \param     data Pointer to array where the data bytes are stored.
+** \param     flags Pointer to where the bit flags are stored for providing additional
+**            information about the received message:
+**              CANCOMM_FLAG_CANFD_MSG - The message is CAN FD and not CAN classic.
+**              CANCOMM_FLAG_CANERR_MSG - The message is a CAN error frame.
+** \param     timestamp Pointer to where the timestamp of the message is stored. In
+**            microseconds, unless configured otherwise with option CANCOMM_OPT_TIMESTAMP.
+** \param     timeout_us Maximum time in microseconds to wait for the reception of a
+**            message. A value of 0 makes this function behave like cancomm_receive().
+**            Use CANCOMM_TIMEOUT_INFINITE to wait without a timeout.
+** \return    CANCOMM_TRUE if a new message was received and copied. CANCOMM_FALSE 
+**            if the timeout expired, the wait was interrupted by a signal, or in case
+**            of an error.
+**
+****************************************************************************************/
+uint8_t cancomm_receive_timeout(cancomm_t ctx, uint32_t * id, uint8_t * ext, 
+                                uint8_t * len, uint8_t * data, uint8_t * flags, 
+                                uint64_t * timestamp, uint32_t timeout_us)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (id != NULL) && (ext != NULL) && (len != NULL) && 
+        (data != NULL) && (timestamp != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (id != NULL) && (ext != NULL) && (len != NULL) && 
+      (data != NULL) && (timestamp != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Determine the absolute point in time at which the wait operation should end. */
+    if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+    {
+      cancomm_deadline_init(&deadline, timeout_us);
+      deadlinePtr = &deadline;
+    }
+
+    /* Keep trying until a message was received. Note that the read operation in
+     * cancomm_receive() can still return without a message after the socket signaled
+     * that data is available. For example when it was a remote frame, which is ignored.
+     */
+    for (;;)
+    {
+      /* Attempt to read the next message from the queue. */
+      result = cancomm_receive(currentCtx, id, ext, len, data, flags, timestamp);
+      /* Done if a message was received or if the caller does not want to wait. */
+      if ((result == CANCOMM_TRUE) || (timeout_us == 0))
+      {
+        break;
+      }
+      /* Sleep until the socket has data available for reading. Stop trying upon 
+       * timeout, signal interruption or error.
+       */
+      if (cancomm_wait_event(currentCtx, POLLIN, deadlinePtr) != CANCOMM_TRUE)
+      {
+        break;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_receive_timeout ***/
+
+
+/************************************************************************************//**
+** \brief     Reads all possibly received CAN messages and CAN error frames, up to the
+**            specified maximum, in a non-blocking manner. Compared to calling
+**            cancomm_receive() repeatedly, this function needs far fewer system calls,
+**            as it requests multiple frames from the kernel at once.
+** \param     ctx CAN communication context.
+** \param     frames Pointer to the caller owned array where the received frames are
+**            stored.
+** \param     max Maximum number of frames that fit in the array.
+** \param     count Pointer to where the number of frames actually stored in the array
+**            is written.
+** \return    CANCOMM_TRUE if at least one new message was received and copied.
+**            CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_receive_batch(cancomm_t ctx, cancomm_frame_t * frames, size_t max, 
+                              size_t * count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (count != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (count != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+    /* Reset the frame count. */
+    *count = 0;
+
+    /* Only receive if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      /* Read the frames with the configured backend. */
+      if (currentCtx->pkt_fd >= 0)
+      {
+        *count = cancomm_packet_receive(currentCtx, frames, max);
+      }
+      else if (currentCtx->uring != NULL)
+      {
+        *count = cancomm_uring_receive(currentCtx, frames, max);
+      }
+      else
+      {
+        *count = cancomm_raw_receive(currentCtx, frames, max);
+      }
+      /* Keep the snapshot table up to date. */
+      cancomm_snapshot_update(currentCtx, frames, *count);
+
+      /* Update the result. */
+      if (*count > 0)
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_receive_batch ***/
+
+
+/************************************************************************************//**
+** \brief     Reads the received CAN messages and CAN error frames in a batch, up to the
+**            specified maximum. If no frame is available, it waits for one first. Once
+**            the first frame arrived, it keeps collecting frames until the number of
+**            frames configured with option CANCOMM_OPT_COALESCE_FRAMES is there, or until
+**            the time configured with option CANCOMM_OPT_COALESCE_US passed. In between,
+**            it sleeps for as long as the frames are expected to take to arrive, based
+**            on their measured arrival rate, instead of waking up for each frame. This
+**            way latency tolerant applications, such as loggers, get full batches with
+**            few context switches. Without these options configured, it returns as soon
+**            as frames are available.
+** \param     ctx CAN communication context.
+** \param     frames Pointer to the caller owned array where the received frames are
+**            stored.
+** \param     max Maximum number of frames that fit in the array.
+** \param     count Pointer to where the number of frames actually stored in the array
+**            is written.
+** \param     timeout_us Maximum time in microseconds to wait for the first frame to
+**            arrive. Zero to not wait and CANCOMM_TIMEOUT_INFINITE to wait indefinitely.
+** \return    CANCOMM_TRUE if at least one new message was received and copied. 
+**            CANCOMM_FALSE upon timeout, signal interruption, shutdown or error.
+**
+****************************************************************************************/
+uint8_t cancomm_receive_batch_timeout(cancomm_t ctx, cancomm_frame_t * frames, 
+                                      size_t max, size_t * count, uint32_t timeout_us)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+  struct timespec wakeTime;
+  size_t received;
+  size_t threshold;
+  size_t firstCnt;
+  uint64_t startTime;
+  uint64_t endTime;
+  uint64_t now;
+  uint64_t wake;
+  uint8_t slept = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (count != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (count != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+    /* Reset the frame count. */
+    *count = 0;
+
+    /* Determine the absolute point in time at which the wait operation should end. */
+    if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+    {
+      cancomm_deadline_init(&deadline, timeout_us);
+      deadlinePtr = &deadline;
+    }
+
+    /* Wait for the first frames, in the same way as cancomm_receive_timeout(). */
+    for (;;)
+    {
+      (void)cancomm_receive_batch(currentCtx, frames, max, count);
+      if ((*count > 0) || (timeout_us == 0))
+      {
+        break;
+      }
+      if (cancomm_wait_event(currentCtx, POLLIN, deadlinePtr) != CANCOMM_TRUE)
+      {
+        break;
+      }
+    }
+
+    /* Collect more frames, until the configured number of frames is there or the 
+     * configured time passed. The kernel does not support a receive low watermark on
+     * CAN sockets, so this sleeps until the time at which the missing frames are 
+     * expected to have arrived. The arrival rate is measured while collecting.
+     */
+    threshold = (currentCtx->opt_coalesce_frames < max) ? 
+                currentCtx->opt_coalesce_frames : max;
+    if ((*count > 0) && (*count < threshold) && (currentCtx->opt_coalesce_us > 0))
+    {
+      firstCnt = *count;
+      startTime = cancomm_monotonic_ns();
+      endTime = startTime + ((uint64_t)currentCtx->opt_coalesce_us * 1000ULL);
+      while ((*count < threshold) && (!atomic_load(&currentCtx->shutdown_requested)))
+      {
+        now = cancomm_monotonic_ns();
+        if (now >= endTime)
+        {
+          break;
+        }
+        /* Update the estimated time between two frames, once there is something to
+         * base it on.
+         */
+        if ((slept == CANCOMM_TRUE) || (*count > firstCnt))
+        {
+          currentCtx->coalesce_interval = (now - startTime) / 
+                                          (((*count - firstCnt) > 0) ? 
+                                           (*count - firstCnt) : 1U);
+        }
+        if (currentCtx->coalesce_interval > 0)
+        {
+          /* Sleep until the missing frames are expected, but not past the configured
+           * time. Only the shutdown event ends the sleep early.
+           */
+          wake = endTime;
+          if (currentCtx->coalesce_interval < ((endTime - now) / (threshold - *count)))
+          {
+            wake = now + (currentCtx->coalesce_interval * (threshold - *count));
+          }
+          wakeTime.tv_sec = (time_t)(wake / 1000000000ULL);
+          wakeTime.tv_nsec = (long)(wake % 1000000000ULL);
+          if (cancomm_wait_fd(currentCtx->shutdown_fd, -1, POLLIN, 
+                              &wakeTime) == CANCOMM_TRUE)
+          {
+            break;
+          }
+        }
+        else
+        {
+          /* Nothing known yet about the arrival rate, so wait for the next frame. */
+          wakeTime.tv_sec = (time_t)(endTime / 1000000000ULL);
+          wakeTime.tv_nsec = (long)(endTime % 1000000000ULL);
+          (void)cancomm_wait_event(currentCtx, POLLIN, &wakeTime);
+        }
+        slept = CANCOMM_TRUE;
+        /* Append the frames that arrived in the meantime. */
+        if (cancomm_receive_batch(currentCtx, &frames[*count], max - *count, 
+                                  &received) == CANCOMM_TRUE)
+        {
+          *count += received;
+        }
+      }
+    }
+
+    /* Update the result. */
+    if (*count > 0)
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_receive_batch_timeout ***/
+
+
+/************************************************************************************//**
+** \brief     Starts the background reader. An internal thread then drains the socket in
+**            batches into a pre-allocated lock-free ring buffer, from which frames are
+**            obtained with cancomm_reader_pop() and cancomm_reader_pop_batch(), without
+**            any system call. This moves the cost of the system calls off the thread
+**            that processes the frames. While the background reader runs, the
+**            cancomm_receive() functions should not be used. Exactly one thread at a
+**            time should obtain frames from the ring. The background reader stops
+**            automatically upon disconnect.
+** \param     ctx CAN communication context.
+** \param     capacity Number of frames that the ring buffer holds. Rounded up to the 
+**            next power of two. Frames that arrive while the ring is full are dropped
+**            and counted, see cancomm_reader_drops().
+** \return    CANCOMM_TRUE if the background reader was started. CANCOMM_FALSE
+**            otherwise, for example when not connected or already running.
+**
+****************************************************************************************/
+uint8_t cancomm_reader_start(cancomm_t ctx, uint32_t capacity)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_ring * ring;
+  size_t slotCnt = 1;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (capacity > 0));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (capacity > 0))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only start if connected and not yet running. */
+    if ((currentCtx->socket != CANCOMM_INVALID_SOCKET) && (currentCtx->ring == NULL))
+    {
+      /* Round the capacity up to the next power of two, so indices can be masked. */
+      while (slotCnt < capacity)
+      {
+        slotCnt <<= 1;
+      }
+      /* Reuse the spare ring, if large enough. Otherwise allocate a new one. */
+      if ((currentCtx->ring_spare != NULL) && 
+          (currentCtx->ring_spare->slots_allocated >= slotCnt))
+      {
+        ring = currentCtx->ring_spare;
+        currentCtx->ring_spare = NULL;
+      }
+      else
+      {
+        ring = cancomm_ring_alloc(slotCnt);
+      }
+      if (ring != NULL)
+      {
+        /* Initialize the ring. */
+        atomic_init(&ring->head, 0);
+        ring->tail_cached = 0;
+        atomic_init(&ring->tail, 0);
+        ring->head_cached = 0;
+        atomic_init(&ring->drops, 0);
+        atomic_init(&ring->stop, false);
+        ring->mask = slotCnt - 1U;
+
+        /* Create the event file descriptor for waking up the thread upon stop. */
+        currentCtx->reader_wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (currentCtx->reader_wakefd >= 0)
+        {
+          /* Start the thread. */
+          currentCtx->ring = ring;
+          if (pthread_create(&currentCtx->reader_thread, NULL, cancomm_reader_thread,
+                             currentCtx) == 0)
+          {
+            result = CANCOMM_TRUE;
+          }
+          else
+          {
+            currentCtx->ring = NULL;
+            close(currentCtx->reader_wakefd);
+            currentCtx->reader_wakefd = -1;
+          }
+        }
+        /* Keep the ring as the spare one upon error. */
+        if (result != CANCOMM_TRUE)
+        {
+          cancomm_ring_release(currentCtx, ring);
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_reader_start ***/
+
+
+/************************************************************************************//**
+** \brief     Stops the background reader, if running. Frames that are still in the ring
+**            buffer are discarded. The memory of the ring buffer is kept for the next
+**            start, see cancomm_reserve().
+** \param     ctx CAN communication context.
+**
+****************************************************************************************/
+void cancomm_reader_stop(cancomm_t ctx)
+{
+  struct cancomm_ctx * currentCtx;
+  uint64_t wakeValue = 1;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only stop if actually running. */
+    if (currentCtx->ring != NULL)
+    {
+      /* Request the thread to stop and wake it up, in case it waits for frames. */
+      atomic_store(&currentCtx->ring->stop, true);
+      (void)write(currentCtx->reader_wakefd, &wakeValue, sizeof(wakeValue));
+      /* Wait for the thread to actually stop. */
+      (void)pthread_join(currentCtx->reader_thread, NULL);
+      /* Release the resources. */
+      close(currentCtx->reader_wakefd);
+      currentCtx->reader_wakefd = -1;
+      cancomm_ring_release(currentCtx, currentCtx->ring);
+      currentCtx->ring = NULL;
+    }
+  }
+} /*** end of cancomm_reader_stop ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to allocate a ring buffer for the background reader. The
+**            ring and its slots are allocated in one go, aligned to a cache line. All
+**            slots get touched, such that the reader thread never page faults on them.
+** \param     slotCnt Number of slots. Must be a power of two.
+** \return    Pointer to the ring if successful, NULL otherwise.
+**
+****************************************************************************************/
+static struct cancomm_ring * cancomm_ring_alloc(size_t slotCnt)
+{
+  struct cancomm_ring * result;
+  size_t ringSize;
+
+  /* The size must be a multiple of the alignment. */
+  ringSize = sizeof(struct cancomm_ring) + (slotCnt * sizeof(cancomm_frame_t));
+  ringSize = (ringSize + CANCOMM_CACHE_LINE_SIZE - 1U) & 
+             ~((size_t)CANCOMM_CACHE_LINE_SIZE - 1U);
+  result = aligned_alloc(CANCOMM_CACHE_LINE_SIZE, ringSize);
+  if (result != NULL)
+  {
+    result->mask = slotCnt - 1U;
+    result->slots = (cancomm_frame_t *)(void *)(result + 1);
+    result->slots_allocated = slotCnt;
+    memset(result->slots, 0, slotCnt * sizeof(cancomm_frame_t));
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_ring_alloc ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to release a ring buffer that the background reader no
+**            longer uses. It becomes the spare ring of the context, for reuse upon the
+**            next start, unless the spare ring is larger.
+** \param     ctx Non-opaque CAN communication context.
+** \param     ring Pointer to the ring to release.
+**
+****************************************************************************************/
+static void cancomm_ring_release(struct cancomm_ctx * ctx, struct cancomm_ring * ring)
+{
+  /* Verify parameters. */
+  assert((ctx != NULL) && (ring != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (ring != NULL))
+  {
+    if ((ctx->ring_spare == NULL) || 
+        (ctx->ring_spare->slots_allocated < ring->slots_allocated))
+    {
+      free(ctx->ring_spare);
+      ctx->ring_spare = ring;
+    }
+    else
+    {
+      free(ring);
+    }
+  }
+} /*** end of cancomm_ring_release ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the oldest frame from the ring buffer of the background reader,
+**            without blocking and without any system call.
+** \param     ctx CAN communication context.
+** \param     frame Pointer to where the frame is stored.
+** \return    CANCOMM_TRUE if a frame was obtained. CANCOMM_FALSE if the ring is empty or
+**            the background reader is not running.
+**
+****************************************************************************************/
+uint8_t cancomm_reader_pop(cancomm_t ctx, cancomm_frame_t * frame)
+{
+  size_t count = 0;
+
+  /* Obtaining a single frame is just a batch of one. */
+  (void)cancomm_reader_pop_batch(ctx, frame, 1, &count);
+
+  /* Give the result back to the caller. */
+  return (count > 0) ? CANCOMM_TRUE : CANCOMM_FALSE;
+} /*** end of cancomm_reader_pop ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the oldest frames from the ring buffer of the background reader, up
+**            to the specified maximum, without blocking and without any system call.
+** \param     ctx CAN communication context.
+** \param     frames Pointer to the caller owned array where the frames are stored.
+** \param     max Maximum number of frames that fit in the array.
+** \param     count Pointer to where the number of frames actually stored in the array
+**            is written.
+** \return    CANCOMM_TRUE if at least one frame was obtained. CANCOMM_FALSE if the ring
+**            is empty or the background reader is not running.
+**
+****************************************************************************************/
+uint8_t cancomm_reader_pop_batch(cancomm_t ctx, cancomm_frame_t * frames, size_t max,
+                                 size_t * count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_ring * ring;
+  size_t tail;
+  size_t available;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (count != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (count != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+    *count = 0;
+
+    /* Only continue if the background reader is running. */
+    ring = currentCtx->ring;
+    if (ring != NULL)
+    {
+      /* Determine the number of available frames. Only look at the producer's index,
+       * if the cached copy of it says the ring is empty.
+       */
+      tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+      available = ring->head_cached - tail;
+      if (available == 0)
+      {
+        ring->head_cached = atomic_load_explicit(&ring->head, memory_order_acquire);
+        available = ring->head_cached - tail;
+      }
+      if (available > max)
+      {
+        available = max;
+      }
+      /* Copy the frames. */
+      for (size_t idx = 0; idx < available; idx++)
+      {
+        frames[idx] = ring->slots[(tail + idx) & ring->mask];
+      }
+      /* Hand the slots back to the producer. */
+      if (available > 0)
+      {
+        atomic_store_explicit(&ring->tail, tail + available, memory_order_release);
+        *count = available;
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_reader_pop_batch ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the number of frames that the background reader dropped, because
+**            its ring buffer was full.
+** \param     ctx CAN communication context.
+** \return    Number of dropped frames since the background reader was started. Zero if
+**            the background reader is not running.
+**
+****************************************************************************************/
+uint64_t cancomm_reader_drops(cancomm_t ctx)
+{
+  uint64_t result = 0;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only read the counter if the background reader is running. */
+    if (currentCtx->ring != NULL)
+    {
+      result = atomic_load_explicit(&currentCtx->ring->drops, memory_order_relaxed);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_reader_drops ***/
+
+
+/************************************************************************************//**
+** \brief     Enables the snapshot table of the context. From then on, the receive 
+**            functions and the background reader store the latest frame of each
+**            received CAN message in the table. Look it up at any time and from any
+**            thread with cancomm_snapshot_get(), without disturbing the reception. Error
+**            frames are not stored. Once the table is full, frames of new CAN messages
+**            are just not stored.
+** \param     ctx CAN communication context.
+** \param     capacity Maximum number of different CAN messages to store.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. Also fails if already
+**            enabled.
+**
+****************************************************************************************/
+uint8_t cancomm_snapshot_enable(cancomm_t ctx, uint32_t capacity)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_snapshot * snapshot;
+  size_t entryCnt = 1;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (capacity > 0));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (capacity > 0))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only enable if not yet enabled. */
+    if (currentCtx->snapshot == NULL)
+    {
+      /* Size the array to a power of two, with at least twice the capacity. */
+      while (entryCnt < ((size_t)capacity * 2U))
+      {
+        entryCnt <<= 1;
+      }
+      /* Allocate the table with all entries unused. */
+      snapshot = calloc(1, sizeof(struct cancomm_snapshot) + 
+                        (entryCnt * sizeof(struct cancomm_snapshot_entry)));
+      if (snapshot != NULL)
+      {
+        snapshot->mask = entryCnt - 1U;
+        snapshot->max = capacity;
+        snapshot->used = 0;
+        for (size_t idx = 0; idx < entryCnt; idx++)
+        {
+          atomic_init(&snapshot->entries[idx].key, 0);
+          atomic_init(&snapshot->entries[idx].seq, 0);
+        }
+        currentCtx->snapshot = snapshot;
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_snapshot_enable ***/
+
+
+/************************************************************************************//**
+** \brief     Disables the snapshot table of the context and releases its memory. Only
+**            call this function when no other thread accesses the table. So with the
+**            background reader stopped and without concurrent cancomm_snapshot_get()
+**            calls.
+** \param     ctx CAN communication context.
+**
+****************************************************************************************/
+void cancomm_snapshot_disable(cancomm_t ctx)
+{
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Release the table, if enabled. */
+    if (currentCtx->snapshot != NULL)
+    {
+      free(currentCtx->snapshot);
+      currentCtx->snapshot = NULL;
+    }
+  }
+} /*** end of cancomm_snapshot_disable ***/
+
+
+/************************************************************************************//**
+** \brief     Looks up the latest received frame of a CAN message in the snapshot table.
+**            Never blocks the receive path. Safe to call from any thread.
+** \param     ctx CAN communication context.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
+**            29-bit.
+** \param     ifindex Interface index of the CAN device that the message was received
+**            on. Zero selects the connected device, or the first one of a device set.
+** \param     frame Pointer to where the latest frame is stored.
+** \param     count Pointer to where the number of times that the CAN message was 
+**            received is stored. Can be NULL.
+** \return    CANCOMM_TRUE if the CAN message is in the table. CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_snapshot_get(cancomm_t ctx, uint32_t id, uint8_t ext, uint32_t ifindex,
+                             cancomm_frame_t * frame, uint64_t * count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_snapshot_entry * entry;
+  unsigned int seqBegin;
+  unsigned int seqEnd;
+  uint64_t entryCount;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only look up if enabled. */
+    if (currentCtx->snapshot != NULL)
+    {
+      if (ifindex == 0)
+      {
+        ifindex = currentCtx->tx_ifindex;
+      }
+      entry = cancomm_snapshot_find(currentCtx->snapshot, 
+                                    cancomm_frame_key(id, ext, ifindex), 
+                                    CANCOMM_FALSE);
+      if (entry != NULL)
+      {
+        /* Copy the entry, until the copy was not disturbed by the writer. */
+        do
+        {
+          seqBegin = atomic_load_explicit(&entry->seq, memory_order_acquire);
+          if ((seqBegin & 1U) != 0)
+          {
+            continue;
+          }
+          frame->len = entry->len;
+          frame->flags = entry->flags;
+          frame->timestamp = entry->timestamp;
+          entryCount = entry->count;
+          memcpy(frame->data, entry->data, sizeof(frame->data));
+          atomic_thread_fence(memory_order_acquire);
+          seqEnd = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+        }
+        while (((seqBegin & 1U) != 0) || (seqBegin != seqEnd));
+        frame->id = id;
+        frame->ext = ext;
+        frame->ifindex = ifindex;
+        if (count != NULL)
+        {
+          *count = entryCount;
+        }
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_snapshot_get ***/
+
+
+/************************************************************************************//**
+** \brief     Creates a recorder that continuously appends the frames received by the
+**            context to a set of rotating recording files. Each file is allocated with
+**            its full size upfront and written through a shared memory mapping, in a
+**            compact binary format with fixed size records. This avoids a system call
+**            and formatting per frame. Once a file is full, the recorder continues with
+**            the next one. The files are named after the path, with the index of the
+**            file appended as in "path.0", "path.1" and so on. After the last file, the
+**            first one is overwritten again.
+** \param     ctx CAN communication context to capture the frames from.
+** \param     path Base path of the recording files.
+** \param     file_size Size of a single recording file in bytes.
+** \param     file_count Number of files to rotate through.
+** \param     sync_ms Interval in milliseconds for handing the recorded data to the
+**            kernel for writing back to storage. Zero to leave the write back entirely
+**            to the kernel.
+** \return    Handle to the recorder, if successful. NULL otherwise. Release it with
+**            cancomm_recorder_free() once you no longer need it.
+**
+****************************************************************************************/
+cancomm_recorder_t cancomm_recorder_new(cancomm_t ctx, char const * path, 
+                                        uint64_t file_size, uint32_t file_count, 
+                                        uint32_t sync_ms)
+{
+  cancomm_recorder_t result = NULL;
+  struct cancomm_recorder * newRecorder;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (path != NULL) && (file_count > 0));
+
+  /* Only continue with valid parameters and if at least one record fits in a file. */
+  if ((ctx != NULL) && (path != NULL) && (file_count > 0) && 
+      (file_size >= (CANCOMM_RECORD_HEADER_SIZE + sizeof(struct cancomm_record))))
+  {
+    newRecorder = malloc(sizeof(struct cancomm_recorder));
+    if (newRecorder != NULL)
+    {
+      /* Initialize the recorder members. */
+      newRecorder->ctx = (struct cancomm_ctx *)ctx;
+      newRecorder->path = strdup(path);
+      newRecorder->records_max = (file_size - CANCOMM_RECORD_HEADER_SIZE) / 
+                                 sizeof(struct cancomm_record);
+      newRecorder->file_count = file_count;
+      newRecorder->sync_interval = (uint64_t)sync_ms * 1000000U;
+      newRecorder->sequence = 0;
+      newRecorder->fd = -1;
+      newRecorder->map_size = 0;
+      newRecorder->map = NULL;
+      newRecorder->header = NULL;
+      newRecorder->records = NULL;
+      newRecorder->records_synced = 0;
+      newRecorder->sync_time = 0;
+      /* Create the first recording file. */
+      if ((newRecorder->path != NULL) && 
+          (cancomm_recorder_file_open(newRecorder) == CANCOMM_TRUE))
+      {
+        result = (cancomm_recorder_t)newRecorder;
+      }
+      else
+      {
+        free(newRecorder->path);
+        free(newRecorder);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_recorder_new ***/
+
+
+/************************************************************************************//**
+** \brief     Releases a recorder. The current recording file is written back to storage
+**            and shrunk to the size of the records that it actually holds.
+** \param     recorder Handle to the recorder.
+**
+****************************************************************************************/
+void cancomm_recorder_free(cancomm_recorder_t recorder)
+{
+  struct cancomm_recorder * currentRecorder;
+
+  /* Verify parameter. */
+  assert(recorder != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (recorder != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentRecorder = (struct cancomm_recorder *)recorder;
+
+    cancomm_recorder_file_close(currentRecorder, CANCOMM_TRUE);
+    free(currentRecorder->path);
+    free(currentRecorder);
+  }
+} /*** end of cancomm_recorder_free ***/
+
+
+/************************************************************************************//**
+** \brief     Appends frames to the recording. Useful for frames obtained otherwise, for
+**            example from the background reader.
+** \param     recorder Handle to the recorder.
+** \param     frames Pointer to the array with the frames to append.
+** \param     count Number of frames in the array.
+** \return    CANCOMM_TRUE if all frames were appended. CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_recorder_write(cancomm_recorder_t recorder, 
+                               cancomm_frame_t const * frames, size_t count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_recorder * currentRecorder;
+  struct cancomm_record * record;
+  uint64_t recordCount;
+  uint32_t lastIfindex = 0;
+  size_t idx;
+
+  /* Verify parameters. */
+  assert((recorder != NULL) && ((frames != NULL) || (count == 0)));
+
+  /* Only continue with valid parameters. */
+  if ((recorder != NULL) && ((frames != NULL) || (count == 0)))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentRecorder = (struct cancomm_recorder *)recorder;
+
+    /* Only write if a recording file is open. It is not after a failed rotation. */
+    if (currentRecorder->header != NULL)
+    {
+      result = CANCOMM_TRUE;
+      recordCount = currentRecorder->header->record_count;
+      for (idx = 0; idx < count; idx++)
+      {
+        /* Continue with the next file, once the current one is full. */
+        if (recordCount == currentRecorder->records_max)
+        {
+          currentRecorder->header->record_count = recordCount;
+          cancomm_recorder_file_close(currentRecorder, CANCOMM_FALSE);
+          currentRecorder->sequence++;
+          if (cancomm_recorder_file_open(currentRecorder) != CANCOMM_TRUE)
+          {
+            result = CANCOMM_FALSE;
+            break;
+          }
+          recordCount = 0;
+          lastIfindex = 0;
+        }
+        /* Note the name of the CAN device once. Frames tend to come from the same
+         * device in a row, so skip the lookup in that case.
+         */
+        if ((frames[idx].ifindex != lastIfindex) && (frames[idx].ifindex != 0))
+        {
+          lastIfindex = frames[idx].ifindex;
+          cancomm_recorder_device_add(currentRecorder->header, lastIfindex);
+        }
+        /* Store the frame. The data is copied in full, to keep it a fixed copy. */
+        record = &currentRecorder->records[recordCount];
+        record->timestamp = frames[idx].timestamp;
+        record->id = frames[idx].id;
+        record->ifindex = frames[idx].ifindex;
+        record->ext = frames[idx].ext;
+        record->len = frames[idx].len;
+        record->flags = frames[idx].flags;
+        memcpy(record->data, frames[idx].data, CANCOMM_DATA_LEN_MAX);
+        recordCount++;
+      }
+      /* Publish the new number of records, if the file is still open. */
+      if (currentRecorder->header != NULL)
+      {
+        currentRecorder->header->record_count = recordCount;
+        cancomm_recorder_sync(currentRecorder);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_recorder_write ***/
+
+
+/************************************************************************************//**
+** \brief     Receives the frames that are available on the context and appends them to
+**            the recording, in batches. If no frame is available, it waits for one
+**            first. Call this function in a loop to record continuously.
+** \param     recorder Handle to the recorder.
+** \param     timeout_us Maximum time in microseconds to wait for a frame to arrive. Zero
+**            to not wait and CANCOMM_TIMEOUT_INFINITE to wait indefinitely.
+** \param     count Pointer to where the number of recorded frames is stored.
+** \return    CANCOMM_TRUE if frames were recorded. CANCOMM_FALSE upon timeout, signal
+**            interruption or error.
+**
+****************************************************************************************/
+uint8_t cancomm_recorder_capture(cancomm_recorder_t recorder, uint32_t timeout_us,
+                                 size_t * count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_recorder * currentRecorder;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+  size_t received;
+  uint8_t writeOk = CANCOMM_TRUE;
+
+  /* Verify parameters. */
+  assert((recorder != NULL) && (count != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((recorder != NULL) && (count != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentRecorder = (struct cancomm_recorder *)recorder;
+    /* Reset the frame count. */
+    *count = 0;
+
+    /* Determine the absolute point in time at which to stop waiting. */
+    if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+    {
+      cancomm_deadline_init(&deadline, timeout_us);
+      deadlinePtr = &deadline;
+    }
+    for (;;)
+    {
+      /* Drain whatever is available, a batch at a time. */
+      while (cancomm_receive_batch(currentRecorder->ctx, currentRecorder->frames, 
+                                   CANCOMM_RECORDER_BATCH_SIZE, 
+                                   &received) == CANCOMM_TRUE)
+      {
+        if (cancomm_recorder_write(recorder, currentRecorder->frames, 
+                                   received) != CANCOMM_TRUE)
+        {
+          writeOk = CANCOMM_FALSE;
+          break;
+        }
+        *count += received;
+        if (received < CANCOMM_RECORDER_BATCH_SIZE)
+        {
+          break;
+        }
+      }
+      /* Done if frames were recorded, upon a write error or if the caller does not 
+       * want to wait.
+       */
+      if ((*count > 0) || (writeOk != CANCOMM_TRUE) || (timeout_us == 0))
+      {
+        break;
+      }
+      /* Sleep until a frame arrives. Stop upon timeout, signal interruption or 
+       * error.
+       */
+      if (cancomm_wait_event(currentRecorder->ctx, POLLIN, deadlinePtr) != CANCOMM_TRUE)
+      {
+        break;
+      }
+    }
+    /* Update the result. */
+    if ((*count > 0) && (writeOk == CANCOMM_TRUE))
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_recorder_capture ***/
+
+
+/************************************************************************************//**
+** \brief     Converts a recording file to a text based log file format, for further
+**            processing with other tools.
+** \param     recording Path of the recording file.
+** \param     output Path of the log file to create.
+** \param     format Format of the log file (CANCOMM_EXPORT_xxx).
+** \return    CANCOMM_TRUE if successful. CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_recording_export(char const * recording, char const * output, 
+                                 uint32_t format)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_recording_map recordingMap;
+  FILE * logFile;
+  uint8_t writeOk;
+
+  /* Verify parameters. */
+  assert((recording != NULL) && (output != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((recording != NULL) && (output != NULL) && 
+      ((format == CANCOMM_EXPORT_CANDUMP) || (format == CANCOMM_EXPORT_ASC)))
+  {
+    /* Map the recording file. */
+    if (cancomm_recording_open(recording, &recordingMap) == CANCOMM_TRUE)
+    {
+      /* Create the log file and write the records in the requested format. */
+      logFile = fopen(output, "w");
+      if (logFile != NULL)
+      {
+        if (format == CANCOMM_EXPORT_CANDUMP)
+        {
+          cancomm_export_candump(logFile, recordingMap.header, recordingMap.records, 
+                                 recordingMap.count);
+        }
+        else
+        {
+          cancomm_export_asc(logFile, recordingMap.header, recordingMap.records, 
+                             recordingMap.count);
+        }
+        writeOk = (ferror(logFile) == 0) ? CANCOMM_TRUE : CANCOMM_FALSE;
+        if ((fclose(logFile) == 0) && (writeOk == CANCOMM_TRUE))
+        {
+          result = CANCOMM_TRUE;
+        }
+      }
+      cancomm_recording_close(&recordingMap);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_recording_export ***/
+
+
+/************************************************************************************//**
+** \brief     Transmits the frames of a recording file, while keeping their original
+**            timing. Each frame is sent once the absolute point in time of its
+**            timestamp, relative to the first frame, is reached. Frames that are due
+**            at the same time are handed to the kernel together, with a single system
+**            call. So the timing does not drift and a replay that fell behind, catches
+**            up. The replay uses the same CAN devices as the recording, if the context
+**            is connected to a set of devices that includes them. Otherwise the frames
+**            go to the connected device, or to the first one of a device set. Error 
+**            frames are skipped. This function returns once the replay completes.
+**            With option CANCOMM_OPT_REPLAY_TXTIME_US, the frames are instead queued
+**            the configured time ahead, with their due time as the launch time 
+**            (SO_TXTIME). The kernel then holds them until that time, for example with
+**            the ETF queuing discipline, so the timing no longer depends on how 
+**            precisely the thread wakes up. Without kernel support for SO_TXTIME, the
+**            replay falls back on sleeping until each frame is due.
+** \param     ctx CAN communication context.
+** \param     recording Path of the recording file.
+** \param     speed Replay speed in percent. CANCOMM_REPLAY_SPEED_ORIGINAL (100) for the
+**            original timing, 200 for twice as fast, 50 for half the speed and so on.
+**            CANCOMM_REPLAY_SPEED_MAX to transmit the frames as fast as the CAN device
+**            accepts them.
+** \param     sent Pointer to where the number of transmitted frames is stored.
+** \return    CANCOMM_TRUE if all frames were transmitted. CANCOMM_FALSE if a frame could
+**            not be transmitted, upon signal interruption, or in case of an error.
+**
+****************************************************************************************/
+uint8_t cancomm_replay(cancomm_t ctx, char const * recording, uint32_t speed, 
+                       uint64_t * sent)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_recording_map recordingMap;
+  struct cancomm_record const * record;
+  cancomm_frame_t frames[CANCOMM_BATCH_CHUNK_SIZE];
+  uint32_t ifindexMap[CANCOMM_RECORD_DEVICES_MAX] = { 0 };
+  struct timespec sleepTime;
+  struct timespec taiTime;
+  uint64_t startTime;
+  uint64_t firstTimestamp;
+  uint64_t deadline;
+  uint64_t now = 0;
+  uint64_t idx = 0;
+  uint64_t lead = 0;
+  uint64_t taiOffset = 0;
+  uint32_t deviceIdx;
+  size_t frameCnt;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (recording != NULL) && (sent != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (recording != NULL) && (sent != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+    /* Reset the transmitted frame count. */
+    *sent = 0;
+
+    /* Only replay if actually connected and if the recording file is valid. */
+    if ((currentCtx->socket != CANCOMM_INVALID_SOCKET) && 
+        (cancomm_recording_open(recording, &recordingMap) == CANCOMM_TRUE))
+    {
+      /* Map the recorded CAN devices to the ones on this system, by their name. Zero
+       * selects the default device for transmission.
+       */
+      for (deviceIdx = 0; (deviceIdx < recordingMap.header->devices_cnt) && 
+                          (deviceIdx < CANCOMM_RECORD_DEVICES_MAX); deviceIdx++)
+      {
+        if (currentCtx->ifindex == 0)
+        {
+          ifindexMap[deviceIdx] = 
+            if_nametoindex(recordingMap.header->devices[deviceIdx].name);
+          if (cancomm_ifindex_accepted(currentCtx, 
+                                       ifindexMap[deviceIdx]) != CANCOMM_TRUE)
+          {
+            ifindexMap[deviceIdx] = 0;
+          }
+        }
+      }
+      /* Queue the frames ahead of time with launch times, if configured and supported
+       * by the kernel. Launch times are based on CLOCK_TAI, so determine its offset.
+       */
+      if ((speed != CANCOMM_REPLAY_SPEED_MAX) && (currentCtx->opt_replay_txtime_us > 0) &&
+          (cancomm_txtime_enable(currentCtx) == CANCOMM_TRUE))
+      {
+        lead = (uint64_t)currentCtx->opt_replay_txtime_us * 1000ULL;
+        (void)clock_gettime(CLOCK_TAI, &taiTime);
+        taiOffset = ((uint64_t)taiTime.tv_sec * 1000000000ULL) + 
+                    (uint64_t)taiTime.tv_nsec - cancomm_monotonic_ns();
+      }
+      result = CANCOMM_TRUE;
+      startTime = cancomm_monotonic_ns();
+      firstTimestamp = (recordingMap.count > 0) ? 
+                       cancomm_recording_time_ns(recordingMap.header, 
+                                                 recordingMap.records[0].timestamp) : 0;
+      while ((idx < recordingMap.count) && (result == CANCOMM_TRUE))
+      {
+        /* Sleep until the next frame is due, or until it needs queuing with its
+         * launch time. The absolute deadline prevents the time spent on transmitting
+         * from adding up.
+         */
+        if (speed != CANCOMM_REPLAY_SPEED_MAX)
+        {
+          deadline = cancomm_replay_deadline(&recordingMap, &recordingMap.records[idx],
+                                             startTime, firstTimestamp, speed);
+          deadline = (deadline > lead) ? (deadline - lead) : 0U;
+          if (deadline > now)
+          {
+            sleepTime.tv_sec = (time_t)(deadline / 1000000000U);
+            sleepTime.tv_nsec = (long)(deadline % 1000000000U);
+            if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sleepTime, NULL) != 0)
+            {
+              /* Interrupted by a signal. */
+              result = CANCOMM_FALSE;
+              break;
+            }
+            now = cancomm_monotonic_ns();
+          }
+          /* Launch times must lie ahead of the actual time, which moved on while
+           * transmitting the previous frames.
+           */
+          else if (lead > 0)
+          {
+            now = cancomm_monotonic_ns();
+          }
+        }
+        /* Collect all frames that are due by now. With launch times, also the ones
+         * that are due within twice the lead time. Each frame goes out at its due
+         * time, but not sooner than the lead time from now. The kernel would drop a
+         * frame with a launch time in the past. This keeps the frames in order.
+         */
+        frameCnt = 0;
+        while ((frameCnt < CANCOMM_BATCH_CHUNK_SIZE) && (idx < recordingMap.count))
+        {
+          record = &recordingMap.records[idx];
+          deadline = 0;
+          if (speed != CANCOMM_REPLAY_SPEED_MAX)
+          {
+            deadline = cancomm_replay_deadline(&recordingMap, record, startTime, 
+                                               firstTimestamp, speed);
+            if (deadline > (now + (2U * lead)))
+            {
+              break;
+            }
+          }
+          idx++;
+          if ((record->flags & CANCOMM_FLAG_CANERR_MSG) == 0)
+          {
+            deviceIdx = cancomm_export_device(recordingMap.header, record->ifindex);
+            frames[frameCnt].id = record->id;
+            frames[frameCnt].ext = record->ext;
+            frames[frameCnt].len = record->len;
+            frames[frameCnt].flags = record->flags;
+            frames[frameCnt].ifindex = (deviceIdx < CANCOMM_RECORD_DEVICES_MAX) ? 
+                                       ifindexMap[deviceIdx] : 0U;
+            memcpy(frames[frameCnt].data, record->data, CANCOMM_DATA_LEN_MAX);
+            frames[frameCnt].timestamp = 
+              ((deadline > (now + lead)) ? deadline : (now + lead)) + taiOffset;
+            frameCnt++;
+          }
+        }
+        /* Transmit them together. */
+        if (frameCnt > 0)
+        {
+          result = cancomm_replay_send(currentCtx, frames, frameCnt, sent, 
+                                       (lead > 0) ? CANCOMM_TRUE : CANCOMM_FALSE);
+        }
+      }
+      cancomm_recording_close(&recordingMap);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_replay ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the file descriptor of the CAN socket, for integration into an
+**            event loop based on poll(), epoll, io_uring, libuv, etc. The socket
+**            operates in non-blocking mode and signals the following events:
+**              POLLIN  - At least one frame is available. Read it with one of the
+**                        cancomm_receive() functions, until they report no more frames.
+**              POLLOUT - The transmit queue has space for at least one frame.
+**              POLLERR - An error is pending, for example when the CAN device went
+**                        down.
+**            For edge triggered epoll, make sure to read all available frames after
+**            each notification. The descriptor is owned by the context. Never read
+**            from, write to or close it directly. It becomes invalid upon disconnect.
+** \param     ctx CAN communication context.
+** \return    The file descriptor if connected, -1 otherwise.
+**
+****************************************************************************************/
+int cancomm_get_fd(cancomm_t ctx)
+{
+  int result = -1;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only set the file descriptor if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      result = cancomm_rx_fd(currentCtx);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_get_fd ***/
+
+
+/************************************************************************************//**
+** \brief     Configures the acceptance filters, such that only the CAN messages of
+**            interest get received. The filtering is done by the kernel, so unwanted
+**            CAN messages are dropped before they are copied to the application. A CAN
+**            message is received if it passes at least one of the filters. Filters apply
+**            immediately when connected and are automatically reapplied upon each
+**            connect. Remote frames never pass the filters.
+** \param     ctx CAN communication context.
+** \param     filters Pointer to an array with acceptance filters. NULL to remove all
+**            filters and receive all CAN messages again.
+** \param     count Number of filters in the array, up to CANCOMM_FILTERS_MAX. Zero 
+**            (with a non-NULL array) to not receive any CAN messages at all, which is
+**            useful for transmit only applications.
+** \return    CANCOMM_TRUE if the filters were successfully configured. CANCOMM_FALSE
+**            otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_set_filters(cancomm_t ctx, cancomm_filter_t const * filters, 
+                            size_t count)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct can_filter * newFilters;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (count <= CANCOMM_FILTERS_MAX));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (count <= CANCOMM_FILTERS_MAX))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Set positive result at this point and negate upon error detection. */
+    result = CANCOMM_TRUE;
+
+    /* Make sure the array for the filters is large enough. It only grows, so filters
+     * that are reconfigured at run-time typically reuse it. 
+     */
+    if ((filters != NULL) && (count > 0))
+    {
+      result = cancomm_filters_reserve(currentCtx, count);
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Convert the filters to the format of the kernel, replacing the currently
+       * configured ones.
+       */
+      newFilters = currentCtx->filters;
+      for (size_t idx = 0; (filters != NULL) && (idx < count); idx++)
+      {
+        cancomm_filter_convert(&filters[idx], &newFilters[idx]);
+      }
+      currentCtx->filters_cnt = (filters != NULL) ? (uint32_t)count : 0;
+      currentCtx->filters_set = (filters != NULL) ? CANCOMM_TRUE : CANCOMM_FALSE;
+
+      /* Apply the filters right away, if connected. */
+      if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+      {
+        result = cancomm_filters_apply(currentCtx);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_set_filters ***/
+
+
+/************************************************************************************//**
+** \brief     Configures which classes of CAN error frames get received. By default, no
+**            CAN error frames are received. Received CAN error frames are reported with
+**            the CANCOMM_FLAG_CANERR_MSG flag. The mask applies immediately when
+**            connected and is automatically reapplied upon each connect.
+** \param     ctx CAN communication context.
+** \param     mask Bit mask with the CAN error frame classes to receive. See 
+**            linux/can/error.h for the classes (CAN_ERR_xxx). CANCOMM_ERR_MASK_ALL to
+**            receive all CAN error frames, 0 to receive none.
+** \return    CANCOMM_TRUE if the error frame mask was successfully configured.
+**            CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_set_error_filter(cancomm_t ctx, uint32_t mask)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Store the mask. */
+    currentCtx->err_mask = mask & CAN_ERR_MASK;
+    result = CANCOMM_TRUE;
+
+    /* Apply the mask right away, if connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      result = cancomm_filters_apply(currentCtx);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_set_error_filter ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the statistics of the context, such as the number of received and
+**            transmitted frames and the number of frames that got lost on the way. The
+**            counters accumulate from the moment the context was created. This function
+**            is safe to call while the background reader thread runs.
+** \param     ctx CAN communication context.
+** \param     stats Pointer to where the statistics are stored.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_get_stats(cancomm_t ctx, cancomm_stats_t * stats)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (stats != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (stats != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* The packet mmap backend learns about its drops from the kernel on request. */
+    cancomm_stats_packet_drops(currentCtx);
+    /* Copy the counters. */
+    stats->rx_frames = atomic_load_explicit(&currentCtx->stats.rx_frames, 
+                                            memory_order_relaxed);
+    stats->rx_dropped = atomic_load_explicit(&currentCtx->stats.rx_dropped, 
+                                             memory_order_relaxed);
+    stats->rx_empty = atomic_load_explicit(&currentCtx->stats.rx_empty, 
+                                           memory_order_relaxed);
+    stats->rx_overflows = atomic_load_explicit(&currentCtx->stats.rx_overflows, 
+                                               memory_order_relaxed);
+    stats->tx_frames = atomic_load_explicit(&currentCtx->stats.tx_frames, 
+                                            memory_order_relaxed);
+    stats->tx_queue_full = atomic_load_explicit(&currentCtx->stats.tx_queue_full, 
+                                                memory_order_relaxed);
+    stats->tx_errors = atomic_load_explicit(&currentCtx->stats.tx_errors, 
+                                            memory_order_relaxed);
+    /* The io_uring backend learns about failed transmissions asynchronously. */
+    if (currentCtx->uring != NULL)
+    {
+      stats->tx_errors += atomic_load_explicit(&currentCtx->uring->tx_errors, 
+                                               memory_order_relaxed);
+    }
+    /* Frames that the background reader thread could not store in its ring. */
+    stats->reader_drops = 0;
+    if (currentCtx->ring != NULL)
+    {
+      stats->reader_drops = atomic_load_explicit(&currentCtx->ring->drops, 
+                                                 memory_order_relaxed);
+    }
+    /* Update the result. */
+    result = CANCOMM_TRUE;
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_get_stats ***/
+
+
+/************************************************************************************//**
+** \brief     Builds a list with all the CAN device names currently present on the
+**            system. Basically an internal array with strings such as can0, vcan0, etc.
+**            Afterwards, you can call cancomm_devices_name() to retrieve the name of a
+**            specific SocketCAN device, using its array index. The list is obtained
+**            with a single request to the kernel's routing netlink (RTM_GETLINK). While
+**            cancomm_devices_monitor() keeps the list up to date, this function just
+**            applies the pending changes.
+** \param     ctx CAN communication context.
+** \return    The total number of CAN devices currently present on the system, or 0 if
+**            none were found or in case of an error.
+**
+****************************************************************************************/
+uint8_t cancomm_devices_buildlist(cancomm_t ctx)
+{
+  uint8_t result = 0;
+  struct cancomm_ctx * currentCtx;
+  uint8_t listed;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Use the cached list, if the monitor keeps it up to date. Otherwise request the
+     * list from the kernel.
+     */
+    if (currentCtx->devices_monitor_fd >= 0)
+    {
+      (void)cancomm_devices_update(currentCtx);
+      listed = CANCOMM_TRUE;
+    }
+    else
+    {
+      listed = cancomm_devices_dump(currentCtx);
+    }
+    /* Update the result. */
+    if (listed == CANCOMM_TRUE)
+    {
+      result = (currentCtx->devices_cnt > UINT8_MAX) ? UINT8_MAX : 
+                                                       (uint8_t)currentCtx->devices_cnt;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_buildlist ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the CAN device name at the specified index of the internal list
+**            with CAN devices, created by function cancomm_devices_buildlist(). You
+**            could use this CAN device name when calling cancomm_connect().
+** \attention Call cancomm_devices_buildlist() prior to calling this function.
+** \param     ctx CAN communication context.
+** \param     idx Zero based index into the device list.
+** \return    The CAN device name at the specified index, or NULL in case of an error.
+**
+****************************************************************************************/
+char * cancomm_devices_name(cancomm_t ctx, uint8_t idx)
+{
+  char * result = NULL;
+  struct cancomm_ctx * currentCtx;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only continue if the specified index is valid. */
+    if (idx < currentCtx->devices_cnt)
+    {
+      /* Point the result to the CAN device name as the specified index. */
+      result = &currentCtx->devices_list[idx * IFNAMSIZ];
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_name ***/
+
+
+/************************************************************************************//**
+** \brief     Starts monitoring the system for CAN devices that appear or disappear, for
+**            example when plugging in a USB CAN adapter. The kernel then notifies the
+**            context of each change through a routing netlink socket, which keeps the
+**            list of cancomm_devices_buildlist() up to date without rescanning. The
+**            function also builds the list. The monitor stops upon cancomm_free().
+** \param     ctx CAN communication context.
+** \return    File descriptor that signals POLLIN when there are changes to apply with 
+**            cancomm_devices_update(), for integration into an event loop. -1 in case
+**            of an error. The file descriptor is owned by the context.
+**
+****************************************************************************************/
+int cancomm_devices_monitor(cancomm_t ctx)
+{
+  int result = -1;
+  struct cancomm_ctx * currentCtx;
+  struct sockaddr_nl addr = { 0 };
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Start the monitor, if not yet running. */
+    if (currentCtx->devices_monitor_fd < 0)
+    {
+      currentCtx->devices_monitor_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK |
+                                              SOCK_CLOEXEC, NETLINK_ROUTE);
+      if (currentCtx->devices_monitor_fd >= 0)
+      {
+        /* Subscribe to the link notifications before listing the devices, such that
+         * no change gets lost in between. 
+         */
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_LINK;
+        if ((bind(currentCtx->devices_monitor_fd, (struct sockaddr *)&addr, 
+                  sizeof(addr)) != 0) || 
+            (cancomm_devices_dump(currentCtx) != CANCOMM_TRUE))
+        {
+          close(currentCtx->devices_monitor_fd);
+          currentCtx->devices_monitor_fd = -1;
+        }
+      }
+    }
+    /* Update the result. */
+    result = currentCtx->devices_monitor_fd;
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_monitor ***/
+
+
+/************************************************************************************//**
+** \brief     Applies the pending notifications of the device monitor to the list of CAN
+**            devices. Call it when the file descriptor of cancomm_devices_monitor()
+**            signals POLLIN. Note that the indices of cancomm_devices_name() shift when
+**            a CAN device disappears.
+** \param     ctx CAN communication context.
+** \return    CANCOMM_TRUE if the list of CAN devices changed, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_devices_update(cancomm_t ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+  struct nlmsghdr const * nlh;
+  ssize_t msgSize;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only update if the monitor runs. */
+    if (currentCtx->devices_monitor_fd >= 0)
+    {
+      for (;;)
+      {
+        msgSize = recv(currentCtx->devices_monitor_fd, msgBuf.buf, sizeof(msgBuf.buf), 
+                       0);
+        if (msgSize <= 0)
+        {
+          /* Notifications were lost, because the socket's buffer overflowed. Start 
+           * over with a fresh list.
+           */
+          if ((msgSize < 0) && (errno == ENOBUFS))
+          {
+            (void)cancomm_devices_dump(currentCtx);
+            result = CANCOMM_TRUE;
+            continue;
+          }
+          /* No more notifications. */
+          break;
+        }
+        for (nlh = (struct nlmsghdr const *)msgBuf.buf; NLMSG_OK(nlh, (size_t)msgSize); 
+             nlh = NLMSG_NEXT(nlh, msgSize))
+        {
+          if (cancomm_devices_apply(currentCtx, nlh) == CANCOMM_TRUE)
+          {
+            result = CANCOMM_TRUE;
+          }
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_update ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the configuration of a CAN device, such as its bitrate, directly
+**            from the kernel's routing netlink. The CAN device does not have to be
+**            connected, which makes it possible to find out if it operates in CAN FD
+**            mode, before connecting to it.
+** \param     ctx CAN communication context.
+** \param     device Null terminated string with the SocketCAN device name, e.g. "can0".
+** \param     config Pointer to where the configuration is stored.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_link_get_config(cancomm_t ctx, char const * device, 
+                                cancomm_link_config_t * config)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (device != NULL) && (config != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (device != NULL) && (config != NULL))
+  {
+    /* Request the link information of the CAN device and extract the configuration. */
+    result = cancomm_link_query((struct cancomm_ctx *)ctx, device, config, NULL);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_link_get_config ***/
+
+
+/************************************************************************************//**
+** \brief     Configures a CAN device through the kernel's routing netlink, the same way
+**            as command "ip link set". The CAN device is brought down, configured and
+**            brought up again if so specified. Note that this requires the CAP_NET_ADMIN
+**            capability and a CAN controller. Virtual CAN devices have no bitrate.
+** \param     ctx CAN communication context.
+** \param     device Null terminated string with the SocketCAN device name, e.g. "can0".
+** \param     config Pointer to the configuration. A bitrate of zero keeps the bitrate
+**            as is.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. In case of an error,
+**            errno holds the error reported by the kernel, such as EPERM.
+**
+****************************************************************************************/
+uint8_t cancomm_link_set_config(cancomm_t ctx, char const * device, 
+                                cancomm_link_config_t const * config)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_link_msg request;
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+  struct rtattr * linkInfo;
+  struct rtattr * infoData;
+  struct can_bittiming bitTiming;
+  struct can_ctrlmode ctrlMode;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (device != NULL) && (config != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (device != NULL) && (config != NULL) && 
+      (strlen(device) < IFNAMSIZ))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* The kernel only accepts a new bitrate while the CAN device is down. */
+    cancomm_link_msg_init(&request, RTM_NEWLINK, device);
+    request.ifm.ifi_change = IFF_UP;
+    request.ifm.ifi_flags = 0;
+    if (cancomm_link_request(currentCtx, &request, msgBuf.buf, sizeof(msgBuf.buf), 
+                             NULL) == CANCOMM_TRUE)
+    {
+      /* Configure the CAN device. */
+      cancomm_link_msg_init(&request, RTM_NEWLINK, device);
+      linkInfo = cancomm_link_attr_add(&request, IFLA_LINKINFO, NULL, 0);
+      (void)cancomm_link_attr_add(&request, IFLA_INFO_KIND, "can", sizeof("can"));
+      infoData = cancomm_link_attr_add(&request, IFLA_INFO_DATA, NULL, 0);
+      if (config->bitrate > 0)
+      {
+        memset(&bitTiming, 0, sizeof(bitTiming));
+        bitTiming.bitrate = config->bitrate;
+        (void)cancomm_link_attr_add(&request, IFLA_CAN_BITTIMING, &bitTiming, 
+                                    sizeof(bitTiming));
+      }
+      if (config->data_bitrate > 0)
+      {
+        memset(&bitTiming, 0, sizeof(bitTiming));
+        bitTiming.bitrate = config->data_bitrate;
+        (void)cancomm_link_attr_add(&request, IFLA_CAN_DATA_BITTIMING, &bitTiming, 
+                                    sizeof(bitTiming));
+      }
+      ctrlMode.mask = CAN_CTRLMODE_FD;
+      ctrlMode.flags = (config->fd == CANCOMM_TRUE) ? CAN_CTRLMODE_FD : 0;
+      (void)cancomm_link_attr_add(&request, IFLA_CAN_CTRLMODE, &ctrlMode, 
+                                  sizeof(ctrlMode));
+      (void)cancomm_link_attr_add(&request, IFLA_CAN_RESTART_MS, &config->restart_ms,
+                                  sizeof(config->restart_ms));
+      cancomm_link_attr_end(&request, infoData);
+      cancomm_link_attr_end(&request, linkInfo);
+      result = cancomm_link_request(currentCtx, &request, msgBuf.buf, 
+                                    sizeof(msgBuf.buf), NULL);
+      /* Bring the CAN device up again, if so requested. */
+      if ((result == CANCOMM_TRUE) && (config->up == CANCOMM_TRUE))
+      {
+        cancomm_link_msg_init(&request, RTM_NEWLINK, device);
+        request.ifm.ifi_change = IFF_UP;
+        request.ifm.ifi_flags = IFF_UP;
+        result = cancomm_link_request(currentCtx, &request, msgBuf.buf, 
+                                      sizeof(msgBuf.buf), NULL);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_link_set_config ***/
+
+
+/************************************************************************************//**
+** \brief     Obtains the bus state, the error counters and the error statistics of a
+**            CAN device, directly from the kernel's routing netlink. The CAN device does
+**            not have to be connected. This takes a single request on a socket that the
+**            context keeps open, so it is cheap enough for sampling all CAN devices at a
+**            high rate.
+** \param     ctx CAN communication context.
+** \param     device Null terminated string with the SocketCAN device name, e.g. "can0".
+** \param     state Pointer to where the bus state and statistics are stored.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+uint8_t cancomm_link_get_state(cancomm_t ctx, char const * device, 
+                               cancomm_link_state_t * state)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (device != NULL) && (state != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (device != NULL) && (state != NULL))
+  {
+    /* Request the link information of the CAN device and extract the bus state. */
+    result = cancomm_link_query((struct cancomm_ctx *)ctx, device, NULL, state);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_link_get_state ***/
+
+
+/************************************************************************************//**
+** \brief     Adds a route to the kernel's CAN gateway, which then forwards the frames
+**            from one CAN device to another, optionally modifying them on the way. The
+**            frames are forwarded in the kernel's receive path, without ever reaching
+**            user space. Note that this requires the CAP_NET_ADMIN capability and the
+**            can-gw kernel module. See cancomm_forwarder_new() for forwarding in user
+**            space instead. The CAN devices do not have to be connected.
+** \param     ctx CAN communication context.
+** \param     route Pointer to the route.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. In case of an error,
+**            errno holds the error reported by the kernel, such as EPERM.
+**
+****************************************************************************************/
+uint8_t cancomm_gw_add(cancomm_t ctx, cancomm_gw_route_t const * route)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_link_msg request;
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (route != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (route != NULL))
+  {
+    /* Construct the request and pass it to the kernel. */
+    if (cancomm_gw_msg_build(&request, RTM_NEWROUTE, route) == CANCOMM_TRUE)
+    {
+      result = cancomm_link_request((struct cancomm_ctx *)ctx, &request, msgBuf.buf, 
+                                    sizeof(msgBuf.buf), NULL);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_add ***/
+
+
+/************************************************************************************//**
+** \brief     Removes a route from the kernel's CAN gateway. The kernel only removes a
+**            route with exactly the same settings, so pass the same route as with
+**            cancomm_gw_add().
+** \param     ctx CAN communication context.
+** \param     route Pointer to the route.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. In case of an error,
+**            errno holds the error reported by the kernel, such as EINVAL if the route
+**            does not exist.
+**
+****************************************************************************************/
+uint8_t cancomm_gw_remove(cancomm_t ctx, cancomm_gw_route_t const * route)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_link_msg request;
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (route != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (route != NULL))
+  {
+    /* Construct the request and pass it to the kernel. */
+    if (cancomm_gw_msg_build(&request, RTM_DELROUTE, route) == CANCOMM_TRUE)
+    {
+      result = cancomm_link_request((struct cancomm_ctx *)ctx, &request, msgBuf.buf, 
+                                    sizeof(msgBuf.buf), NULL);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_remove ***/
+
+
+/************************************************************************************//**
+** \brief     Removes all routes from the kernel's CAN gateway, including the ones that
+**            were added by other applications, such as the cangw tool.
+** \param     ctx CAN communication context.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. In case of an error,
+**            errno holds the error reported by the kernel, such as EPERM.
+**
+****************************************************************************************/
+uint8_t cancomm_gw_flush(cancomm_t ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_link_msg request;
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* A removal request without CAN devices makes the kernel remove all routes. */
+    cancomm_gw_msg_init(&request, RTM_DELROUTE, 0);
+    result = cancomm_link_request((struct cancomm_ctx *)ctx, &request, msgBuf.buf, 
+                                  sizeof(msgBuf.buf), NULL);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_flush ***/
+
+
+/************************************************************************************//**
+** \brief     Creates a forwarder, which forwards frames between CAN devices in user
+**            space, for when the kernel's CAN gateway is not available or not allowed.
+**            The routes are compiled into a routing table: routes whose filter selects
+**            a single CAN identifier are found with a hash table lookup, the others are
+**            matched one by one. The forwarder receives and transmits on the context,
+**            so connect the context to all the source and destination CAN devices with
+**            cancomm_connect_devices() first. The route settings flags
+**            CANCOMM_GW_FLAG_ECHO and hops only apply to kernel routes. A frame that
+**            no longer fits after its modification is dropped, the same way as the
+**            kernel does.
+** \param     ctx CAN communication context.
+** \param     routes Pointer to the array with routes.
+** \param     count Number of routes in the array.
+** \return    Handle to the forwarder, if successful. NULL otherwise, for example if a
+**            CAN device does not exist or a checksum index is out of range. Release it
+**            with cancomm_forwarder_free() once you no longer need it.
+**
+****************************************************************************************/
+cancomm_forwarder_t cancomm_forwarder_new(cancomm_t ctx, 
+                                          cancomm_gw_route_t const * routes, 
+                                          size_t count)
+{
+  cancomm_forwarder_t result = NULL;
+  struct cancomm_ctx * currentCtx;
+  struct cancomm_forwarder * newForwarder;
+  struct cancomm_forwarder_bucket * bucket;
+  size_t keyCnt = 0;
+  size_t bucketCnt = 2U;
+  uint8_t success;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (routes != NULL) && (count > 0) && (count < UINT32_MAX));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (routes != NULL) && (count > 0) && (count < UINT32_MAX))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentCtx = (struct cancomm_ctx *)ctx;
+
+    /* Only create the forwarder if actually connected. */
+    if (currentCtx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      newForwarder = malloc(sizeof(struct cancomm_forwarder));
+      if (newForwarder != NULL)
+      {
+        newForwarder->ctx = currentCtx;
+        newForwarder->scan_cnt = 0;
+        newForwarder->buckets = NULL;
+        newForwarder->buckets_mask = 0;
+        newForwarder->tx_cnt = 0;
+        newForwarder->routes = malloc(count * sizeof(struct cancomm_forwarder_route));
+        newForwarder->scan = malloc(count * sizeof(uint32_t));
+        success = ((newForwarder->routes != NULL) && (newForwarder->scan != NULL)) ?
+                  CANCOMM_TRUE : CANCOMM_FALSE;
+        /* Compile the routes. */
+        for (size_t idx = 0; (success == CANCOMM_TRUE) && (idx < count); idx++)
+        {
+          success = cancomm_forwarder_compile(&routes[idx], 
+                                              &newForwarder->routes[idx]);
+          if (newForwarder->routes[idx].key != 0)
+          {
+            keyCnt++;
+          }
+          else
+          {
+            newForwarder->scan[newForwarder->scan_cnt++] = (uint32_t)idx;
+          }
+        }
+        /* Build the hash table for the routes that select a single CAN identifier. */
+        if ((success == CANCOMM_TRUE) && (keyCnt > 0))
+        {
+          while (bucketCnt < (keyCnt * 2U))
+          {
+            bucketCnt <<= 1;
+          }
+          newForwarder->buckets = calloc(bucketCnt, 
+                                         sizeof(struct cancomm_forwarder_bucket));
+          if (newForwarder->buckets != NULL)
+          {
+            newForwarder->buckets_mask = bucketCnt - 1U;
+            /* Insert the routes back to front, such that routes with the same key 
+             * are chained in their original order.
+             */
+            for (size_t idx = count; idx > 0; idx--)
+            {
+              if (newForwarder->routes[idx - 1U].key != 0)
+              {
+                bucket = cancomm_forwarder_find(newForwarder, 
+                                                newForwarder->routes[idx - 1U].key);
+                bucket->key = newForwarder->routes[idx - 1U].key;
+                newForwarder->routes[idx - 1U].next = bucket->route;
+                bucket->route = (uint32_t)idx;
+              }
+            }
+          }
+          else
+          {
+            success = CANCOMM_FALSE;
+          }
+        }
+        /* Update the result, or clean up in case of an error. */
+        if (success == CANCOMM_TRUE)
+        {
+          result = (cancomm_forwarder_t)newForwarder;
+        }
+        else
+        {
+          cancomm_forwarder_free((cancomm_forwarder_t)newForwarder);
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_forwarder_new ***/
+
+
+/************************************************************************************//**
+** \brief     Releases a forwarder.
+** \param     forwarder Handle to the forwarder.
+**
+****************************************************************************************/
+void cancomm_forwarder_free(cancomm_forwarder_t forwarder)
+{
+  struct cancomm_forwarder * currentForwarder;
+
+  /* Verify parameter. */
+  assert(forwarder != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (forwarder != NULL)
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentForwarder = (struct cancomm_forwarder *)forwarder;
+
+    free(currentForwarder->buckets);
+    free(currentForwarder->scan);
+    free(currentForwarder->routes);
+    free(currentForwarder);
+  }
+} /*** end of cancomm_forwarder_free ***/
+
+
+/************************************************************************************//**
+** \brief     Forwards the frames that are available on the context, in batches. Each
+**            batch takes one system call to receive it and one to transmit all the
+**            frames that it was forwarded to. If no frame is available, it waits for one
+**            first. Call this function in a loop to forward continuously. When the
+**            transmit queue is full, it waits until the queue has space again or the
+**            timeout expires. Frames that cannot be transmitted are dropped.
+** \param     forwarder Handle to the forwarder.
+** \param     timeout_us Maximum time in microseconds to wait for a frame to forward. Zero
+**            to not wait and CANCOMM_TIMEOUT_INFINITE to wait indefinitely.
+** \param     forwarded Pointer to where the number of transmitted frames is stored.
+** \return    CANCOMM_TRUE if frames were forwarded. CANCOMM_FALSE upon timeout, signal
+**            interruption, shutdown or error.
+**
+****************************************************************************************/
+uint8_t cancomm_forwarder_run(cancomm_forwarder_t forwarder, uint32_t timeout_us,
+                              size_t * forwarded)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_forwarder * currentForwarder;
+  struct cancomm_forwarder_bucket const * bucket;
+  struct cancomm_forwarder_route const * route;
+  cancomm_frame_t const * frame;
+  struct timespec deadline;
+  struct timespec const * deadlinePtr = NULL;
+  size_t received;
+  canid_t canId;
+
+  /* Verify parameters. */
+  assert((forwarder != NULL) && (forwarded != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((forwarder != NULL) && (forwarded != NULL))
+  {
+    /* Cast the opaque pointer to its non-opaque counter part. */
+    currentForwarder = (struct cancomm_forwarder *)forwarder;
+    /* Reset the frame count. */
+    *forwarded = 0;
+
+    /* Determine the absolute point in time at which to stop waiting. Also without
+     * waiting for frames, as it bounds the wait for space in the transmit queue.
+     */
+    if (timeout_us != CANCOMM_TIMEOUT_INFINITE)
+    {
+      cancomm_deadline_init(&deadline, timeout_us);
+      deadlinePtr = &deadline;
+    }
+    for (;;)
+    {
+      /* Drain whatever is available, a batch at a time. */
+      while (cancomm_receive_batch(currentForwarder->ctx, currentForwarder->rx_frames, 
+                                   CANCOMM_FORWARDER_BATCH_SIZE, 
+                                   &received) == CANCOMM_TRUE)
+      {
+        for (size_t idx = 0; idx < received; idx++)
+        {
+          frame = &currentForwarder->rx_frames[idx];
+          /* CAN error frames are not forwarded. */
+          if ((frame->flags & CANCOMM_FLAG_CANERR_MSG) != 0)
+          {
+            continue;
+          }
+          /* Apply the routes for exactly this CAN identifier on this CAN device. */
+          if (currentForwarder->buckets != NULL)
+          {
+            bucket = cancomm_forwarder_find(currentForwarder, 
+                                            cancomm_frame_key(frame->id, frame->ext,
+                                                              frame->ifindex));
+            for (uint32_t routeNr = bucket->route; routeNr != 0; routeNr = route->next)
+            {
+              route = &currentForwarder->routes[routeNr - 1U];
+              cancomm_forwarder_route(currentForwarder, route, frame, deadlinePtr, 
+                                      forwarded);
+            }
+          }
+          /* Apply the other routes whose filter the frame passes. */
+          canId = (frame->ext == CANCOMM_TRUE) ? 
+                  ((frame->id & CAN_EFF_MASK) | CAN_EFF_FLAG) : 
+                  (frame->id & CAN_SFF_MASK);
+          for (size_t scanIdx = 0; scanIdx < currentForwarder->scan_cnt; scanIdx++)
+          {
+            route = &currentForwarder->routes[currentForwarder->scan[scanIdx]];
+            if ((route->src_ifindex == frame->ifindex) && 
+                (((canId & route->filter.can_mask) == 
+                  (route->filter.can_id & route->filter.can_mask & ~CAN_INV_FILTER)) != 
+                 ((route->filter.can_id & CAN_INV_FILTER) != 0)))
+            {
+              cancomm_forwarder_route(currentForwarder, route, frame, deadlinePtr, 
+                                      forwarded);
+            }
+          }
+        }
+        /* Transmit the frames of this batch. */
+        cancomm_forwarder_flush(currentForwarder, deadlinePtr, forwarded);
+        if (received < CANCOMM_FORWARDER_BATCH_SIZE)
+        {
+          break;
+        }
+      }
+      /* Done if frames were forwarded or if the caller does not want to wait. */
+      if ((*forwarded > 0) || (timeout_us == 0))
+      {
+        break;
+      }
+      /* Sleep until a frame arrives. Stop upon timeout, signal interruption, shutdown
+       * or error.
+       */
+      if (cancomm_wait_event(currentForwarder->ctx, POLLIN, deadlinePtr) != CANCOMM_TRUE)
+      {
+        break;
+      }
+    }
+    /* Update the result. */
+    if (*forwarded > 0)
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_forwarder_run ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to initialize the members of a newly created context.
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_ctx_setup(struct cancomm_ctx * ctx)
+{
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    ctx->socket = CANCOMM_INVALID_SOCKET;
+    ctx->fd_enabled = CANCOMM_FALSE;
+    atomic_init(&ctx->txtime_enabled, false);
+    atomic_init(&ctx->shutdown_requested, false);
+    ctx->shutdown_fd = -1;
+    ctx->ctx_allocated = CANCOMM_FALSE;
+    ctx->ifindex = 0;
+    ctx->tx_ifindex = 0;
+    ctx->rx_ifindexes_cnt = 0;
+    ctx->rx_ifindexes = NULL;
+    ctx->rx_ifindexes_capacity = 0;
+    ctx->connectTime = 0;
+    ctx->opt_timestamp = CANCOMM_TIMESTAMP_SW_US;
+    ctx->opt_clock = CLOCK_REALTIME;
+    ctx->opt_backend = CANCOMM_BACKEND_RAW;
+    ctx->opt_sndbuf = 0;
+    ctx->opt_rcvbuf = 0;
+    ctx->opt_coalesce_frames = 0;
+    ctx->opt_coalesce_us = 0;
+    ctx->opt_replay_txtime_us = 0;
+    ctx->coalesce_interval = 0;
+    ctx->pkt_fd = -1;
+    ctx->pkt_map = NULL;
+    ctx->pkt_block_idx = 0;
+    ctx->pkt_pkts_left = 0;
+    ctx->pkt_current = NULL;
+    ctx->uring = NULL;
+    ctx->bcm_fd = -1;
+    ctx->txn_fd = -1;
+    ctx->txn_ifindex = 0;
+    ctx->devices_cnt = 0;
+    ctx->devices_list = NULL;
+    ctx->devices_ifindexes = NULL;
+    ctx->devices_capacity = 0;
+    ctx->devices_monitor_fd = -1;
+    ctx->link_fd = -1;
+    ctx->link_seq = 0;
+    atomic_init(&ctx->stats.rx_frames, 0);
+    atomic_init(&ctx->stats.rx_dropped, 0);
+    atomic_init(&ctx->stats.rx_empty, 0);
+    atomic_init(&ctx->stats.rx_overflows, 0);
+    atomic_init(&ctx->stats.tx_frames, 0);
+    atomic_init(&ctx->stats.tx_queue_full, 0);
+    atomic_init(&ctx->stats.tx_errors, 0);
+    ctx->rxq_drops = 0;
+    ctx->filters_set = CANCOMM_FALSE;
+    ctx->filters_cnt = 0;
+    ctx->filters = NULL;
+    ctx->filters_capacity = 0;
+    ctx->err_mask = 0;
+    ctx->ring = NULL;
+    ctx->ring_spare = NULL;
+    ctx->reader_wakefd = -1;
+    ctx->snapshot = NULL;
+  }
+} /*** end of cancomm_ctx_setup ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to make sure the array with the interface indices of the
+**            devices to receive from holds at least the specified number of entries.
+** \param     ctx Non-opaque CAN communication context.
+** \param     capacity Number of interface indices that the array should hold.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. The array stays as is
+**            upon failure.
+**
+****************************************************************************************/
+static uint8_t cancomm_ifindexes_reserve(struct cancomm_ctx * ctx, size_t capacity)
+{
+  uint8_t result = CANCOMM_FALSE;
+  uint32_t * newIfindexes;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if ((ctx != NULL) && (capacity <= UINT32_MAX))
+  {
+    result = CANCOMM_TRUE;
+    if (capacity > ctx->rx_ifindexes_capacity)
+    {
+      newIfindexes = realloc(ctx->rx_ifindexes, capacity * sizeof(uint32_t));
+      if (newIfindexes != NULL)
+      {
+        ctx->rx_ifindexes = newIfindexes;
+        ctx->rx_ifindexes_capacity = (uint32_t)capacity;
+      }
+      else
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_ifindexes_reserve ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to make sure the array with the acceptance filters holds at
+**            least the specified number of filters.
+** \param     ctx Non-opaque CAN communication context.
+** \param     capacity Number of acceptance filters that the array should hold.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. The array and the
+**            configured filters in it stay as is upon failure.
+**
+****************************************************************************************/
+static uint8_t cancomm_filters_reserve(struct cancomm_ctx * ctx, size_t capacity)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct can_filter * newFilters;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if ((ctx != NULL) && (capacity <= CANCOMM_FILTERS_MAX))
+  {
+    result = CANCOMM_TRUE;
+    if (capacity > ctx->filters_capacity)
+    {
+      newFilters = realloc(ctx->filters, capacity * sizeof(struct can_filter));
+      if (newFilters != NULL)
+      {
+        ctx->filters = newFilters;
+        ctx->filters_capacity = (uint32_t)capacity;
+      }
+      else
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_filters_reserve ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to rebuild the list of CAN devices of the context, with a
+**            single dump request to the kernel's routing netlink. The kernel reports all
+**            network interfaces at once, of which just the ones of type ARPHRD_CAN are
+**            kept. Contrary to getifaddrs(), each interface is reported exactly once.
+** \param     ctx Non-opaque CAN communication context.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_devices_dump(struct cancomm_ctx * ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct
+  {
+    struct nlmsghdr  nlh;
+    struct ifinfomsg ifm;
+    struct rtattr    rta;
+    uint32_t         extMask;
+  } request = { 0 };
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+  struct nlmsghdr const * nlh;
+  struct sockaddr_nl addr = { 0 };
+  uint8_t done = CANCOMM_FALSE;
+  ssize_t msgSize;
+  int nlSocket;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    nlSocket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (nlSocket >= 0)
+    {
+      /* Request all network interfaces, without their statistics. The statistics make 
+       * up most of each report and are of no interest here.
+       */
+      request.nlh.nlmsg_len = sizeof(request);
+      request.nlh.nlmsg_type = RTM_GETLINK;
+      request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+      request.nlh.nlmsg_seq = 1;
+      request.ifm.ifi_family = AF_UNSPEC;
+      request.rta.rta_type = IFLA_EXT_MASK;
+      request.rta.rta_len = RTA_LENGTH(sizeof(uint32_t));
+      request.extMask = RTEXT_FILTER_SKIP_STATS;
+      addr.nl_family = AF_NETLINK;
+      if (sendto(nlSocket, &request, sizeof(request), 0, (struct sockaddr *)&addr, 
+                 sizeof(addr)) == (ssize_t)sizeof(request))
+      {
+        /* Start with an empty list and add the CAN devices as they get reported. The
+         * report spans multiple messages, until the done message.
+         */
+        ctx->devices_cnt = 0;
+        while (done == CANCOMM_FALSE)
+        {
+          msgSize = recv(nlSocket, msgBuf.buf, sizeof(msgBuf.buf), 0);
+          if (msgSize <= 0)
+          {
+            break;
+          }
+          for (nlh = (struct nlmsghdr const *)msgBuf.buf; 
+               NLMSG_OK(nlh, (size_t)msgSize); nlh = NLMSG_NEXT(nlh, msgSize))
+          {
+            if (nlh->nlmsg_type == NLMSG_DONE)
+            {
+              result = CANCOMM_TRUE;
+              done = CANCOMM_TRUE;
+              break;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR)
+            {
+              done = CANCOMM_TRUE;
+              break;
+            }
+            (void)cancomm_devices_apply(ctx, nlh);
+          }
+        }
+      }
+      close(nlSocket);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_dump ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to apply a link message of the routing netlink to the list
+**            of CAN devices of the context.
+** \param     ctx Non-opaque CAN communication context.
+** \param     nlh Pointer to the netlink message.
+** \return    CANCOMM_TRUE if the list changed, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_devices_apply(struct cancomm_ctx * ctx, 
+                                     struct nlmsghdr const * nlh)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct ifinfomsg const * ifm;
+  struct rtattr const * rta;
+  char const * name = NULL;
+  uint32_t idx;
+  int rtaLen;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (nlh != NULL));
+
+  /* Only continue with valid parameters and a complete link message. */
+  if ((ctx != NULL) && (nlh != NULL) && 
+      ((nlh->nlmsg_type == RTM_NEWLINK) || (nlh->nlmsg_type == RTM_DELLINK)) &&
+      (nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(struct ifinfomsg))))
+  {
+    ifm = (struct ifinfomsg const *)NLMSG_DATA(nlh);
+    /* Locate the device in the list. */
+    for (idx = 0; idx < ctx->devices_cnt; idx++)
+    {
+      if (ctx->devices_ifindexes[idx] == (uint32_t)ifm->ifi_index)
+      {
+        break;
+      }
+    }
+    /* Remove a CAN device that disappeared, while keeping the order of the others. */
+    if ((nlh->nlmsg_type == RTM_DELLINK) || (ifm->ifi_type != ARPHRD_CAN))
+    {
+      if (idx < ctx->devices_cnt)
+      {
+        ctx->devices_cnt--;
+        memmove(&ctx->devices_list[idx * IFNAMSIZ], 
+                &ctx->devices_list[(idx + 1U) * IFNAMSIZ], 
+                (ctx->devices_cnt - idx) * IFNAMSIZ);
+        memmove(&ctx->devices_ifindexes[idx], &ctx->devices_ifindexes[idx + 1U], 
+                (ctx->devices_cnt - idx) * sizeof(uint32_t));
+        result = CANCOMM_TRUE;
+      }
+    }
+    else
+    {
+      /* Find the name of the CAN device. */
+      rtaLen = (int)IFLA_PAYLOAD(nlh);
+      for (rta = IFLA_RTA(ifm); RTA_OK(rta, rtaLen); rta = RTA_NEXT(rta, rtaLen))
+      {
+        if ((rta->rta_type == IFLA_IFNAME) && (RTA_PAYLOAD(rta) > 0) &&
+            (RTA_PAYLOAD(rta) <= IFNAMSIZ))
+        {
+          name = (char const *)RTA_DATA(rta);
+          break;
+        }
+      }
+      if (name != NULL)
+      {
+        /* Add a new CAN device, growing the list as needed. */
+        if (idx == ctx->devices_cnt)
+        {
+          if (ctx->devices_cnt == ctx->devices_capacity)
+          {
+            (void)cancomm_devices_reserve(ctx, (ctx->devices_capacity > 0) ? 
+                                               (2U * ctx->devices_capacity) : 
+                                               CANCOMM_DEVICES_CAPACITY_MIN);
+          }
+          if (ctx->devices_cnt < ctx->devices_capacity)
+          {
+            ctx->devices_ifindexes[idx] = (uint32_t)ifm->ifi_index;
+            ctx->devices_list[idx * IFNAMSIZ] = '\0';
+            ctx->devices_cnt++;
+          }
+        }
+        /* Store the name. Also handles a CAN device that was renamed. */
+        if ((idx < ctx->devices_cnt) && 
+            (strncmp(&ctx->devices_list[idx * IFNAMSIZ], name, IFNAMSIZ) != 0))
+        {
+          strncpy(&ctx->devices_list[idx * IFNAMSIZ], name, IFNAMSIZ - 1);
+          ctx->devices_list[(idx * IFNAMSIZ) + IFNAMSIZ - 1] = '\0';
+          result = CANCOMM_TRUE;
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_apply ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to grow the list of CAN devices of the context, such that
+**            it holds at least the specified number of devices.
+** \param     ctx Non-opaque CAN communication context.
+** \param     capacity Number of devices that the list should hold.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_devices_reserve(struct cancomm_ctx * ctx, uint32_t capacity)
+{
+  uint8_t result = CANCOMM_FALSE;
+  char * newList;
+  uint32_t * newIfindexes;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    result = CANCOMM_TRUE;
+    if (capacity > ctx->devices_capacity)
+    {
+      /* The arrays stay valid if a reallocation fails, so only take over the ones that
+       * succeeded and keep the capacity as is, until both succeeded.
+       */
+      newList = realloc(ctx->devices_list, (size_t)capacity * IFNAMSIZ);
+      if (newList != NULL)
+      {
+        ctx->devices_list = newList;
+      }
+      newIfindexes = realloc(ctx->devices_ifindexes, (size_t)capacity * sizeof(uint32_t));
+      if (newIfindexes != NULL)
+      {
+        ctx->devices_ifindexes = newIfindexes;
+      }
+      if ((newList != NULL) && (newIfindexes != NULL))
+      {
+        ctx->devices_capacity = capacity;
+      }
+      else
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_devices_reserve ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to initialize a routing netlink request about a single CAN
+**            device. The request selects the CAN device by its name.
+** \param     msg Pointer to the request.
+** \param     type Type of the request, such as RTM_GETLINK.
+** \param     device Null terminated string with the SocketCAN device name.
+**
+****************************************************************************************/
+static void cancomm_link_msg_init(struct cancomm_link_msg * msg, uint16_t type, 
+                                  char const * device)
+{
+  /* Verify parameters. */
+  assert((msg != NULL) && (device != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((msg != NULL) && (device != NULL))
+  {
+    memset(msg, 0, sizeof(*msg));
+    msg->nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    msg->nlh.nlmsg_type = type;
+    msg->ifm.ifi_family = AF_UNSPEC;
+    (void)cancomm_link_attr_add(msg, IFLA_IFNAME, device, strlen(device) + 1U);
+  }
+} /*** end of cancomm_link_msg_init ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to append an attribute to a routing netlink request. For a
+**            nested attribute, specify no data and call cancomm_link_attr_end() once all
+**            its nested attributes were appended.
+** \param     msg Pointer to the request.
+** \param     type Type of the attribute, such as IFLA_IFNAME.
+** \param     data Pointer to the data of the attribute. NULL if none.
+** \param     len Number of data bytes.
+** \return    Pointer to the attribute inside the request, or NULL if it does not fit.
+**
+****************************************************************************************/
+static struct rtattr * cancomm_link_attr_add(struct cancomm_link_msg * msg, 
+                                             uint16_t type, void const * data, 
+                                             size_t len)
+{
+  struct rtattr * result = NULL;
+
+  /* Verify parameters. */
+  assert(msg != NULL);
+  /* The request buffer is sized for all the attributes this library uses. */
+  assert((NLMSG_ALIGN(msg->nlh.nlmsg_len) + RTA_SPACE(len)) <= sizeof(*msg));
+
+  /* Only continue with valid parameters and if the attribute fits. */
+  if ((msg != NULL) && 
+      ((NLMSG_ALIGN(msg->nlh.nlmsg_len) + RTA_SPACE(len)) <= sizeof(*msg)))
+  {
+    result = (struct rtattr *)((char *)msg + NLMSG_ALIGN(msg->nlh.nlmsg_len));
+    result->rta_type = type;
+    result->rta_len = (unsigned short)RTA_LENGTH(len);
+    if ((data != NULL) && (len > 0))
+    {
+      memcpy(RTA_DATA(result), data, len);
+    }
+    msg->nlh.nlmsg_len = (uint32_t)(NLMSG_ALIGN(msg->nlh.nlmsg_len) + RTA_SPACE(len));
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_link_attr_add ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to complete a nested attribute of a routing netlink
+**            request, such that it spans all the attributes appended after it.
+** \param     msg Pointer to the request.
+** \param     nest Pointer to the nested attribute, as returned by
+**            cancomm_link_attr_add().
+**
+****************************************************************************************/
+static void cancomm_link_attr_end(struct cancomm_link_msg * msg, struct rtattr * nest)
+{
+  /* Verify parameter. */
+  assert(msg != NULL);
+
+  /* Only continue with valid parameters. */
+  if ((msg != NULL) && (nest != NULL))
+  {
+    nest->rta_len = (unsigned short)(((char *)msg + NLMSG_ALIGN(msg->nlh.nlmsg_len)) - 
+                                     (char *)nest);
+  }
+} /*** end of cancomm_link_attr_end ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to pass a request to the kernel's routing netlink and to 
+**            wait for its reply. The socket is opened upon the first request and stays
+**            open, such that repeated requests only cost a system call each.
+** \param     ctx Non-opaque CAN communication context.
+** \param     msg Pointer to the request.
+** \param     buf Pointer to the buffer for receiving the reply.
+** \param     size Size of the buffer.
+** \param     reply Pointer to where the pointer to the reply message inside the buffer
+**            is stored. NULL for a request without a reply, in which case the kernel
+**            is asked to acknowledge it.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise. In case of an error,
+**            errno holds the error reported by the kernel.
+**
+****************************************************************************************/
+static uint8_t cancomm_link_request(struct cancomm_ctx * ctx, 
+                                    struct cancomm_link_msg * msg, void * buf, 
+                                    size_t size, struct nlmsghdr const ** reply)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct sockaddr_nl addr = { 0 };
+  struct nlmsghdr const * nlh;
+  struct nlmsgerr const * nlErr;
+  uint8_t done = CANCOMM_FALSE;
+  ssize_t msgSize;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (msg != NULL) && (buf != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (msg != NULL) && (buf != NULL))
+  {
+    /* Open the socket, if not yet done. */
+    if (ctx->link_fd < 0)
+    {
+      ctx->link_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    }
+    if (ctx->link_fd >= 0)
+    {
+      /* Pass the request to the kernel. */
+      msg->nlh.nlmsg_flags |= NLM_F_REQUEST | ((reply == NULL) ? NLM_F_ACK : 0);
+      msg->nlh.nlmsg_seq = ++ctx->link_seq;
+      addr.nl_family = AF_NETLINK;
+      if (sendto(ctx->link_fd, msg, msg->nlh.nlmsg_len, 0, (struct sockaddr *)&addr,
+                 sizeof(addr)) == (ssize_t)msg->nlh.nlmsg_len)
+      {
+        /* Wait for the reply. Skip replies to earlier requests that timed out or
+         * failed half way.
+         */
+        while (done == CANCOMM_FALSE)
+        {
+          msgSize = recv(ctx->link_fd, buf, size, 0);
+          if (msgSize <= 0)
+          {
+            break;
+          }
+          for (nlh = (struct nlmsghdr const *)buf; NLMSG_OK(nlh, (size_t)msgSize);
+               nlh = NLMSG_NEXT(nlh, msgSize))
+          {
+            if (nlh->nlmsg_seq != msg->nlh.nlmsg_seq)
+            {
+              continue;
+            }
+            done = CANCOMM_TRUE;
+            if (nlh->nlmsg_type == NLMSG_ERROR)
+            {
+              /* An acknowledgement has an error code of zero. */
+              nlErr = (struct nlmsgerr const *)NLMSG_DATA(nlh);
+              if ((nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(*nlErr))) && 
+                  (nlErr->error == 0) && (reply == NULL))
+              {
+                result = CANCOMM_TRUE;
+              }
+              else if ((nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(*nlErr))) && 
+                       (nlErr->error < 0))
+              {
+                errno = -nlErr->error;
+              }
+            }
+            else if (reply != NULL)
+            {
+              *reply = nlh;
+              result = CANCOMM_TRUE;
+            }
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_link_request ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to request the link information of a CAN device and to
+**            extract its configuration and bus state.
+** \param     ctx Non-opaque CAN communication context.
+** \param     device Null terminated string with the SocketCAN device name.
+** \param     config Pointer to where the configuration is stored. NULL if not needed.
+** \param     state Pointer to where the bus state is stored. NULL if not needed.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_link_query(struct cancomm_ctx * ctx, char const * device,
+                                  cancomm_link_config_t * config, 
+                                  cancomm_link_state_t * state)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_link_msg request;
+  union
+  {
+    char            buf[CANCOMM_NETLINK_BUF_SIZE];
+    struct nlmsghdr align;
+  } msgBuf;
+  struct nlmsghdr const * reply;
+  uint32_t extMask = RTEXT_FILTER_SKIP_STATS;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (device != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (device != NULL) && (strlen(device) < IFNAMSIZ))
+  {
+    /* Request the information of the CAN device. The CAN specific statistics are part
+     * of the link information, so the generic statistics can be skipped.
+     */
+    cancomm_link_msg_init(&request, RTM_GETLINK, device);
+    (void)cancomm_link_attr_add(&request, IFLA_EXT_MASK, &extMask, sizeof(extMask));
+    if (cancomm_link_request(ctx, &request, msgBuf.buf, sizeof(msgBuf.buf), 
+                             &reply) == CANCOMM_TRUE)
+    {
+      /* Only accept the reply for a CAN device. */
+      if ((reply->nlmsg_type == RTM_NEWLINK) && 
+          (reply->nlmsg_len >= NLMSG_LENGTH(sizeof(struct ifinfomsg))) &&
+          (((struct ifinfomsg const *)NLMSG_DATA(reply))->ifi_type == ARPHRD_CAN))
+      {
+        if (config != NULL)
+        {
+          memset(config, 0, sizeof(*config));
+        }
+        if (state != NULL)
+        {
+          memset(state, 0, sizeof(*state));
+        }
+        cancomm_link_parse(reply, config, state);
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_link_query ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to extract the configuration and the bus state of a CAN
+**            device from the link information that the routing netlink reported.
+** \param     nlh Pointer to the link information message.
+** \param     config Pointer to where the configuration is stored. NULL if not needed.
+** \param     state Pointer to where the bus state is stored. NULL if not needed.
+**
+****************************************************************************************/
+static void cancomm_link_parse(struct nlmsghdr const * nlh, 
+                               cancomm_link_config_t * config, 
+                               cancomm_link_state_t * state)
+{
+  struct ifinfomsg const * ifm;
+  struct rtattr const * rta;
+  struct rtattr const * info;
+  int rtaLen;
+  int infoLen;
+  uint32_t mtu;
+  struct can_device_stats devStats;
+
+  /* Verify parameter. */
+  assert(nlh != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (nlh != NULL)
+  {
+    ifm = (struct ifinfomsg const *)NLMSG_DATA(nlh);
+    if (config != NULL)
+    {
+      config->up = ((ifm->ifi_flags & IFF_UP) != 0) ? CANCOMM_TRUE : CANCOMM_FALSE;
+    }
+    rtaLen = (int)IFLA_PAYLOAD(nlh);
+    for (rta = IFLA_RTA(ifm); RTA_OK(rta, rtaLen); rta = RTA_NEXT(rta, rtaLen))
+    {
+      /* The MTU tells the mode, also for CAN devices without bitrate, such as vcan. */
+      if ((rta->rta_type == IFLA_MTU) && (RTA_PAYLOAD(rta) >= sizeof(mtu)) && 
+          (config != NULL))
+      {
+        memcpy(&mtu, RTA_DATA(rta), sizeof(mtu));
+        config->fd = (mtu == CANFD_MTU) ? CANCOMM_TRUE : CANCOMM_FALSE;
+      }
+      else if (rta->rta_type == IFLA_LINKINFO)
+      {
+        infoLen = (int)RTA_PAYLOAD(rta);
+        for (info = (struct rtattr const *)RTA_DATA(rta); RTA_OK(info, infoLen); 
+             info = RTA_NEXT(info, infoLen))
+        {
+          if (info->rta_type == IFLA_INFO_DATA)
+          {
+            cancomm_link_parse_data(info, config, state);
+          }
+          else if ((info->rta_type == IFLA_INFO_XSTATS) && 
+                   (RTA_PAYLOAD(info) >= sizeof(devStats)) && (state != NULL))
+          {
+            memcpy(&devStats, RTA_DATA(info), sizeof(devStats));
+            state->bus_errors = devStats.bus_error;
+            state->error_warning = devStats.error_warning;
+            state->error_passive = devStats.error_passive;
+            state->bus_off = devStats.bus_off;
+            state->arbitration_lost = devStats.arbitration_lost;
+            state->restarts = devStats.restarts;
+          }
+        }
+      }
+    }
+  }
+} /*** end of cancomm_link_parse ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to extract the CAN specific attributes of the link
+**            information that the routing netlink reported.
+** \param     data Pointer to the nested IFLA_INFO_DATA attribute.
+** \param     config Pointer to where the configuration is stored. NULL if not needed.
+** \param     state Pointer to where the bus state is stored. NULL if not needed.
+**
+****************************************************************************************/
+static void cancomm_link_parse_data(struct rtattr const * data, 
+                                    cancomm_link_config_t * config, 
+                                    cancomm_link_state_t * state)
+{
+  struct rtattr const * rta;
+  int rtaLen;
+  struct can_bittiming bitTiming;
+  struct can_berr_counter berrCounter;
+
+  /* Verify parameter. */
+  assert(data != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (data != NULL)
+  {
+    rtaLen = (int)RTA_PAYLOAD(data);
+    for (rta = (struct rtattr const *)RTA_DATA(data); RTA_OK(rta, rtaLen); 
+         rta = RTA_NEXT(rta, rtaLen))
+    {
+      if (config != NULL)
+      {
+        if ((rta->rta_type == IFLA_CAN_BITTIMING) && 
+            (RTA_PAYLOAD(rta) >= sizeof(bitTiming)))
+        {
+          memcpy(&bitTiming, RTA_DATA(rta), sizeof(bitTiming));
+          config->bitrate = bitTiming.bitrate;
+        }
+        else if ((rta->rta_type == IFLA_CAN_DATA_BITTIMING) && 
+                 (RTA_PAYLOAD(rta) >= sizeof(bitTiming)))
+        {
+          memcpy(&bitTiming, RTA_DATA(rta), sizeof(bitTiming));
+          config->data_bitrate = bitTiming.bitrate;
+        }
+        else if ((rta->rta_type == IFLA_CAN_RESTART_MS) && 
+                 (RTA_PAYLOAD(rta) >= sizeof(uint32_t)))
+        {
+          memcpy(&config->restart_ms, RTA_DATA(rta), sizeof(uint32_t));
+        }
+      }
+      if (state != NULL)
+      {
+        /* The kernel's CAN states match the CANCOMM_LINK_STATE_xxx values. */
+        if ((rta->rta_type == IFLA_CAN_STATE) && (RTA_PAYLOAD(rta) >= sizeof(uint32_t)))
+        {
+          memcpy(&state->state, RTA_DATA(rta), sizeof(uint32_t));
+        }
+        else if ((rta->rta_type == IFLA_CAN_BERR_COUNTER) && 
+                 (RTA_PAYLOAD(rta) >= sizeof(berrCounter)))
+        {
+          memcpy(&berrCounter, RTA_DATA(rta), sizeof(berrCounter));
+          state->tx_errors = berrCounter.txerr;
+          state->rx_errors = berrCounter.rxerr;
+        }
+      }
+    }
+  }
+} /*** end of cancomm_link_parse_data ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to initialize a routing netlink request about a route of 
+**            the kernel's CAN gateway.
+** \param     msg Pointer to the request.
+** \param     type Type of the request, such as RTM_NEWROUTE.
+** \param     flags Bit flags of the route (CGW_FLAGS_CAN_xxx).
+**
+****************************************************************************************/
+static void cancomm_gw_msg_init(struct cancomm_link_msg * msg, uint16_t type, 
+                                uint8_t flags)
+{
+  /* Verify parameter. */
+  assert(msg != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (msg != NULL)
+  {
+    memset(msg, 0, sizeof(*msg));
+    msg->nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtcanmsg));
+    msg->nlh.nlmsg_type = type;
+    msg->rtcan.can_family = AF_CAN;
+    msg->rtcan.gwtype = CGW_TYPE_CAN_CAN;
+    msg->rtcan.flags = flags;
+  }
+} /*** end of cancomm_gw_msg_init ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to construct a routing netlink request about a route of
+**            the kernel's CAN gateway. The request for removing a route must hold the
+**            same attributes as the one for adding it, which is the case when it is
+**            constructed from the same route.
+** \param     msg Pointer to the request.
+** \param     type Type of the request, such as RTM_NEWROUTE.
+** \param     route Pointer to the route.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE if a CAN device does not exist.
+**
+****************************************************************************************/
+static uint8_t cancomm_gw_msg_build(struct cancomm_link_msg * msg, uint16_t type,
+                                    cancomm_gw_route_t const * route)
+{
+  uint8_t result = CANCOMM_FALSE;
+  cancomm_gw_mod_t const * mods[CANCOMM_GW_OPS];
+  struct cgw_csum_xor csumXor;
+  struct cgw_csum_crc8 csumCrc8;
+  struct can_filter canFilter;
+  uint32_t srcIfindex = 0;
+  uint32_t dstIfindex = 0;
+  uint8_t fd;
+  uint8_t flags;
+
+  /* Verify parameters. */
+  assert((msg != NULL) && (route != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((msg != NULL) && (route != NULL))
+  {
+    /* Look up the CAN devices. */
+    if ((route->src_device != NULL) && (route->dst_device != NULL))
+    {
+      srcIfindex = if_nametoindex(route->src_device);
+      dstIfindex = if_nametoindex(route->dst_device);
+    }
+    if ((srcIfindex != 0) && (dstIfindex != 0))
+    {
+      fd = ((route->flags & CANCOMM_GW_FLAG_CANFD) != 0) ? CANCOMM_TRUE : CANCOMM_FALSE;
+      flags = (fd == CANCOMM_TRUE) ? CGW_FLAGS_CAN_FD : 0;
+      if ((route->flags & CANCOMM_GW_FLAG_ECHO) != 0)
+      {
+        flags |= CGW_FLAGS_CAN_ECHO;
+      }
+      cancomm_gw_msg_init(msg, type, flags);
+      /* Add the modifications. */
+      mods[CANCOMM_GW_OP_AND] = &route->mod_and;
+      mods[CANCOMM_GW_OP_OR] = &route->mod_or;
+      mods[CANCOMM_GW_OP_XOR] = &route->mod_xor;
+      mods[CANCOMM_GW_OP_SET] = &route->mod_set;
+      for (uint32_t op = 0; op < CANCOMM_GW_OPS; op++)
+      {
+        cancomm_gw_mod_attr_add(msg, op, mods[op], fd);
+      }
+      /* Add the checksums. */
+      if (route->csum_xor.enabled == CANCOMM_TRUE)
+      {
+        csumXor.from_idx = route->csum_xor.from;
+        csumXor.to_idx = route->csum_xor.to;
+        csumXor.result_idx = route->csum_xor.result;
+        csumXor.init_xor_val = route->csum_xor.init;
+        (void)cancomm_link_attr_add(msg, CGW_CS_XOR, &csumXor, sizeof(csumXor));
+      }
+      if (route->csum_crc8.enabled == CANCOMM_TRUE)
+      {
+        memset(&csumCrc8, 0, sizeof(csumCrc8));
+        csumCrc8.from_idx = route->csum_crc8.from;
+        csumCrc8.to_idx = route->csum_crc8.to;
+        csumCrc8.result_idx = route->csum_crc8.result;
+        csumCrc8.init_crc_val = route->csum_crc8.init;
+        csumCrc8.final_xor_val = route->csum_crc8.final_xor;
+        cancomm_gw_crc8_table(route->csum_crc8.poly, csumCrc8.crctab);
+        csumCrc8.profile = CGW_CRC8PRF_UNSPEC;
+        (void)cancomm_link_attr_add(msg, CGW_CS_CRC8, &csumCrc8, sizeof(csumCrc8));
+      }
+      /* Add the filter and the CAN devices. */
+      if (route->filter != NULL)
+      {
+        cancomm_filter_convert(route->filter, &canFilter);
+        (void)cancomm_link_attr_add(msg, CGW_FILTER, &canFilter, sizeof(canFilter));
+      }
+      (void)cancomm_link_attr_add(msg, CGW_SRC_IF, &srcIfindex, sizeof(srcIfindex));
+      (void)cancomm_link_attr_add(msg, CGW_DST_IF, &dstIfindex, sizeof(dstIfindex));
+      if (route->hops > 0)
+      {
+        (void)cancomm_link_attr_add(msg, CGW_LIM_HOPS, &route->hops, 
+                                    sizeof(route->hops));
+      }
+      /* Request successfully constructed. */
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_msg_build ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to append a modification to a routing netlink request 
+**            about a route of the kernel's CAN gateway. Nothing is appended if the
+**            modification does not modify any frame member.
+** \param     msg Pointer to the request.
+** \param     op Operation of the modification (CANCOMM_GW_OP_xxx).
+** \param     mod Pointer to the modification.
+** \param     fd CANCOMM_TRUE if the route forwards CAN FD frames, CANCOMM_FALSE for CAN
+**            classic frames.
+**
+****************************************************************************************/
+static void cancomm_gw_mod_attr_add(struct cancomm_link_msg * msg, uint32_t op, 
+                                    cancomm_gw_mod_t const * mod, uint8_t fd)
+{
+  static const uint16_t modAttrs[CANCOMM_GW_OPS] =
+  {
+    CGW_MOD_AND, CGW_MOD_OR, CGW_MOD_XOR, CGW_MOD_SET
+  };
+  static const uint16_t fdModAttrs[CANCOMM_GW_OPS] =
+  {
+    CGW_FDMOD_AND, CGW_FDMOD_OR, CGW_FDMOD_XOR, CGW_FDMOD_SET
+  };
+  struct cgw_fdframe_mod fdMod;
+  struct cgw_frame_mod classicMod;
+  uint8_t modType = 0;
+
+  /* Verify parameters. */
+  assert((msg != NULL) && (op < CANCOMM_GW_OPS) && (mod != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((msg != NULL) && (op < CANCOMM_GW_OPS) && (mod != NULL))
+  {
+    /* Determine which frame members to modify. */
+    modType |= ((mod->members & CANCOMM_GW_MOD_ID) != 0) ? CGW_MOD_ID : 0;
+    modType |= ((mod->members & CANCOMM_GW_MOD_LEN) != 0) ? CGW_MOD_LEN : 0;
+    modType |= ((mod->members & CANCOMM_GW_MOD_DATA) != 0) ? CGW_MOD_DATA : 0;
+    if (modType != 0)
+    {
+      if (fd == CANCOMM_TRUE)
+      {
+        memset(&fdMod, 0, sizeof(fdMod));
+        fdMod.cf.can_id = cancomm_gw_mod_id(op, mod);
+        fdMod.cf.len = mod->len;
+        memcpy(fdMod.cf.data, mod->data, CANFD_MAX_DLEN);
+        fdMod.modtype = modType;
+        (void)cancomm_link_attr_add(msg, fdModAttrs[op], &fdMod, sizeof(fdMod));
+      }
+      else
+      {
+        memset(&classicMod, 0, sizeof(classicMod));
+        classicMod.cf.can_id = cancomm_gw_mod_id(op, mod);
+        classicMod.cf.len = mod->len;
+        memcpy(classicMod.cf.data, mod->data, CAN_MAX_DLEN);
+        classicMod.modtype = modType;
+        (void)cancomm_link_attr_add(msg, modAttrs[op], &classicMod, 
+                                    sizeof(classicMod));
+      }
+    }
+  }
+} /*** end of cancomm_gw_mod_attr_add ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to obtain the CAN identifier operand of a modification, in
+**            the format of the kernel. The AND operation keeps the identifier type and
+**            the other flags of the frame, the OR and XOR operations only affect the 
+**            identifier bits and the SET operation sets the identifier type as well.
+** \param     op Operation of the modification (CANCOMM_GW_OP_xxx).
+** \param     mod Pointer to the modification.
+** \return    The CAN identifier operand.
+**
+****************************************************************************************/
+static canid_t cancomm_gw_mod_id(uint32_t op, cancomm_gw_mod_t const * mod)
+{
+  canid_t result = 0;
+
+  /* Verify parameter. */
+  assert(mod != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (mod != NULL)
+  {
+    if (op == CANCOMM_GW_OP_AND)
+    {
+      result = (mod->id & CAN_EFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG;
+    }
+    else if (op == CANCOMM_GW_OP_SET)
+    {
+      result = (mod->ext == CANCOMM_TRUE) ? ((mod->id & CAN_EFF_MASK) | CAN_EFF_FLAG) : 
+                                            (mod->id & CAN_SFF_MASK);
+    }
+    else
+    {
+      result = mod->id & CAN_EFF_MASK;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_mod_id ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to apply the operation of a modification to a value.
+** \param     op Operation of the modification (CANCOMM_GW_OP_xxx).
+** \param     value The value to modify.
+** \param     operand The operand of the modification.
+** \return    The modified value.
+**
+****************************************************************************************/
+static uint32_t cancomm_gw_op(uint32_t op, uint32_t value, uint32_t operand)
+{
+  uint32_t result;
+
+  if (op == CANCOMM_GW_OP_AND)
+  {
+    result = value & operand;
+  }
+  else if (op == CANCOMM_GW_OP_OR)
+  {
+    result = value | operand;
+  }
+  else if (op == CANCOMM_GW_OP_XOR)
+  {
+    result = value ^ operand;
+  }
+  else
+  {
+    result = operand;
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_op ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to build the lookup table of a CRC8 checksum, the way the
+**            kernel's CAN gateway expects it: most significant bit first, without
+**            reflection.
+** \param     poly Polynomial of the CRC8 checksum, such as 0x1D for SAE J1850.
+** \param     table Pointer to where the 256 entries of the lookup table are stored.
+**
+****************************************************************************************/
+static void cancomm_gw_crc8_table(uint8_t poly, uint8_t * table)
+{
+  uint8_t crc;
+
+  /* Verify parameter. */
+  assert(table != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (table != NULL)
+  {
+    for (uint32_t idx = 0; idx < 256U; idx++)
+    {
+      crc = (uint8_t)idx;
+      for (uint8_t bit = 0; bit < 8U; bit++)
+      {
+        crc = ((crc & 0x80U) != 0) ? (uint8_t)((crc << 1) ^ poly) : (uint8_t)(crc << 1);
+      }
+      table[idx] = crc;
+    }
+  }
+} /*** end of cancomm_gw_crc8_table ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to check that the indices of a checksum are in range, the
+**            same way as the kernel's CAN gateway does.
+** \param     csum Pointer to the checksum.
+** \param     lenMax Maximum number of data bytes of the frames that the route forwards.
+** \return    CANCOMM_TRUE if the checksum is disabled or its indices are valid.
+**            CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_gw_csum_valid(cancomm_gw_csum_t const * csum, uint8_t lenMax)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameter. */
+  assert(csum != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (csum != NULL)
+  {
+    if ((csum->enabled != CANCOMM_TRUE) ||
+        ((csum->from >= -lenMax) && (csum->from < lenMax) && 
+         (csum->to >= -lenMax) && (csum->to < lenMax) && 
+         (csum->result >= -lenMax) && (csum->result < lenMax)))
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_gw_csum_valid ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to update a checksum in the data bytes of a frame, the same
+**            way as the kernel's CAN gateway does. Negative indices count from the end
+**            of the frame. Nothing is updated if they point before its start.
+** \param     csum Pointer to the checksum.
+** \param     crc8Table Pointer to the lookup table of a CRC8 checksum. NULL for an XOR
+**            checksum.
+** \param     data Pointer to the data bytes of the frame.
+** \param     len Number of data bytes of the frame.
+**
+****************************************************************************************/
+static void cancomm_gw_csum_apply(cancomm_gw_csum_t const * csum, 
+                                  uint8_t const * crc8Table, uint8_t * data, 
+                                  uint8_t len)
+{
+  int32_t from;
+  int32_t to;
+  int32_t res;
+  int32_t step;
+  uint8_t value;
+
+  /* Verify parameters. */
+  assert((csum != NULL) && (data != NULL));
+
+  /* Only continue with valid parameters and if the checksum is enabled. */
+  if ((csum != NULL) && (data != NULL) && (csum->enabled == CANCOMM_TRUE))
+  {
+    /* Convert the indices that count from the end of the frame. */
+    from = (csum->from < 0) ? ((int32_t)len + csum->from) : csum->from;
+    to = (csum->to < 0) ? ((int32_t)len + csum->to) : csum->to;
+    res = (csum->result < 0) ? ((int32_t)len + csum->result) : csum->result;
+    if ((from >= 0) && (to >= 0) && (res >= 0))
+    {
+      /* The data bytes are processed from the first to the last index, which can be
+       * either way around.
+       */
+      step = (from <= to) ? 1 : -1;
+      value = csum->init;
+      for (int32_t idx = from; idx != (to + step); idx += step)
+      {
+        value = (crc8Table != NULL) ? crc8Table[value ^ data[idx]] : 
+                                      (uint8_t)(value ^ data[idx]);
+      }
+      data[res] = (crc8Table != NULL) ? (uint8_t)(value ^ csum->final_xor) : value;
+    }
+  }
+} /*** end of cancomm_gw_csum_apply ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to compile a route of a forwarder.
+** \param     route Pointer to the route.
+** \param     compiled Pointer to where the compiled route is stored.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE if a CAN device does not exist or
+**            a checksum index is out of range.
+**
+****************************************************************************************/
+static uint8_t cancomm_forwarder_compile(cancomm_gw_route_t const * route,
+                                         struct cancomm_forwarder_route * compiled)
+{
+  uint8_t result = CANCOMM_FALSE;
+  uint8_t lenMax;
+  uint32_t idMask;
+
+  /* Verify parameters. */
+  assert((route != NULL) && (compiled != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((route != NULL) && (compiled != NULL))
+  {
+    /* Look up the CAN devices. */
+    compiled->key = 0;
+    compiled->next = 0;
+    compiled->src_ifindex = 0;
+    compiled->dst_ifindex = 0;
+    if ((route->src_device != NULL) && (route->dst_device != NULL))
+    {
+      compiled->src_ifindex = if_nametoindex(route->src_device);
+      compiled->dst_ifindex = if_nametoindex(route->dst_device);
+    }
+    compiled->fd_flag = ((route->flags & CANCOMM_GW_FLAG_CANFD) != 0) ? 
+                        CANCOMM_FLAG_CANFD_MSG : 0;
+    lenMax = (compiled->fd_flag != 0) ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    if ((compiled->src_ifindex != 0) && (compiled->dst_ifindex != 0) && 
+        (cancomm_gw_csum_valid(&route->csum_xor, lenMax) == CANCOMM_TRUE) && 
+        (cancomm_gw_csum_valid(&route->csum_crc8, lenMax) == CANCOMM_TRUE))
+    {
+      /* A filter that selects a single CAN identifier makes the route go into the 
+       * hash table. Without a filter, the route passes all frames.
+       */
+      compiled->filter.can_id = 0;
+      compiled->filter.can_mask = 0;
+      if (route->filter != NULL)
+      {
+        cancomm_filter_convert(route->filter, &compiled->filter);
+        idMask = (route->filter->ext == CANCOMM_TRUE) ? CAN_EFF_MASK : CAN_SFF_MASK;
+        if ((route->filter->invert != CANCOMM_TRUE) && 
+            ((route->filter->mask & idMask) == idMask))
+        {
+          compiled->key = cancomm_frame_key(route->filter->id, route->filter->ext,
+                                            compiled->src_ifindex);
+        }
+      }
+      /* Copy the modifications and prepare the checksums. */
+      compiled->mods[CANCOMM_GW_OP_AND] = route->mod_and;
+      compiled->mods[CANCOMM_GW_OP_OR] = route->mod_or;
+      compiled->mods[CANCOMM_GW_OP_XOR] = route->mod_xor;
+      compiled->mods[CANCOMM_GW_OP_SET] = route->mod_set;
+      compiled->csum_xor = route->csum_xor;
+      compiled->csum_crc8 = route->csum_crc8;
+      if (route->csum_crc8.enabled == CANCOMM_TRUE)
+      {
+        cancomm_gw_crc8_table(route->csum_crc8.poly, compiled->crc8_table);
+      }
+      /* Route successfully compiled. */
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_forwarder_compile ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to find the entry of a key in the hash table of a
+**            forwarder.
+** \param     forwarder Non-opaque forwarder.
+** \param     key Key of the CAN message on its CAN device.
+** \return    Pointer to the entry with the key, or to the unused entry where the key
+**            belongs, if it is not in the table.
+**
+****************************************************************************************/
+static struct cancomm_forwarder_bucket * cancomm_forwarder_find(
+  struct cancomm_forwarder * forwarder, uint64_t key)
+{
+  struct cancomm_forwarder_bucket * result = NULL;
+  size_t idx;
+
+  /* Verify parameter. */
+  assert((forwarder != NULL) && (forwarder->buckets != NULL));
+
+  /* Only continue with a valid parameter. */
+  if ((forwarder != NULL) && (forwarder->buckets != NULL))
+  {
+    /* Fibonacci hashing, the same way as in the snapshot table. Probe linearly. The 
+     * table is never full, so an unused entry always ends it.
+     */
+    idx = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & forwarder->buckets_mask;
+    while ((forwarder->buckets[idx].key != key) && (forwarder->buckets[idx].key != 0))
+    {
+      idx = (idx + 1U) & forwarder->buckets_mask;
+    }
+    result = &forwarder->buckets[idx];
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_forwarder_find ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to forward a received frame along a route of a forwarder.
+**            The modified frame is queued for transmission. The queued frames are 
+**            transmitted once the queue is full.
+** \param     forwarder Non-opaque forwarder.
+** \param     route Pointer to the compiled route, whose filter the frame passed.
+** \param     frame Pointer to the received frame.
+** \param     deadline Absolute point in time of the monotonic clock at which to stop
+**            waiting for space in the transmit queue. NULL to wait without a timeout.
+** \param     forwarded Pointer to the number of transmitted frames, which is updated.
+**
+****************************************************************************************/
+static void cancomm_forwarder_route(struct cancomm_forwarder * forwarder,
+                                    struct cancomm_forwarder_route const * route,
+                                    cancomm_frame_t const * frame,
+                                    struct timespec const * deadline,
+                                    size_t * forwarded)
+{
+  cancomm_frame_t * txFrame;
+  cancomm_gw_mod_t const * mod;
+  canid_t canId;
+  uint8_t lenMax;
+  uint32_t len;
+
+  /* Verify parameters. */
+  assert((forwarder != NULL) && (route != NULL) && (frame != NULL) && 
+         (forwarded != NULL));
+
+  /* Only continue with valid parameters and if the route forwards this frame type. */
+  if ((forwarder != NULL) && (route != NULL) && (frame != NULL) && 
+      (forwarded != NULL) && ((frame->flags & CANCOMM_FLAG_CANFD_MSG) == route->fd_flag))
+  {
+    txFrame = &forwarder->tx_frames[forwarder->tx_cnt];
+    *txFrame = *frame;
+    lenMax = (route->fd_flag != 0) ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    canId = (frame->ext == CANCOMM_TRUE) ? ((frame->id & CAN_EFF_MASK) | CAN_EFF_FLAG) : 
+                                           (frame->id & CAN_SFF_MASK);
+    len = frame->len;
+    /* Apply the modifications in the same order as the kernel does. */
+    for (uint32_t op = 0; op < CANCOMM_GW_OPS; op++)
+    {
+      mod = &route->mods[op];
+      if ((mod->members & CANCOMM_GW_MOD_ID) != 0)
+      {
+        canId = cancomm_gw_op(op, canId, cancomm_gw_mod_id(op, mod));
+      }
+      if ((mod->members & CANCOMM_GW_MOD_LEN) != 0)
+      {
+        len = cancomm_gw_op(op, len, mod->len) & 0xFFU;
+      }
+      if ((mod->members & CANCOMM_GW_MOD_DATA) != 0)
+      {
+        for (uint8_t idx = 0; idx < lenMax; idx++)
+        {
+          txFrame->data[idx] = (uint8_t)cancomm_gw_op(op, txFrame->data[idx], 
+                                                      mod->data[idx]);
+        }
+      }
+    }
+    /* Drop the frame if its data no longer fits. Otherwise update the checksums and
+     * queue it for transmission on the destination CAN device.
+     */
+    if (len <= lenMax)
+    {
+      txFrame->ext = ((canId & CAN_EFF_FLAG) != 0) ? CANCOMM_TRUE : CANCOMM_FALSE;
+      txFrame->id = canId & ((txFrame->ext == CANCOMM_TRUE) ? CAN_EFF_MASK : 
+                                                              CAN_SFF_MASK);
+      txFrame->len = (uint8_t)len;
+      txFrame->ifindex = route->dst_ifindex;
+      cancomm_gw_csum_apply(&route->csum_crc8, route->crc8_table, txFrame->data, 
+                            txFrame->len);
+      cancomm_gw_csum_apply(&route->csum_xor, NULL, txFrame->data, txFrame->len);
+      forwarder->tx_cnt++;
+      if (forwarder->tx_cnt == CANCOMM_FORWARDER_BATCH_SIZE)
+      {
+        cancomm_forwarder_flush(forwarder, deadline, forwarded);
+      }
+    }
+  }
+} /*** end of cancomm_forwarder_route ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to transmit the frames that a forwarder queued. When the
+**            transmit queue is full, it waits until the queue has space again. Frames
+**            that cannot be transmitted are dropped, the same way as the kernel's CAN 
+**            gateway does.
+** \param     forwarder Non-opaque forwarder.
+** \param     deadline Absolute point in time of the monotonic clock at which to stop
+**            waiting for space in the transmit queue. NULL to wait without a timeout.
+** \param     forwarded Pointer to the number of transmitted frames, which is updated.
+**
+****************************************************************************************/
+static void cancomm_forwarder_flush(struct cancomm_forwarder * forwarder,
+                                    struct timespec const * deadline,
+                                    size_t * forwarded)
+{
+  size_t offset = 0;
+  size_t sent;
+  uint8_t txResult;
+
+  /* Verify parameters. */
+  assert((forwarder != NULL) && (forwarded != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((forwarder != NULL) && (forwarded != NULL))
+  {
+    while (offset < forwarder->tx_cnt)
+    {
+      txResult = cancomm_transmit_batch(forwarder->ctx, &forwarder->tx_frames[offset],
+                                        forwarder->tx_cnt - offset, &sent);
+      offset += sent;
+      *forwarded += sent;
+      if ((txResult != CANCOMM_TRUE) && (cancomm_last_tx_queue_full() == CANCOMM_TRUE))
+      {
+        /* Drop the remaining frames, if the queue does not get space in time. */
+        if (cancomm_tx_space_wait(forwarder->ctx, deadline) != CANCOMM_TRUE)
+        {
+          break;
+        }
+      }
+      else if (txResult != CANCOMM_TRUE)
+      {
+        /* Drop the frame that could not be transmitted and continue after it. */
+        offset++;
+      }
+    }
+    forwarder->tx_cnt = 0;
+  }
+} /*** end of cancomm_forwarder_flush ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function with the implementation of cancomm_transmit_batch() and
+**            cancomm_transmit_scheduled().
+** \param     ctx Non-opaque CAN communication context.
+** \param     frames Pointer to the array with frames to transmit.
+** \param     count Number of frames in the array.
+** \param     sent Pointer to where the number of frames that were actually submitted
+**            for transmission is written.
+** \param     scheduled CANCOMM_TRUE to pass the timestamp member of each frame to the
+**            kernel as its launch time (SCM_TXTIME). CANCOMM_FALSE to transmit right
+**            away and store the timestamp of the transmit event in the frames instead.
+** \return    CANCOMM_TRUE if all frames were successfully submitted for transmission.
+**            CANCOMM_FALSE otherwise. cancomm_last_tx_queue_full() then tells if
+**            submission stopped, because the transmit queue was full.
+**
+****************************************************************************************/
+static uint8_t cancomm_frames_send(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                   size_t count, size_t * sent, uint8_t scheduled)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct canfd_frame canTxFrames[CANCOMM_BATCH_CHUNK_SIZE];
+  struct mmsghdr msgs[CANCOMM_BATCH_CHUNK_SIZE];
+  struct iovec iovs[CANCOMM_BATCH_CHUNK_SIZE];
+  struct sockaddr_can addrs[CANCOMM_BATCH_CHUNK_SIZE];
+  union
+  {
+    char           buf[CMSG_SPACE(sizeof(uint64_t))];
+    struct cmsghdr align;
+  } ctrls[CANCOMM_BATCH_CHUNK_SIZE];
+  struct cmsghdr * cmsg;
+  size_t chunkSize;
+  size_t frameSize;
+  uint32_t ifindex;
+  uint8_t frameInvalid = CANCOMM_FALSE;
+  uint8_t queueFull = CANCOMM_FALSE;
+  uint64_t timestamp;
+  int msgCnt;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (sent != NULL));
+
+  /* Only continue with a valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (sent != NULL))
+  {
+    /* Reset the submitted frame count. */
+    *sent = 0;
+
+    /* Only transmit if actually connected. */
+    if (ctx->socket != CANCOMM_INVALID_SOCKET)
+    {
+      /* Keep submitting chunks of frames, until all are submitted, or until the kernel
+       * does not accept more frames.
+       */
+      while ((*sent < count) && (frameInvalid == CANCOMM_FALSE))
+      {
+        /* Construct the transmit frames for this chunk. Stop at the first frame that
+         * cannot be transmitted, such that all frames before it are still submitted.
+         */
+        chunkSize = 0;
+        while ((chunkSize < CANCOMM_BATCH_CHUNK_SIZE) && ((*sent + chunkSize) < count))
+        {
+          cancomm_frame_t const * frame = &frames[*sent + chunkSize];
+          /* Determine the device to transmit on. */
+          ifindex = (frame->ifindex != 0) ? frame->ifindex : ctx->tx_ifindex;
+          if ((ifindex == 0) ||
+              (cancomm_frame_pack(ctx, frame->id, frame->ext, frame->len, 
+                                  frame->data, frame->flags, &canTxFrames[chunkSize],
+                                  &frameSize) != CANCOMM_TRUE))
+          {
+            frameInvalid = CANCOMM_TRUE;
+            break;
+          }
+          iovs[chunkSize].iov_base = &canTxFrames[chunkSize];
+          iovs[chunkSize].iov_len = frameSize;
+          memset(&msgs[chunkSize], 0, sizeof(struct mmsghdr));
+          msgs[chunkSize].msg_hdr.msg_iov = &iovs[chunkSize];
+          msgs[chunkSize].msg_hdr.msg_iovlen = 1;
+          /* Address the frame, unless it goes to the device the socket is bound to. */
+          if (ifindex != ctx->ifindex)
+          {
+            memset(&addrs[chunkSize], 0, sizeof(struct sockaddr_can));
+            addrs[chunkSize].can_family = AF_CAN;
+            addrs[chunkSize].can_ifindex = (int)ifindex;
+            msgs[chunkSize].msg_hdr.msg_name = &addrs[chunkSize];
+            msgs[chunkSize].msg_hdr.msg_namelen = sizeof(struct sockaddr_can);
+          }
+          /* Attach the launch time, if scheduled. */
+          if (scheduled == CANCOMM_TRUE)
+          {
+            msgs[chunkSize].msg_hdr.msg_control = ctrls[chunkSize].buf;
+            msgs[chunkSize].msg_hdr.msg_controllen = sizeof(ctrls[chunkSize].buf);
+            cmsg = CMSG_FIRSTHDR(&msgs[chunkSize].msg_hdr);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+            memcpy(CMSG_DATA(cmsg), &frame->timestamp, sizeof(uint64_t));
+          }
+          chunkSize++;
+        }
+        /* Nothing to submit? */
+        if (chunkSize == 0)
+        {
+          break;
+        }
+        /* Hand the frames of this chunk over to the kernel with just one system call. 
+         * The io_uring backend does not pass on launch times.
+         */
+        if ((ctx->uring != NULL) && (scheduled == CANCOMM_FALSE))
+        {
+          msgCnt = (int)cancomm_uring_transmit(ctx, msgs, chunkSize);
+        }
+        else
+        {
+          errno = 0;
+          msgCnt = sendmmsg(ctx->socket, msgs, (unsigned int)chunkSize, 0);
+        }
+        /* Stop if the kernel did not accept a single frame. After a partial chunk, the
+         * next attempt reports why the kernel stopped accepting frames.
+         */
+        if (msgCnt <= 0)
+        {
+          queueFull = cancomm_tx_queue_full();
+          break;
+        }
+        /* Get the timestamp of the transmit event and store it in the submitted 
+         * frames. Scheduled frames keep their launch time.
+         */
+        if (scheduled == CANCOMM_FALSE)
+        {
+          timestamp = cancomm_timestamp_now(ctx);
+          for (int idx = 0; idx < msgCnt; idx++)
+          {
+            frames[*sent + (size_t)idx].timestamp = timestamp;
+          }
+        }
+        *sent += (size_t)msgCnt;
+      }
+
+      /* Update the result. */
+      if (*sent == count)
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+    /* Account the transmit attempt. */
+    cancomm_stats_tx(ctx, *sent, result, queueFull);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_frames_send ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to enable launch times (SO_TXTIME) on the context's socket,
+**            upon first use. The launch times are absolute times of CLOCK_TAI in
+**            nanoseconds. The setting lasts until the context disconnects.
+** \param     ctx Non-opaque CAN communication context.
+** \return    CANCOMM_TRUE if launch times are enabled, CANCOMM_FALSE if not connected or
+**            if the kernel does not support SO_TXTIME on CAN raw sockets.
+**
+****************************************************************************************/
+static uint8_t cancomm_txtime_enable(struct cancomm_ctx * ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct sock_txtime txtime = { 0 };
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    if (!atomic_load_explicit(&ctx->txtime_enabled, memory_order_relaxed))
+    {
+      txtime.clockid = CLOCK_TAI;
+      if (setsockopt(ctx->socket, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) == 0)
+      {
+        atomic_store_explicit(&ctx->txtime_enabled, true, memory_order_relaxed);
+      }
+    }
+    if (atomic_load_explicit(&ctx->txtime_enabled, memory_order_relaxed))
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_txtime_enable ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to size the buffers of the context's socket, as configured
+**            with options CANCOMM_OPT_SNDBUF and CANCOMM_OPT_RCVBUF. Processes with the
+**            CAP_NET_ADMIN capability may exceed the limits of the system. For other
+**            processes, the kernel clamps the sizes to these limits (net.core.wmem_max
+**            and net.core.rmem_max).
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_buffers_apply(struct cancomm_ctx const * ctx)
+{
+  int size;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    if (ctx->opt_sndbuf > 0)
+    {
+      size = (int)ctx->opt_sndbuf;
+      if (setsockopt(ctx->socket, SOL_SOCKET, SO_SNDBUFFORCE, &size, sizeof(size)) != 0)
+      {
+        (void)setsockopt(ctx->socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+      }
+    }
+    if (ctx->opt_rcvbuf > 0)
+    {
+      size = (int)ctx->opt_rcvbuf;
+      if (setsockopt(ctx->socket, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0)
+      {
+        (void)setsockopt(ctx->socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+      }
+    }
+  }
+} /*** end of cancomm_buffers_apply ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to determine if the most recent transmit attempt failed,
+**            because the queue of the socket or of the CAN device is full. Evaluates
+**            errno, so call it right after the failed attempt.
+** \return    CANCOMM_TRUE if the queue is full, CANCOMM_FALSE for other errors.
+**
+****************************************************************************************/
+static uint8_t cancomm_tx_queue_full(void)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* A full socket send buffer reports EAGAIN. A full queue of the CAN device, as set
+   * with txqueuelen, reports ENOBUFS.
+   */
+  if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS))
+  {
+    result = CANCOMM_TRUE;
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_tx_queue_full ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to add a value to a counter of the statistics. A relaxed
+**            atomic operation suffices, because the counter does not order any other
+**            memory accesses.
+** \param     counter Pointer to the counter.
+** \param     value Value to add.
+**
+****************************************************************************************/
+static void cancomm_stats_add(atomic_uint_fast64_t * counter, uint64_t value)
+{
+  /* Verify parameter. */
+  assert(counter != NULL);
+
+  /* Only continue with a valid parameter and if there is something to add. Skips the
+   * atomic operation in the common case of nothing to count.
+   */
+  if ((counter != NULL) && (value > 0))
+  {
+    (void)atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+  }
+} /*** end of cancomm_stats_add ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to account a transmit attempt in the statistics.
+** \param     ctx Non-opaque CAN communication context.
+** \param     sent Number of frames that were submitted for transmission.
+** \param     result Result of the transmit attempt.
+** \param     queueFull CANCOMM_TRUE if the transmit attempt stopped, because the 
+**            transmit queue is full.
+**
+****************************************************************************************/
+static void cancomm_stats_tx(struct cancomm_ctx * ctx, size_t sent, uint8_t result,
+                             uint8_t queueFull)
+{
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Remember why the transmit attempt failed, for cancomm_last_tx_queue_full(). */
+  cancomm_tx_queue_full_flag = ((result != CANCOMM_TRUE) && (queueFull == CANCOMM_TRUE)) ?
+                               CANCOMM_TRUE : CANCOMM_FALSE;
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    cancomm_stats_add(&ctx->stats.tx_frames, sent);
+    if (cancomm_tx_queue_full_flag == CANCOMM_TRUE)
+    {
+      cancomm_stats_add(&ctx->stats.tx_queue_full, 1);
+    }
+    else if (result != CANCOMM_TRUE)
+    {
+      cancomm_stats_add(&ctx->stats.tx_errors, 1);
+    }
+  }
+} /*** end of cancomm_stats_tx ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to account the frames that the kernel dropped on the 
+**            packet socket of the packet mmap backend, because its ring was full. The
+**            kernel resets its count upon each read.
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_stats_packet_drops(struct cancomm_ctx * ctx)
+{
+  struct tpacket_stats_v3 pktStats;
+  socklen_t len = sizeof(pktStats);
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if the packet socket is open. */
+  if ((ctx != NULL) && (ctx->pkt_fd >= 0))
+  {
+    if (getsockopt(ctx->pkt_fd, SOL_PACKET, PACKET_STATISTICS, &pktStats, &len) == 0)
+    {
+      cancomm_stats_add(&ctx->stats.rx_overflows, pktStats.tp_drops);
+    }
+  }
+} /*** end of cancomm_stats_packet_drops ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to construct a frame, as needed for transmission on the
+**            CAN raw socket.
+** \param     ctx Non-opaque CAN communication context.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
+**            29-bit.
+** \param     len Number of CAN message data bytes.
+** \param     data Pointer to array with data bytes.
+** \param     flags Bit flags for providing additional information about how to transmit
+**            the message. See cancomm_transmit().
+** \param     raw Pointer to where the constructed frame is stored.
+** \param     size Pointer to where the number of bytes to write to the socket is stored.
+** \return    CANCOMM_TRUE if the frame was constructed. CANCOMM_FALSE if the data does
+**            not fit in the frame.
+**
+****************************************************************************************/
+static uint8_t cancomm_frame_pack(struct cancomm_ctx const * ctx, uint32_t id, 
+                                  uint8_t ext, uint8_t len, uint8_t const * data, 
+                                  uint8_t flags, struct canfd_frame * raw, size_t * size)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (data != NULL) && (raw != NULL) && (size != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (data != NULL) && (raw != NULL) && (size != NULL))
+  {
+    /* Construct the frame with the inline fast path, for the mode of the socket. */
+    result = cancomm_inline_frame_pack(id, ext, len, data, flags, ctx->fd_enabled, raw, 
+                                       size);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_frame_pack ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to convert an acceptance filter to the format of the 
+**            kernel. The mask always includes the identifier type and remote frame
+**            bits. This way 11-bit filters do not pass 29-bit messages and vice versa.
+**            Remote frames are ignored by this library anyway.
+** \param     filter Pointer to the acceptance filter.
+** \param     canFilter Pointer to where the filter in the format of the kernel is 
+**            stored.
+**
+****************************************************************************************/
+static void cancomm_filter_convert(cancomm_filter_t const * filter, 
+                                   struct can_filter * canFilter)
+{
+  /* Verify parameters. */
+  assert((filter != NULL) && (canFilter != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((filter != NULL) && (canFilter != NULL))
+  {
+    if (filter->ext == CANCOMM_TRUE)
+    {
+      canFilter->can_id = (filter->id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+      canFilter->can_mask = (filter->mask & CAN_EFF_MASK);
+    }
+    else
+    {
+      canFilter->can_id = (filter->id & CAN_SFF_MASK);
+      canFilter->can_mask = (filter->mask & CAN_SFF_MASK);
+    }
+    canFilter->can_mask |= CAN_EFF_FLAG | CAN_RTR_FLAG;
+    if (filter->invert == CANCOMM_TRUE)
+    {
+      canFilter->can_id |= CAN_INV_FILTER;
+    }
+  }
+} /*** end of cancomm_filter_convert ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to configure the acceptance filters and the CAN error
+**            frame mask of the context on its socket.
+** \param     ctx Non-opaque CAN communication context.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_filters_apply(struct cancomm_ctx const * ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct can_filter acceptAll = { 0 };
+  struct can_filter const * filters = &acceptAll;
+  socklen_t filtersSize = sizeof(acceptAll);
+  can_err_mask_t errMask;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    errMask = ctx->err_mask;
+    /* Without configured filters, use the default filter of the kernel that accepts
+     * all CAN messages (identifier 0 and mask 0).
+     */
+    if (ctx->filters_set == CANCOMM_TRUE)
+    {
+      filters = ctx->filters;
+      filtersSize = (socklen_t)(ctx->filters_cnt * sizeof(struct can_filter));
+    }
+    /* The packet mmap backend receives through its packet socket and evaluates the
+     * filters in user space. An empty filter list and error mask stop the raw socket
+     * from queuing frames, that would never be read.
+     */
+    if (ctx->opt_backend == CANCOMM_BACKEND_PACKET_MMAP)
+    {
+      filters = NULL;
+      filtersSize = 0;
+      errMask = 0;
+    }
+    /* Configure the acceptance filters and the error frame mask. */
+    if ((setsockopt(ctx->socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters, 
+                    filtersSize) == 0) &&
+        (setsockopt(ctx->socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errMask, 
+                    sizeof(errMask)) == 0))
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_filters_apply ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to evaluate the acceptance filters and the CAN error frame
+**            mask of the context in user space, with the same semantics as the kernel.
+**            Needed by receive backends that bypass the filters of the CAN raw socket.
+** \param     ctx Non-opaque CAN communication context.
+** \param     canId Identifier of the received frame, including the kernel's flags.
+** \return    CANCOMM_TRUE if the frame passes, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_filters_match(struct cancomm_ctx const * ctx, canid_t canId)
+{
+  uint8_t result = CANCOMM_FALSE;
+  canid_t filterId;
+  canid_t filterMask;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Error frames just need to match one of the error classes of the mask. */
+    if ((canId & CAN_ERR_FLAG) != 0)
+    {
+      if ((canId & ctx->err_mask & CAN_ERR_MASK) != 0)
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+    /* Without configured filters, all CAN messages pass. */
+    else if (ctx->filters_set == CANCOMM_FALSE)
+    {
+      result = CANCOMM_TRUE;
+    }
+    else
+    {
+      /* The CAN message passes if at least one of the filters matches. */
+      for (uint32_t idx = 0; idx < ctx->filters_cnt; idx++)
+      {
+        filterId = ctx->filters[idx].can_id & ~CAN_INV_FILTER;
+        filterMask = ctx->filters[idx].can_mask;
+        if (((canId & filterMask) == (filterId & filterMask)) != 
+            ((ctx->filters[idx].can_id & CAN_INV_FILTER) != 0))
+        {
+          result = CANCOMM_TRUE;
+          break;
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_filters_match ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to obtain the interface index and the MTU of a CAN device.
+** \param     canSocket Socket to use for the I/O control requests.
+** \param     device Null terminated string with the SocketCAN device name.
+** \param     ifindex Pointer to where the interface index is stored.
+** \param     mtu Pointer to where the MTU is stored. Either CAN_MTU or CANFD_MTU.
+** \return    CANCOMM_TRUE if the device exists, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_device_probe(int canSocket, char const * device, 
+                                    uint32_t * ifindex, int32_t * mtu)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct ifreq ifr;
+
+  /* Verify parameters. */
+  assert((device != NULL) && (ifindex != NULL) && (mtu != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((device != NULL) && (ifindex != NULL) && (mtu != NULL))
+  {
+    /* Create an ifreq structure for passing data in and out of ioctl. */
+    strncpy(ifr.ifr_name, device, IFNAMSIZ - 1);
+    ifr.ifr_name[IFNAMSIZ - 1] = '\0';
+
+    /* Determine if the CAN device is configured for CAN classic or CAN FD mode. Do so
+     * by reading the MTU size of the CAN device. For CAN classic it will be CAN_MTU.
+     * For CAN FD it will be CANFD_MTU.
+     */
+    *mtu = CAN_MTU;
+    /* Attempt to read the MTU value from the CAN device. */
+    if (ioctl(canSocket, SIOCGIFMTU, &ifr) >= 0)
+    {
+      /* Only update the MTU value if it is a supported value. */
+      if ( (ifr.ifr_mtu == CAN_MTU) || (ifr.ifr_mtu == CANFD_MTU) )
+      {
+        *mtu = ifr.ifr_mtu;
+      }
+    }
+
+    /* Obtain interface index. */
+    if (ioctl(canSocket, SIOCGIFINDEX, &ifr) >= 0)
+    {
+      *ifindex = (uint32_t)ifr.ifr_ifindex;
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_device_probe ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to determine if frames received from the CAN device with
+**            the specified interface index should be passed on to the caller.
+** \param     ctx Non-opaque CAN communication context.
+** \param     ifindex Interface index of the CAN device that the frame came from.
+** \return    CANCOMM_TRUE if the frame is accepted, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_ifindex_accepted(struct cancomm_ctx const * ctx, 
+                                        uint32_t ifindex)
+{
+  uint8_t result = CANCOMM_TRUE;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if connected to a set of devices. */
+  if ((ctx != NULL) && (ctx->rx_ifindexes_cnt > 0))
+  {
+    /* Search the device in the set. Linear, as a set holds just a few devices. */
+    result = CANCOMM_FALSE;
+    for (uint32_t idx = 0; idx < ctx->rx_ifindexes_cnt; idx++)
+    {
+      if (ctx->rx_ifindexes[idx] == ifindex)
+      {
+        result = CANCOMM_TRUE;
+        break;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_ifindex_accepted ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to construct the key that identifies a CAN message on a
+**            CAN device, for looking it up in a hash table. The snapshot table and the
+**            routes of the forwarder use it.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for 
+**            29-bit.
+** \param     ifindex Interface index of the CAN device.
+** \return    The key. Never zero for a valid interface index.
+**
+****************************************************************************************/
+static uint64_t cancomm_frame_key(uint32_t id, uint8_t ext, uint32_t ifindex)
+{
+  uint64_t result;
+
+  /* Combine the interface index with the identifier in the kernel's format. */
+  result = ((uint64_t)ifindex << 32) | 
+           ((ext == CANCOMM_TRUE) ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG) : 
+                                    (id & CAN_SFF_MASK));
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_frame_key ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to find the entry of a CAN message in the snapshot table.
+** \param     snapshot Pointer to the snapshot table.
+** \param     key Key of the CAN message.
+** \param     insert CANCOMM_TRUE to return the unused entry where the CAN message 
+**            belongs, if it is not in the table. Only for the writer.
+** \return    Pointer to the entry, or NULL if not found.
+**
+****************************************************************************************/
+static struct cancomm_snapshot_entry * cancomm_snapshot_find(
+  struct cancomm_snapshot * snapshot, uint64_t key, uint8_t insert)
+{
+  struct cancomm_snapshot_entry * result = NULL;
+  uint64_t entryKey;
+  size_t idx;
+
+  /* Verify parameter. */
+  assert(snapshot != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (snapshot != NULL)
+  {
+    /* Fibonacci hashing spreads consecutive identifiers over the array. */
+    idx = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & snapshot->mask;
+    /* Probe linearly. The array is never full, so an unused entry always ends it. */
+    for (;;)
+    {
+      entryKey = atomic_load_explicit(&snapshot->entries[idx].key, 
+                                      memory_order_acquire);
+      if (entryKey == key)
+      {
+        result = &snapshot->entries[idx];
+        break;
+      }
+      if (entryKey == 0)
+      {
+        if (insert == CANCOMM_TRUE)
+        {
+          result = &snapshot->entries[idx];
+        }
+        break;
+      }
+      idx = (idx + 1U) & snapshot->mask;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_snapshot_find ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to store received frames in the snapshot table, if
+**            enabled. Called by the receive path for all received frames.
+** \param     ctx Non-opaque CAN communication context.
+** \param     frames Pointer to the array with received frames.
+** \param     count Number of frames in the array.
+**
+****************************************************************************************/
+static void cancomm_snapshot_update(struct cancomm_ctx * ctx, 
+                                    cancomm_frame_t const * frames, size_t count)
+{
+  struct cancomm_snapshot * snapshot;
+  struct cancomm_snapshot_entry * entry;
+  uint64_t key;
+  uint64_t entryKey;
+  unsigned int seq;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL));
+
+  /* Only continue with valid parameters and if enabled. */
+  if ((ctx != NULL) && (frames != NULL) && (ctx->snapshot != NULL))
+  {
+    snapshot = ctx->snapshot;
+    for (size_t idx = 0; idx < count; idx++)
+    {
+      /* Error frames have no identifier to store them under. */
+      if ((frames[idx].flags & CANCOMM_FLAG_CANERR_MSG) != 0)
+      {
+        continue;
+      }
+      key = cancomm_frame_key(frames[idx].id, frames[idx].ext, frames[idx].ifindex);
+      entry = cancomm_snapshot_find(snapshot, key, CANCOMM_TRUE);
+      if (entry == NULL)
+      {
+        continue;
+      }
+      /* A new CAN message only goes in, if there is still room for it. */
+      entryKey = atomic_load_explicit(&entry->key, memory_order_relaxed);
+      if ((entryKey == 0) && (snapshot->used >= snapshot->max))
+      {
+        continue;
+      }
+      /* Write the entry, with an odd sequence counter during the write. */
+      seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+      atomic_store_explicit(&entry->seq, seq + 1U, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+      entry->len = frames[idx].len;
+      entry->flags = frames[idx].flags;
+      entry->timestamp = frames[idx].timestamp;
+      entry->count++;
+      memcpy(entry->data, frames[idx].data, frames[idx].len);
+      atomic_store_explicit(&entry->seq, seq + 2U, memory_order_release);
+      /* Publish a new CAN message to the readers, now that the entry is complete. */
+      if (entryKey == 0)
+      {
+        atomic_store_explicit(&entry->key, key, memory_order_release);
+        snapshot->used++;
+      }
+    }
+  }
+} /*** end of cancomm_snapshot_update ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function that reads all possibly received frames from the CAN raw
+**            socket, up to the specified maximum, in a non-blocking manner.
+** \param     ctx Non-opaque CAN communication context.
+** \param     frames Pointer to the array where the received frames are stored.
+** \param     max Maximum number of frames that fit in the array.
+** \return    Number of frames stored in the array.
+**
+****************************************************************************************/
+static size_t cancomm_raw_receive(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                  size_t max)
+{
+  size_t count = 0;
+  struct canfd_frame canRxFrames[CANCOMM_BATCH_CHUNK_SIZE];
+  struct mmsghdr msgs[CANCOMM_BATCH_CHUNK_SIZE];
+  struct iovec iovs[CANCOMM_BATCH_CHUNK_SIZE];
+  struct sockaddr_can addrs[CANCOMM_BATCH_CHUNK_SIZE];
+  union
+  {
+    char           buf[CANCOMM_CMSG_BUF_SIZE];
+    struct cmsghdr align;
+  } ctrl[CANCOMM_BATCH_CHUNK_SIZE];
+  size_t chunkSize;
+  int    msgCnt;
+  int64_t clockOffset;
+  size_t dropped = 0;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frames != NULL))
+  {
+    /* Determine the offset for converting the kernel's reception timestamps to the
+     * configured clock. Once for all frames, which saves clock reads.
+     */
+    clockOffset = cancomm_clock_offset(ctx);
+    /* Keep requesting chunks of frames from the kernel, until the caller's array is
+     * full or the socket's receive queue is empty.
+     */
+    while (count < max)
+    {
+      /* Determine how many frames to request with this chunk. */
+      chunkSize = max - count;
+      if (chunkSize > CANCOMM_BATCH_CHUNK_SIZE)
+      {
+        chunkSize = CANCOMM_BATCH_CHUNK_SIZE;
+      }
+      /* Prepare the message headers, one for each frame. */
+      for (size_t idx = 0; idx < chunkSize; idx++)
+      {
+        iovs[idx].iov_base = &canRxFrames[idx];
+        iovs[idx].iov_len = sizeof(struct canfd_frame);
+        memset(&msgs[idx], 0, sizeof(struct mmsghdr));
+        msgs[idx].msg_hdr.msg_name = &addrs[idx];
+        msgs[idx].msg_hdr.msg_namelen = sizeof(struct sockaddr_can);
+        msgs[idx].msg_hdr.msg_iov = &iovs[idx];
+        msgs[idx].msg_hdr.msg_iovlen = 1;
+        msgs[idx].msg_hdr.msg_control = ctrl[idx].buf;
+        msgs[idx].msg_hdr.msg_controllen = sizeof(ctrl[idx].buf);
+      }
+      /* Read as many frames as are available, up to the chunk size, with just one
+       * system call.
+       */
+      msgCnt = recvmmsg(ctx->socket, msgs, (unsigned int)chunkSize, 
+                        MSG_DONTWAIT, NULL);
+      /* Stop if nothing was there to read. */
+      if (msgCnt <= 0)
+      {
+        if ((msgCnt < 0) && ((count + dropped) == 0) && 
+            ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+          cancomm_stats_add(&ctx->stats.rx_empty, 1);
+        }
+        break;
+      }
+      /* Convert the frames and store them in the caller's array. */
+      for (int idx = 0; idx < msgCnt; idx++)
+      {
+        if (cancomm_inline_frame_unpack(&canRxFrames[idx], msgs[idx].msg_len, 
+                                        &frames[count]) != CANCOMM_TRUE)
+        {
+          dropped++;
+        }
+        else if (cancomm_ifindex_accepted(ctx, (uint32_t)addrs[idx].can_ifindex) 
+                 == CANCOMM_TRUE)
+        {
+          frames[count].ifindex = (uint32_t)addrs[idx].can_ifindex;
+          frames[count].timestamp = cancomm_timestamp_from_cmsg(ctx, 
+                                                                 &msgs[idx].msg_hdr,
+                                                                 clockOffset);
+          count++;
+        }
+      }
+      /* Less frames than requested means that the receive queue is now empty. */
+      if ((size_t)msgCnt < chunkSize)
+      {
+        break;
+      }
+    }
+    /* Account the received frames, once per call. */
+    cancomm_stats_add(&ctx->stats.rx_frames, count);
+    cancomm_stats_add(&ctx->stats.rx_dropped, dropped);
+  }
+
+  /* Give the result back to the caller. */
+  return count;
+} /*** end of cancomm_raw_receive ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to set up the packet mmap backend. Opens a packet socket
+**            with a TPACKET_V3 ring buffer, maps the ring into memory and binds the
+**            socket to the CAN device(s).
+** \param     ctx Non-opaque CAN communication context.
+** \param     ifindex Interface index of the CAN device to receive from. Zero for all
+**            devices.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_packet_open(struct cancomm_ctx * ctx, uint32_t ifindex)
+{
+  uint8_t result = CANCOMM_FALSE;
+  int version = TPACKET_V3;
+  int enable = 1;
+  int tsSource = SOF_TIMESTAMPING_RAW_HARDWARE;
+  struct tpacket_req3 req = { 0 };
+  struct sockaddr_ll addr = { 0 };
+  size_t mapSize = (size_t)CANCOMM_PACKET_BLOCK_SIZE * CANCOMM_PACKET_BLOCK_NR;
+  void * map;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Open the packet socket. It receives the CAN frames as the payload of the
+     * packets, without a link layer header.
+     */
+    ctx->pkt_fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (ctx->pkt_fd >= 0)
+    {
+      result = CANCOMM_TRUE;
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Request the ring buffer layout with variable sized frames in blocks. */
+      req.tp_block_size = CANCOMM_PACKET_BLOCK_SIZE;
+      req.tp_block_nr = CANCOMM_PACKET_BLOCK_NR;
+      req.tp_frame_size = CANCOMM_PACKET_FRAME_SIZE;
+      req.tp_frame_nr = (CANCOMM_PACKET_BLOCK_SIZE / CANCOMM_PACKET_FRAME_SIZE) * 
+                        CANCOMM_PACKET_BLOCK_NR;
+      req.tp_retire_blk_tov = CANCOMM_PACKET_BLOCK_TMO_MS;
+      if ((setsockopt(ctx->pkt_fd, SOL_PACKET, PACKET_VERSION, &version, 
+                      sizeof(version)) != 0) ||
+          (setsockopt(ctx->pkt_fd, SOL_PACKET, PACKET_RX_RING, &req, 
+                      sizeof(req)) != 0))
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Not interested in the copies of the frames that this host transmits. The
+       * kernel's loopback of these frames is still received, just like with the CAN
+       * raw socket. Not critical, so errors are ignored.
+       */
+      (void)setsockopt(ctx->pkt_fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &enable, 
+                       sizeof(enable));
+      /* Let the kernel store hardware timestamps in the ring, if requested. */
+      if (ctx->opt_timestamp == CANCOMM_TIMESTAMP_HW_NS)
+      {
+        (void)setsockopt(ctx->pkt_fd, SOL_PACKET, PACKET_TIMESTAMP, &tsSource, 
+                         sizeof(tsSource));
+      }
+      /* Map the ring buffer into memory. */
+      map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, 
+                 ctx->pkt_fd, 0);
+      if (map == MAP_FAILED)
+      {
+        /* Locking the pages counts against RLIMIT_MEMLOCK. Try without. */
+        map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, ctx->pkt_fd, 0);
+      }
+      if (map == MAP_FAILED)
+      {
+        result = CANCOMM_FALSE;
+      }
+      else
+      {
+        ctx->pkt_map = (uint8_t *)map;
+        ctx->pkt_block_idx = 0;
+        ctx->pkt_pkts_left = 0;
+        ctx->pkt_current = NULL;
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Bind the socket to the CAN device. Interface index 0 means all devices. */
+      addr.sll_family = AF_PACKET;
+      addr.sll_protocol = htons(ETH_P_ALL);
+      addr.sll_ifindex = (int)ifindex;
+      if (bind(ctx->pkt_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    /* Clean up in case of an error. */
+    if (result != CANCOMM_TRUE)
+    {
+      cancomm_packet_close(ctx);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_packet_open ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to release the resources of the packet mmap backend.
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_packet_close(struct cancomm_ctx * ctx)
+{
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Keep the count of dropped frames, before the socket goes. */
+    cancomm_stats_packet_drops(ctx);
+    if (ctx->pkt_map != NULL)
+    {
+      (void)munmap(ctx->pkt_map, 
+                   (size_t)CANCOMM_PACKET_BLOCK_SIZE * CANCOMM_PACKET_BLOCK_NR);
+      ctx->pkt_map = NULL;
+    }
+    if (ctx->pkt_fd >= 0)
+    {
+      close(ctx->pkt_fd);
+      ctx->pkt_fd = -1;
+    }
+    ctx->pkt_block_idx = 0;
+    ctx->pkt_pkts_left = 0;
+    ctx->pkt_current = NULL;
+  }
+} /*** end of cancomm_packet_close ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function that reads all possibly received frames from the memory
+**            mapped ring of the packet mmap backend, up to the specified maximum. Each
+**            block goes back to the kernel, as soon as all its frames were read.
+** \param     ctx Non-opaque CAN communication context.
+** \param     frames Pointer to the array where the received frames are stored.
+** \param     max Maximum number of frames that fit in the array.
+** \return    Number of frames stored in the array.
+**
+****************************************************************************************/
+static size_t cancomm_packet_receive(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                     size_t max)
+{
+  size_t count = 0;
+  struct tpacket_block_desc * block;
+  struct tpacket3_hdr const * pkt;
+  struct sockaddr_ll const * addr;
+  struct canfd_frame const * raw;
+  uint16_t protocol;
+  int64_t clockOffset = 0;
+  uint8_t offsetValid = CANCOMM_FALSE;
+  size_t dropped = 0;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL));
+
+  /* Only continue with valid parameters and if the ring is mapped. */
+  if ((ctx != NULL) && (frames != NULL) && (ctx->pkt_map != NULL))
+  {
+    while (count < max)
+    {
+      block = (struct tpacket_block_desc *)(ctx->pkt_map + 
+              ((size_t)ctx->pkt_block_idx * CANCOMM_PACKET_BLOCK_SIZE));
+      /* Start on the next block, once the kernel handed it over. */
+      if (ctx->pkt_current == NULL)
+      {
+        if ((*(volatile uint32_t *)&block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+        {
+          if ((count + dropped) == 0)
+          {
+            cancomm_stats_add(&ctx->stats.rx_empty, 1);
+          }
+          break;
+        }
+        /* Only read the block's contents after seeing its status. */
+        atomic_thread_fence(memory_order_acquire);
+        ctx->pkt_pkts_left = block->hdr.bh1.num_pkts;
+        ctx->pkt_current = (uint8_t *)block + block->hdr.bh1.offset_to_first_pkt;
+      }
+      /* Convert the next frame of the block. */
+      if (ctx->pkt_pkts_left > 0)
+      {
+        pkt = (struct tpacket3_hdr const *)ctx->pkt_current;
+        addr = (struct sockaddr_ll const *)((uint8_t const *)pkt + 
+               TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+        raw = (struct canfd_frame const *)((uint8_t const *)pkt + pkt->tp_mac);
+        protocol = ntohs(addr->sll_protocol);
+        /* Only CAN frames from accepted devices and that pass the filters. The
+         * socket also sees other network devices, when bound to all of them.
+         */
+        if ((addr->sll_hatype == ARPHRD_CAN) && 
+            ((protocol == ETH_P_CAN) || (protocol == ETH_P_CANFD)) &&
+            (addr->sll_pkttype != PACKET_OUTGOING) &&
+            (pkt->tp_snaplen >= CAN_MTU) &&
+            (cancomm_ifindex_accepted(ctx, (uint32_t)addr->sll_ifindex) 
+             == CANCOMM_TRUE) &&
+            (cancomm_filters_match(ctx, raw->can_id) == CANCOMM_TRUE))
+        {
+          /* Convert the frame. This also filters out invalid and remote frames. */
+          if (cancomm_inline_frame_unpack(raw, pkt->tp_snaplen, 
+                                          &frames[count]) != CANCOMM_TRUE)
+          {
+            dropped++;
+          }
+          else
+          {
+            frames[count].ifindex = (uint32_t)addr->sll_ifindex;
+            /* The hardware clock has its own time base, so report it as is. Software
+             * timestamps are based on the system time.
+             */
+            if ((pkt->tp_status & TP_STATUS_TS_RAW_HARDWARE) != 0)
+            {
+              frames[count].timestamp = ((uint64_t)pkt->tp_sec * 1000000000ULL) + 
+                                        (uint64_t)pkt->tp_nsec;
+            }
+            else
+            {
+              /* Determine the offset to the configured clock just once per call. */
+              if (offsetValid == CANCOMM_FALSE)
+              {
+                clockOffset = cancomm_clock_offset(ctx);
+                offsetValid = CANCOMM_TRUE;
+              }
+              frames[count].timestamp = cancomm_timestamp_convert(ctx, 
+                                        ((uint64_t)pkt->tp_sec * 1000000000ULL) + 
+                                        (uint64_t)pkt->tp_nsec + (uint64_t)clockOffset);
+            }
+            count++;
+          }
+        }
+        ctx->pkt_current += pkt->tp_next_offset;
+        ctx->pkt_pkts_left--;
+      }
+      /* Hand the block back to the kernel, once all its frames were read. */
+      if (ctx->pkt_pkts_left == 0)
+      {
+        atomic_thread_fence(memory_order_release);
+        *(volatile uint32_t *)&block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        ctx->pkt_block_idx = (ctx->pkt_block_idx + 1U) % CANCOMM_PACKET_BLOCK_NR;
+        ctx->pkt_current = NULL;
+      }
+    }
+    /* Account the received frames, once per call. */
+    cancomm_stats_add(&ctx->stats.rx_frames, count);
+    cancomm_stats_add(&ctx->stats.rx_dropped, dropped);
+  }
+
+  /* Give the result back to the caller. */
+  return count;
+} /*** end of cancomm_packet_receive ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to obtain the file descriptor that signals the reception
+**            of frames. This is the socket of the configured receive backend.
+** \param     ctx Non-opaque CAN communication context.
+** \return    The file descriptor.
+**
+****************************************************************************************/
+static int cancomm_rx_fd(struct cancomm_ctx const * ctx)
+{
+  int result = -1;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    if (ctx->uring != NULL)
+    {
+      /* Signals completions, so also transmit completions. */
+      result = ctx->uring->fd;
+    }
+    else if (ctx->pkt_fd >= 0)
+    {
+      result = ctx->pkt_fd;
+    }
+    else
+    {
+      result = ctx->socket;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_rx_fd ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to set up the io_uring backend. Creates the io_uring
+**            instance, maps its queues into memory, provides the receive buffers to the
+**            kernel and arms the multishot receive request.
+** \param     ctx Non-opaque CAN communication context.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_uring_open(struct cancomm_ctx * ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_uring * uring;
+  struct io_uring_params params = { 0 };
+  struct io_uring_buf_reg reg = { 0 };
+  size_t bufRingSize = CANCOMM_URING_RX_BUFS * sizeof(struct io_uring_buf);
+  void * map;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Allocate and initialize the backend state. */
+    uring = calloc(1, sizeof(struct cancomm_uring));
+    if (uring != NULL)
+    {
+      uring->fd = -1;
+      uring->sq_map = MAP_FAILED;
+      uring->cq_map = MAP_FAILED;
+      uring->sqes = MAP_FAILED;
+      uring->rx_map = MAP_FAILED;
+      for (uint32_t idx = 0; idx < CANCOMM_URING_TX_SLOTS; idx++)
+      {
+        uring->tx_free[idx] = (uint16_t)idx;
+      }
+      uring->tx_free_cnt = CANCOMM_URING_TX_SLOTS;
+      atomic_init(&uring->cq_busy, false);
+      atomic_init(&uring->rx_armed, false);
+      atomic_init(&uring->rx_pending_tail, 0);
+      atomic_init(&uring->tx_done_tail, 0);
+      atomic_init(&uring->tx_errors, 0);
+      (void)pthread_mutex_init(&uring->sq_lock, NULL);
+      ctx->uring = uring;
+      /* Create the io_uring instance. */
+      uring->fd = (int)syscall(__NR_io_uring_setup, CANCOMM_URING_ENTRIES, &params);
+      if (uring->fd >= 0)
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Map the submission and completion queue rings. Newer kernels map both with
+       * one call.
+       */
+      uring->sq_map_size = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+      uring->cq_map_size = params.cq_off.cqes + 
+                           (params.cq_entries * sizeof(struct io_uring_cqe));
+      if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+      {
+        if (uring->cq_map_size > uring->sq_map_size)
+        {
+          uring->sq_map_size = uring->cq_map_size;
+        }
+        uring->cq_map_size = 0;
+      }
+      uring->sq_map = mmap(NULL, uring->sq_map_size, PROT_READ | PROT_WRITE, 
+                           MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+      if (uring->cq_map_size != 0)
+      {
+        uring->cq_map = mmap(NULL, uring->cq_map_size, PROT_READ | PROT_WRITE, 
+                             MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+        map = uring->cq_map;
+      }
+      else
+      {
+        map = uring->sq_map;
+      }
+      uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+      uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, 
+                         MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+      if ((uring->sq_map == MAP_FAILED) || (map == MAP_FAILED) || 
+          (uring->sqes == MAP_FAILED))
+      {
+        result = CANCOMM_FALSE;
+      }
+      else
+      {
+        uring->sq_head = (uint32_t *)((uint8_t *)uring->sq_map + params.sq_off.head);
+        uring->sq_tail = (uint32_t *)((uint8_t *)uring->sq_map + params.sq_off.tail);
+        uring->sq_array = (uint32_t *)((uint8_t *)uring->sq_map + params.sq_off.array);
+        uring->sq_mask = *(uint32_t *)((uint8_t *)uring->sq_map + 
+                                       params.sq_off.ring_mask);
+        uring->sq_entries = params.sq_entries;
+        uring->sq_tail_local = *uring->sq_tail;
+        uring->cq_head = (uint32_t *)((uint8_t *)map + params.cq_off.head);
+        uring->cq_tail = (uint32_t *)((uint8_t *)map + params.cq_off.tail);
+        uring->cq_mask = *(uint32_t *)((uint8_t *)map + params.cq_off.ring_mask);
+        uring->cqes = (struct io_uring_cqe *)((uint8_t *)map + params.cq_off.cqes);
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Allocate the buffer ring, followed by the receive buffers. The buffer ring 
+       * needs to be page aligned, which mmap() takes care of.
+       */
+      uring->rx_map = mmap(NULL, bufRingSize + 
+                           (CANCOMM_URING_RX_BUFS * CANCOMM_URING_RX_BUF_SIZE),
+                           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (uring->rx_map == MAP_FAILED)
+      {
+        result = CANCOMM_FALSE;
+      }
+      else
+      {
+        /* Register the buffer ring as buffer group 0. */
+        uring->buf_ring = (struct io_uring_buf_ring *)uring->rx_map;
+        reg.ring_addr = (uint64_t)(uintptr_t)uring->buf_ring;
+        reg.ring_entries = CANCOMM_URING_RX_BUFS;
+        reg.bgid = 0;
+        if (syscall(__NR_io_uring_register, uring->fd, IORING_REGISTER_PBUF_RING, 
+                    &reg, 1) != 0)
+        {
+          result = CANCOMM_FALSE;
+        }
+      }
+    }
+
+    if (result == CANCOMM_TRUE)
+    {
+      /* Hand all receive buffers over to the kernel. */
+      for (uint32_t idx = 0; idx < CANCOMM_URING_RX_BUFS; idx++)
+      {
+        cancomm_uring_recycle(uring, (uint16_t)idx);
+      }
+      /* The multishot receive request stores the source address and the ancillary
+       * data in each buffer, in front of the frame. Keep the ancillary data aligned.
+       */
+      uring->rx_msg.msg_namelen = CMSG_ALIGN(sizeof(struct sockaddr_can));
+      uring->rx_msg.msg_controllen = CANCOMM_CMSG_BUF_SIZE;
+      /* Arm the multishot receive request. */
+      if ((cancomm_uring_arm(ctx) != CANCOMM_TRUE) ||
+          (cancomm_uring_submit(uring, 0) != CANCOMM_TRUE))
+      {
+        result = CANCOMM_FALSE;
+      }
+    }
+
+    /* Clean up in case of an error. */
+    if (result != CANCOMM_TRUE)
+    {
+      cancomm_uring_close(ctx);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_uring_open ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to release the resources of the io_uring backend. Closing
+**            the io_uring instance cancels all its outstanding requests.
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_uring_close(struct cancomm_ctx * ctx)
+{
+  struct cancomm_uring * uring;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if the backend is active. */
+  if ((ctx != NULL) && (ctx->uring != NULL))
+  {
+    uring = ctx->uring;
+    if (uring->fd >= 0)
+    {
+      close(uring->fd);
+    }
+    if (uring->sqes != MAP_FAILED)
+    {
+      (void)munmap(uring->sqes, uring->sqes_size);
+    }
+    if (uring->cq_map != MAP_FAILED)
+    {
+      (void)munmap(uring->cq_map, uring->cq_map_size);
+    }
+    if (uring->sq_map != MAP_FAILED)
+    {
+      (void)munmap(uring->sq_map, uring->sq_map_size);
+    }
+    if (uring->rx_map != MAP_FAILED)
+    {
+      (void)munmap(uring->rx_map, 
+                   (CANCOMM_URING_RX_BUFS * sizeof(struct io_uring_buf)) +
+                   (CANCOMM_URING_RX_BUFS * CANCOMM_URING_RX_BUF_SIZE));
+    }
+    (void)pthread_mutex_destroy(&uring->sq_lock);
+    free(uring);
+    ctx->uring = NULL;
+  }
+} /*** end of cancomm_uring_close ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to obtain a free submission queue entry of the io_uring
+**            backend. The entry is reset and gets submitted with the next call of
+**            cancomm_uring_submit().
+** \param     uring Pointer to the state of the io_uring backend.
+** \return    Pointer to the submission queue entry, or NULL if the queue is full.
+**
+****************************************************************************************/
+static struct io_uring_sqe * cancomm_uring_get_sqe(struct cancomm_uring * uring)
+{
+  struct io_uring_sqe * result = NULL;
+  uint32_t head;
+  uint32_t tail;
+
+  /* Verify parameter. */
+  assert(uring != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (uring != NULL)
+  {
+    /* This library is the only producer, so only the head needs a synchronized read. */
+    head = atomic_load_explicit((_Atomic uint32_t *)uring->sq_head, 
+                                memory_order_acquire);
+    tail = uring->sq_tail_local;
+    if ((tail - head) < uring->sq_entries)
+    {
+      result = &uring->sqes[tail & uring->sq_mask];
+      memset(result, 0, sizeof(struct io_uring_sqe));
+      uring->sq_array[tail & uring->sq_mask] = tail & uring->sq_mask;
+      uring->sq_tail_local = tail + 1U;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_uring_get_sqe ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to submit the queued submission queue entries of the
+**            io_uring backend to the kernel. Also runs the pending completion work of
+**            the kernel, such that new completions show up in the completion queue.
+** \param     uring Pointer to the state of the io_uring backend.
+** \param     flags IORING_ENTER_xxx flags for the system call.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_uring_submit(struct cancomm_uring * uring, uint32_t flags)
+{
+  uint8_t result = CANCOMM_FALSE;
+  uint32_t toSubmit;
+
+  /* Verify parameter. */
+  assert(uring != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (uring != NULL)
+  {
+    /* Publish the queued entries. The kernel only consumes them during the system
+     * call, so all entries between its head and the tail still need submitting.
+     */
+    atomic_store_explicit((_Atomic uint32_t *)uring->sq_tail, uring->sq_tail_local,
+                          memory_order_release);
+    toSubmit = uring->sq_tail_local - 
+               atomic_load_explicit((_Atomic uint32_t *)uring->sq_head, 
+                                    memory_order_acquire);
+    /* Hand them over to the kernel with one system call. */
+    if (syscall(__NR_io_uring_enter, uring->fd, toSubmit, 0, flags, NULL, 0) >= 0)
+    {
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_uring_submit ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to queue the multishot receive request of the io_uring
+**            backend. It stays armed and reports each received frame in a receive
+**            buffer, until the kernel runs out of receive buffers.
+** \param     ctx Non-opaque CAN communication context.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_uring_arm(struct cancomm_ctx * ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct io_uring_sqe * sqe;
+
+  /* Verify parameter. */
+  assert((ctx != NULL) && (ctx->uring != NULL));
+
+  /* Only continue with a valid parameter. */
+  if ((ctx != NULL) && (ctx->uring != NULL))
+  {
+    sqe = cancomm_uring_get_sqe(ctx->uring);
+    if (sqe != NULL)
+    {
+      sqe->opcode = IORING_OP_RECVMSG;
+      sqe->fd = (int32_t)ctx->socket;
+      sqe->addr = (uint64_t)(uintptr_t)&ctx->uring->rx_msg;
+      sqe->len = 1;
+      sqe->ioprio = IORING_RECV_MULTISHOT;
+      sqe->flags = IOSQE_BUFFER_SELECT;
+      sqe->buf_group = 0;
+      sqe->user_data = CANCOMM_URING_RX_TAG;
+      atomic_store_explicit(&ctx->uring->rx_armed, true, memory_order_relaxed);
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_uring_arm ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to give a receive buffer back to the kernel.
+** \param     uring Pointer to the state of the io_uring backend.
+** \param     bid Identifier of the receive buffer.
+**
+****************************************************************************************/
+static void cancomm_uring_recycle(struct cancomm_uring * uring, uint16_t bid)
+{
+  struct io_uring_buf * buf;
+
+  /* Verify parameter. */
+  assert(uring != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (uring != NULL)
+  {
+    /* Fill in the next entry of the buffer ring and then publish it. */
+    buf = &uring->buf_ring->bufs[uring->buf_tail & (CANCOMM_URING_RX_BUFS - 1U)];
+    buf->addr = (uint64_t)(uintptr_t)(uring->rx_map + 
+                (CANCOMM_URING_RX_BUFS * sizeof(struct io_uring_buf)) +
+                ((size_t)bid * CANCOMM_URING_RX_BUF_SIZE));
+    buf->len = CANCOMM_URING_RX_BUF_SIZE;
+    buf->bid = bid;
+    uring->buf_tail++;
+    atomic_store_explicit((_Atomic uint16_t *)&uring->buf_ring->tail, uring->buf_tail,
+                          memory_order_release);
+  }
+} /*** end of cancomm_uring_recycle ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to process all entries in the completion queue of the
+**            io_uring backend. Received frames are moved to the FIFO with pending
+**            receive buffers and completed transmissions move their slot to the FIFO
+**            with released transmit slots. Only one thread processes the completion
+**            queue at a time. If another thread is already at it, this function 
+**            returns right away.
+** \param     uring Pointer to the state of the io_uring backend.
+** \return    Number of processed completion queue entries.
+**
+****************************************************************************************/
+static uint32_t cancomm_uring_reap(struct cancomm_uring * uring)
+{
+  uint32_t result = 0;
+  struct io_uring_cqe const * cqe;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t rxTail;
+  uint32_t txTail;
+  uint8_t rxEnded = CANCOMM_FALSE;
+
+  /* Verify parameter. */
+  assert(uring != NULL);
+
+  /* Only continue with a valid parameter and if no other thread processes the queue. */
+  if ((uring != NULL) && 
+      (!atomic_exchange_explicit(&uring->cq_busy, true, memory_order_acquire)))
+  {
+    /* This library is the only consumer, so only the tail needs a synchronized read. */
+    head = *uring->cq_head;
+    tail = atomic_load_explicit((_Atomic uint32_t *)uring->cq_tail, 
+                                memory_order_acquire);
+    rxTail = atomic_load_explicit(&uring->rx_pending_tail, memory_order_relaxed);
+    txTail = atomic_load_explicit(&uring->tx_done_tail, memory_order_relaxed);
+    while (head != tail)
+    {
+      cqe = &uring->cqes[head & uring->cq_mask];
+      if (cqe->user_data == CANCOMM_URING_RX_TAG)
+      {
+        /* Store the buffer with the received frame. There is room for all buffers. */
+        if ((cqe->flags & IORING_CQE_F_BUFFER) != 0)
+        {
+          uring->rx_pending[rxTail & (CANCOMM_URING_RX_BUFS - 1U)] =
+            (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+          rxTail++;
+        }
+        /* The request ended, for example because no receive buffers were left. */
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0)
+        {
+          rxEnded = CANCOMM_TRUE;
+        }
+      }
+      else if (cqe->user_data < CANCOMM_URING_TX_SLOTS)
+      {
+        /* Count failed transmissions and release the slot. There is room for all
+         * slots.
+         */
+        if (cqe->res < 0)
+        {
+          cancomm_stats_add(&uring->tx_errors, 1);
+        }
+        uring->tx_done[txTail & (CANCOMM_URING_TX_SLOTS - 1U)] = (uint16_t)cqe->user_data;
+        txTail++;
+      }
+      head++;
+      result++;
+    }
+    /* Hand the received frames and the released slots over. Only then report that the
+     * receive request ended, such that it is not re-armed with frames still pending.
+     */
+    atomic_store_explicit(&uring->rx_pending_tail, rxTail, memory_order_release);
+    atomic_store_explicit(&uring->tx_done_tail, txTail, memory_order_release);
+    if (rxEnded == CANCOMM_TRUE)
+    {
+      atomic_store_explicit(&uring->rx_armed, false, memory_order_release);
+    }
+    /* Release the processed entries and let other threads process the queue again. */
+    atomic_store_explicit((_Atomic uint32_t *)uring->cq_head, head, 
+                          memory_order_release);
+    atomic_store_explicit(&uring->cq_busy, false, memory_order_release);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_uring_reap ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function that reads all possibly received frames of the io_uring
+**            backend, up to the specified maximum. Frames that are already in the
+**            completion queue are read without a system call.
+** \param     ctx Non-opaque CAN communication context.
+** \param     frames Pointer to the array where the received frames are stored.
+** \param     max Maximum number of frames that fit in the array.
+** \return    Number of frames stored in the array.
+**
+****************************************************************************************/
+static size_t cancomm_uring_receive(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                    size_t max)
+{
+  size_t count = 0;
+  struct cancomm_uring * uring;
+  struct io_uring_recvmsg_out const * out;
+  struct sockaddr_can addr;
+  struct canfd_frame canRxFrame;
+  struct msghdr msg = { 0 };
+  uint8_t * buf;
+  uint16_t bid;
+  int64_t clockOffset;
+  size_t dropped = 0;
+  uint32_t rxTail;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (ctx->uring != NULL) && (frames != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (ctx->uring != NULL) && (frames != NULL))
+  {
+    uring = ctx->uring;
+    /* Collect the completions. If there are none, enter the kernel once, to run its
+     * pending completion work. Without submitting anything, as the submission queue
+     * belongs to the transmitting threads.
+     */
+    if ((cancomm_uring_reap(uring) == 0) && 
+        (uring->rx_pending_head == 
+         atomic_load_explicit(&uring->rx_pending_tail, memory_order_acquire)))
+    {
+      (void)syscall(__NR_io_uring_enter, uring->fd, 0, 0, IORING_ENTER_GETEVENTS, 
+                    NULL, 0);
+      (void)cancomm_uring_reap(uring);
+    }
+    clockOffset = cancomm_clock_offset(ctx);
+    /* Convert the frames in the pending receive buffers. */
+    rxTail = atomic_load_explicit(&uring->rx_pending_tail, memory_order_acquire);
+    while ((count < max) && (uring->rx_pending_head != rxTail))
+    {
+      bid = uring->rx_pending[uring->rx_pending_head & (CANCOMM_URING_RX_BUFS - 1U)];
+      uring->rx_pending_head++;
+      /* The buffer holds the receive header, followed by the areas for the source
+       * address and the ancillary data, as sized in the message header template, and
+       * finally the frame itself.
+       */
+      buf = uring->rx_map + (CANCOMM_URING_RX_BUFS * sizeof(struct io_uring_buf)) +
+            ((size_t)bid * CANCOMM_URING_RX_BUF_SIZE);
+      out = (struct io_uring_recvmsg_out const *)buf;
+      memset(&addr, 0, sizeof(addr));
+      memcpy(&addr, buf + sizeof(*out), 
+             (out->namelen < sizeof(addr)) ? out->namelen : sizeof(addr));
+      msg.msg_control = buf + sizeof(*out) + uring->rx_msg.msg_namelen;
+      msg.msg_controllen = out->controllen;
+      if ((out->payloadlen > sizeof(canRxFrame)) || ((out->flags & MSG_TRUNC) != 0))
+      {
+        dropped++;
+      }
+      else
+      {
+        memcpy(&canRxFrame, (uint8_t const *)msg.msg_control + 
+               uring->rx_msg.msg_controllen, out->payloadlen);
+        /* Convert the frame. This also filters out invalid and remote frames. */
+        if (cancomm_inline_frame_unpack(&canRxFrame, out->payloadlen, 
+                                        &frames[count]) != CANCOMM_TRUE)
+        {
+          dropped++;
+        }
+        else if (cancomm_ifindex_accepted(ctx, (uint32_t)addr.can_ifindex) 
+                 == CANCOMM_TRUE)
+        {
+          frames[count].ifindex = (uint32_t)addr.can_ifindex;
+          frames[count].timestamp = cancomm_timestamp_from_cmsg(ctx, &msg, clockOffset);
+          count++;
+        }
+      }
+      /* Give the buffer back to the kernel. */
+      cancomm_uring_recycle(uring, bid);
+    }
+    /* Account the received frames, once per call. */
+    if ((count + dropped) == 0)
+    {
+      cancomm_stats_add(&ctx->stats.rx_empty, 1);
+    }
+    cancomm_stats_add(&ctx->stats.rx_frames, count);
+    cancomm_stats_add(&ctx->stats.rx_dropped, dropped);
+    /* Re-arm the receive request, if it ended. Once all buffers are back with the
+     * kernel, such that it does not end right away again. This is the only time that
+     * the receive path needs the submission queue.
+     */
+    if ((!atomic_load_explicit(&uring->rx_armed, memory_order_acquire)) && 
+        (uring->rx_pending_head == 
+         atomic_load_explicit(&uring->rx_pending_tail, memory_order_acquire)))
+    {
+      (void)pthread_mutex_lock(&uring->sq_lock);
+      if (cancomm_uring_arm(ctx) == CANCOMM_TRUE)
+      {
+        (void)cancomm_uring_submit(uring, 0);
+      }
+      (void)pthread_mutex_unlock(&uring->sq_lock);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return count;
+} /*** end of cancomm_uring_receive ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to queue frames for asynchronous transmission with the
+**            io_uring backend. The frames are copied to transmit slots and submitted to
+**            the kernel with a single system call. The function does not wait for the
+**            transmissions to complete.
+** \param     ctx Non-opaque CAN communication context.
+** \param     msgs Pointer to the array with message headers of the frames, as they
+**            would be passed to sendmmsg().
+** \param     count Number of message headers in the array.
+** \return    Number of frames that were submitted for transmission.
+**
+****************************************************************************************/
+static size_t cancomm_uring_transmit(struct cancomm_ctx * ctx, 
+                                     struct mmsghdr const * msgs, size_t count)
+{
+  size_t result = 0;
+  struct cancomm_uring * uring;
+  struct cancomm_uring_tx * slot;
+  struct io_uring_sqe * sqe;
+  struct msghdr const * hdr;
+  uint16_t slotIdx;
+  uint32_t txTail;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (ctx->uring != NULL) && (msgs != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (ctx->uring != NULL) && (msgs != NULL))
+  {
+    uring = ctx->uring;
+    (void)pthread_mutex_lock(&uring->sq_lock);
+    /* Take back the slots of completed transmissions, if running short on them. Also
+     * process the completion queue, in case no thread receives.
+     */
+    if (uring->tx_free_cnt < count)
+    {
+      (void)cancomm_uring_reap(uring);
+      txTail = atomic_load_explicit(&uring->tx_done_tail, memory_order_acquire);
+      while (uring->tx_done_head != txTail)
+      {
+        uring->tx_free[uring->tx_free_cnt] = 
+          uring->tx_done[uring->tx_done_head & (CANCOMM_URING_TX_SLOTS - 1U)];
+        uring->tx_free_cnt++;
+        uring->tx_done_head++;
+      }
+    }
+    while ((result < count) && (uring->tx_free_cnt > 0))
+    {
+      sqe = cancomm_uring_get_sqe(uring);
+      if (sqe == NULL)
+      {
+        break;
+      }
+      /* Copy the frame and its destination into a free slot. */
+      uring->tx_free_cnt--;
+      slotIdx = uring->tx_free[uring->tx_free_cnt];
+      slot = &uring->tx[slotIdx];
+      hdr = &msgs[result].msg_hdr;
+      memcpy(&slot->frame, hdr->msg_iov[0].iov_base, hdr->msg_iov[0].iov_len);
+      memset(&slot->msg, 0, sizeof(slot->msg));
+      slot->iov.iov_base = &slot->frame;
+      slot->iov.iov_len = hdr->msg_iov[0].iov_len;
+      slot->msg.msg_iov = &slot->iov;
+      slot->msg.msg_iovlen = 1;
+      if (hdr->msg_name != NULL)
+      {
+        memcpy(&slot->addr, hdr->msg_name, sizeof(slot->addr));
+        slot->msg.msg_name = &slot->addr;
+        slot->msg.msg_namelen = sizeof(slot->addr);
+      }
+      /* Queue the send request. */
+      sqe->opcode = IORING_OP_SENDMSG;
+      sqe->fd = (int32_t)ctx->socket;
+      sqe->addr = (uint64_t)(uintptr_t)&slot->msg;
+      sqe->len = 1;
+      sqe->user_data = slotIdx;
+      result++;
+    }
+    /* Submit all queued requests at once. Should the kernel not take them right
+     * now, they go along with the next submission.
+     */
+    if (result > 0)
+    {
+      (void)cancomm_uring_submit(uring, 0);
+    }
+    (void)pthread_mutex_unlock(&uring->sq_lock);
+    /* Out of transmit slots or submission queue entries. Report it in the same way as
+     * a full socket.
+     */
+    if (result < count)
+    {
+      errno = EAGAIN;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_uring_transmit ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to open the broadcast manager (CAN_BCM) socket of the
+**            context, if not yet open. The socket connects to the same CAN device(s) as
+**            the CAN raw socket. Each operation selects its CAN device with its own 
+**            destination address.
+** \param     ctx Non-opaque CAN communication context.
+** \return    CANCOMM_TRUE if the socket is open, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_bcm_open(struct cancomm_ctx * ctx)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct sockaddr_can addr = { 0 };
+  int enable = 1;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    /* Already open? */
+    if (ctx->bcm_fd >= 0)
+    {
+      result = CANCOMM_TRUE;
+    }
+    else
+    {
+      ctx->bcm_fd = socket(PF_CAN, SOCK_DGRAM | SOCK_NONBLOCK, CAN_BCM);
+      if (ctx->bcm_fd >= 0)
+      {
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = (int)ctx->ifindex;
+        if (connect(ctx->bcm_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+        {
+          /* Timestamps for the reports of the subscriptions. Not critical, so errors
+           * are ignored.
+           */
+          (void)setsockopt(ctx->bcm_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, 
+                           sizeof(enable));
+          result = CANCOMM_TRUE;
+        }
+        else
+        {
+          close(ctx->bcm_fd);
+          ctx->bcm_fd = -1;
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_bcm_open ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to close the broadcast manager (CAN_BCM) socket of the
+**            context. This also ends all of its cyclic transmission jobs and
+**            subscriptions.
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_bcm_close(struct cancomm_ctx * ctx)
+{
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if the socket is open. */
+  if ((ctx != NULL) && (ctx->bcm_fd >= 0))
+  {
+    close(ctx->bcm_fd);
+    ctx->bcm_fd = -1;
+  }
+} /*** end of cancomm_bcm_close ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to determine the CAN device that a broadcast manager
+**            transmission job runs on.
+** \param     ctx Non-opaque CAN communication context.
+** \param     frame Pointer to the CAN message of the job.
+** \return    Interface index of the CAN device. Zero if there is none.
+**
+****************************************************************************************/
+static uint32_t cancomm_bcm_tx_ifindex(struct cancomm_ctx const * ctx, 
+                                       cancomm_frame_t const * frame)
+{
+  uint32_t result = 0;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frame != NULL))
+  {
+    result = (frame->ifindex != 0) ? frame->ifindex : ctx->tx_ifindex;
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_bcm_tx_ifindex ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to pass an operation with one frame to the broadcast
+**            manager (CAN_BCM).
+** \param     ctx Non-opaque CAN communication context.
+** \param     opcode Operation code (TX_SETUP, RX_SETUP, etc.).
+** \param     flags Operation flags (SETTIMER, STARTTIMER, etc.). CAN_FD_FRAME is added
+**            automatically for CAN FD frames.
+** \param     count Number of transmissions with the first interval.
+** \param     ival1_us First interval in microseconds.
+** \param     ival2_us Second interval in microseconds.
+** \param     frame Pointer to the frame of the operation.
+** \param     ifindex Interface index of the CAN device for the operation. Zero for all 
+**            devices, which only the reception operations allow.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_bcm_send(struct cancomm_ctx * ctx, uint32_t opcode, 
+                                uint32_t flags, uint32_t count, uint32_t ival1_us, 
+                                uint32_t ival2_us, cancomm_frame_t const * frame,
+                                uint32_t ifindex)
+{
+  uint8_t result = CANCOMM_FALSE;
+  union
+  {
+    struct bcm_msg_head head;
+    uint8_t             buf[sizeof(struct bcm_msg_head) + sizeof(struct canfd_frame)];
+  } msg;
+  struct canfd_frame raw;
+  struct sockaddr_can addr = { 0 };
+  size_t frameSize;
+  size_t msgSize;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters and if the broadcast manager is available. */
+  if ((ctx != NULL) && (frame != NULL) && (cancomm_bcm_open(ctx) == CANCOMM_TRUE))
+  {
+    /* Construct the frame. Deletions just need the identifier, not the data. */
+    if (cancomm_frame_pack(ctx, frame->id, frame->ext, 
+                           ((opcode == TX_DELETE) || (opcode == RX_DELETE)) ? 0 : 
+                           frame->len, frame->data, frame->flags, &raw, 
+                           &frameSize) == CANCOMM_TRUE)
+    {
+      /* Construct the operation. The frame follows right after the header. A CAN
+       * classic frame is layout compatible with the start of a CAN FD frame.
+       */
+      memset(&msg, 0, sizeof(msg));
+      msg.head.opcode = opcode;
+      msg.head.flags = flags;
+      if (frameSize == CANFD_MTU)
+      {
+        msg.head.flags |= CAN_FD_FRAME;
+      }
+      msg.head.count = count;
+      msg.head.ival1.tv_sec = (long)(ival1_us / 1000000U);
+      msg.head.ival1.tv_usec = (long)(ival1_us % 1000000U);
+      msg.head.ival2.tv_sec = (long)(ival2_us / 1000000U);
+      msg.head.ival2.tv_usec = (long)(ival2_us % 1000000U);
+      msg.head.can_id = raw.can_id;
+      msg.head.nframes = 1;
+      memcpy(&msg.buf[sizeof(struct bcm_msg_head)], &raw, frameSize);
+      msgSize = sizeof(struct bcm_msg_head) + frameSize;
+      /* Hand the operation over to the broadcast manager. */
+      addr.can_family = AF_CAN;
+      addr.can_ifindex = (int)ifindex;
+      if (sendto(ctx->bcm_fd, &msg, msgSize, 0, (struct sockaddr *)&addr, 
+                 sizeof(addr)) == (ssize_t)msgSize)
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_bcm_send ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to open the transaction socket of the context on the
+**            specified CAN device, if not yet open on it. The transaction socket is a
+**            separate CAN raw socket, such that the acceptance filter for the response
+**            does not affect the regular reception.
+** \param     ctx Non-opaque CAN communication context.
+** \param     ifindex Interface index of the CAN device.
+** \return    CANCOMM_TRUE if the socket is open, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_txn_open(struct cancomm_ctx * ctx, uint32_t ifindex)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct sockaddr_can addr = { 0 };
+  int enable = 1;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    /* Already open on this device? */
+    if ((ctx->txn_fd >= 0) && (ctx->txn_ifindex == ifindex))
+    {
+      result = CANCOMM_TRUE;
+    }
+    else
+    {
+      cancomm_txn_close(ctx);
+      ctx->txn_fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+      if (ctx->txn_fd >= 0)
+      {
+        /* Same frame type support as the CAN raw socket. The timestamps are not
+         * critical, so errors are ignored for those.
+         */
+        if (ctx->fd_enabled == CANCOMM_TRUE)
+        {
+          (void)setsockopt(ctx->txn_fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, 
+                           sizeof(enable));
+        }
+        (void)setsockopt(ctx->txn_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, 
+                         sizeof(enable));
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = (int)ifindex;
+        if (bind(ctx->txn_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+        {
+          ctx->txn_ifindex = ifindex;
+          result = CANCOMM_TRUE;
+        }
+        else
+        {
+          cancomm_txn_close(ctx);
+        }
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_txn_open ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to close the transaction socket of the context.
+** \param     ctx Non-opaque CAN communication context.
+**
+****************************************************************************************/
+static void cancomm_txn_close(struct cancomm_ctx * ctx)
+{
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if the socket is open. */
+  if ((ctx != NULL) && (ctx->txn_fd >= 0))
+  {
+    close(ctx->txn_fd);
+    ctx->txn_fd = -1;
+    ctx->txn_ifindex = 0;
+  }
+} /*** end of cancomm_txn_close ***/
+
+
+/************************************************************************************//**
+** \brief     Thread function of the background reader. Sleeps until frames arrive, then
+**            drains them in batches directly into the free slots of the ring buffer.
+** \param     arg Non-opaque CAN communication context.
+** \return    Always NULL.
+**
+****************************************************************************************/
+static void * cancomm_reader_thread(void * arg)
+{
+  struct cancomm_ctx * ctx = (struct cancomm_ctx *)arg;
+  struct cancomm_ring * ring;
+  struct pollfd pfds[2];
+  cancomm_frame_t discard[CANCOMM_BATCH_CHUNK_SIZE];
+  size_t head;
+  size_t space;
+  size_t contiguous;
+  size_t count;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    ring = ctx->ring;
+    /* Wait for frames on the socket and for the stop request on the event fd. */
+    pfds[0].fd = cancomm_rx_fd(ctx);
+    pfds[0].events = POLLIN;
+    pfds[1].fd = ctx->reader_wakefd;
+    pfds[1].events = POLLIN;
+
+    while (!atomic_load_explicit(&ring->stop, memory_order_relaxed))
+    {
+      /* Sleep in the kernel until frames arrive or a stop is requested. */
+      if (poll(pfds, 2, -1) < 0)
+      {
+        /* Just try again when interrupted by a signal. */
+        continue;
+      }
+      if ((pfds[1].revents != 0) || ((pfds[0].revents & (POLLERR | POLLHUP)) != 0))
+      {
+        break;
+      }
+      /* Drain the socket, until it reports no more frames. */
+      do
+      {
+        /* Determine the number of free slots. Only look at the consumer's index, if
+         * the cached copy of it says the ring is full.
+         */
+        head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        space = (ring->mask + 1U) - (head - ring->tail_cached);
+        if (space == 0)
+        {
+          ring->tail_cached = atomic_load_explicit(&ring->tail, memory_order_acquire);
+          space = (ring->mask + 1U) - (head - ring->tail_cached);
+        }
+        if (space > 0)
+        {
+          /* Receive directly into the free slots, up to the end of the array. */
+          contiguous = (ring->mask + 1U) - (head & ring->mask);
+          if (contiguous > space)
+          {
+            contiguous = space;
+          }
+          (void)cancomm_receive_batch(ctx, &ring->slots[head & ring->mask], contiguous,
+                                      &count);
+          /* Publish the new frames to the consumer. */
+          atomic_store_explicit(&ring->head, head + count, memory_order_release);
+        }
+        else
+        {
+          /* The ring is full. Still drain the socket, to not fall behind on the bus,
+           * but count the frames as dropped.
+           */
+          (void)cancomm_receive_batch(ctx, discard, CANCOMM_BATCH_CHUNK_SIZE, &count);
+          atomic_fetch_add_explicit(&ring->drops, count, memory_order_relaxed);
+          /* Continue with a fresh look at the consumer's index. */
+          ring->tail_cached = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        }
+      }
+      while ((count > 0) && (!atomic_load_explicit(&ring->stop, memory_order_relaxed)));
+    }
+  }
+
+  /* Nothing to give back. */
+  return NULL;
+} /*** end of cancomm_reader_thread ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to instruct the kernel to pass the reception timestamp
+**            along with each received frame as ancillary data, according to the
+**            configured timestamp mode. Not critical, so errors are ignored. Without
+**            timestamping support the timestamps are just zero.
+** \param     ctx Non-opaque CAN communication context.
+** \param     devices Pointer to an array with null terminated SocketCAN device names.
+**            NULL when connected to all SocketCAN devices.
+** \param     count Number of device names in the array.
+**
+****************************************************************************************/
+static void cancomm_timestamping_enable(struct cancomm_ctx const * ctx, 
+                                        char const * const * devices, size_t count)
+{
+  int enable = 1;
+  int tsFlags;
+  uint8_t hwEnabled = CANCOMM_FALSE;
+  struct ifreq ifr;
+  struct hwtstamp_config hwConfig = { 0 };
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && ((devices != NULL) || (count == 0)));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && ((devices != NULL) || (count == 0)))
+  {
+    /* Are hardware timestamps requested? */
+    if (ctx->opt_timestamp == CANCOMM_TIMESTAMP_HW_NS)
+    {
+      /* Attempt to enable hardware timestamping of received frames in the CAN devices.
+       * Many CAN drivers have this always on. Others need this request, which requires
+       * the CAP_NET_ADMIN capability.
+       */
+      for (size_t idx = 0; idx < count; idx++)
+      {
+        strncpy(ifr.ifr_name, devices[idx], IFNAMSIZ - 1);
+        ifr.ifr_name[IFNAMSIZ - 1] = '\0';
+        hwConfig.tx_type = HWTSTAMP_TX_OFF;
+        hwConfig.rx_filter = HWTSTAMP_FILTER_ALL;
+        ifr.ifr_data = (void *)&hwConfig;
+        (void)ioctl(ctx->socket, SIOCSHWTSTAMP, &ifr);
+      }
+      /* Request both the hardware and the software timestamp. The software timestamp
+       * serves as a fallback for frames without a hardware timestamp.
+       */
+      tsFlags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+      if (setsockopt(ctx->socket, SOL_SOCKET, SO_TIMESTAMPING, &tsFlags, 
+                     sizeof(tsFlags)) == 0)
+      {
+        hwEnabled = CANCOMM_TRUE;
+      }
+    }
+    /* Request software timestamps with nanosecond resolution, unless hardware 
+     * timestamping is already active.
+     */
+    if (hwEnabled == CANCOMM_FALSE)
+    {
+      (void)setsockopt(ctx->socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    }
+  }
+} /*** end of cancomm_timestamping_enable ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to convert a system time to a timestamp relative to the
+**            time that the context connected to the CAN device, in the unit of the
+**            configured timestamp mode.
+** \param     ctx Non-opaque CAN communication context.
+** \param     systemTime System time in nanoseconds.
+** \return    The timestamp in microseconds or nanoseconds.
+**
+****************************************************************************************/
+static uint64_t cancomm_timestamp_convert(struct cancomm_ctx const * ctx, 
+                                          uint64_t systemTime)
+{
+  uint64_t result = 0;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (ctx != NULL)
+  {
+    /* Make the timestamp relative to the connection time. */
+    result = systemTime - ctx->connectTime;
+    /* Convert to microseconds, unless nanoseconds were requested. */
+    if (ctx->opt_timestamp == CANCOMM_TIMESTAMP_SW_US)
+    {
+      result /= 1000U;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_timestamp_convert ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to extract the reception timestamp from the ancillary data
+**            that the kernel passed along with a received frame. Also accounts the
+**            frames that the kernel dropped, if the ancillary data reports these.
+** \param     ctx Non-opaque CAN communication context.
+** \param     msg Pointer to the message header of the received frame.
+** \param     clockOffset Offset in nanoseconds of the configured clock with respect to
+**            the system time, as obtained with cancomm_clock_offset(). The kernel's
+**            software timestamps are always based on the system time.
+** \return    The timestamp in the unit of the configured timestamp mode. Zero if the
+**            ancillary data did not contain a timestamp.
+**
+****************************************************************************************/
+static uint64_t cancomm_timestamp_from_cmsg(struct cancomm_ctx * ctx,
+                                            struct msghdr const * msg,
+                                            int64_t clockOffset)
+{
+  uint64_t result = 0;
+  struct cmsghdr * cmsg;
+  struct timespec ts[3];
+  uint32_t drops;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (msg != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (msg != NULL))
+  {
+    /* Loop through the control messages in search of the timestamp and the drops. */
+    for (cmsg = CMSG_FIRSTHDR((struct msghdr *)msg); cmsg != NULL; 
+         cmsg = CMSG_NXTHDR((struct msghdr *)msg, cmsg))
+    {
+      if (cmsg->cmsg_level != SOL_SOCKET)
+      {
+        continue;
+      }
+      /* Software timestamp with nanosecond resolution. Copy instead of casting, 
+       * because the data is not guaranteed to be aligned.
+       */
+      if (cmsg->cmsg_type == SCM_TIMESTAMPNS)
+      {
+        memcpy(&ts[0], CMSG_DATA(cmsg), sizeof(ts[0]));
+        result = cancomm_timestamp_convert(ctx, ((uint64_t)ts[0].tv_sec * 1000000000ULL)
+                                                + (uint64_t)ts[0].tv_nsec 
+                                                + (uint64_t)clockOffset);
+      }
+      /* Timestamping info. Element 0 holds the software and element 2 the raw 
+       * hardware timestamp.
+       */
+      else if (cmsg->cmsg_type == SCM_TIMESTAMPING)
+      {
+        memcpy(&ts[0], CMSG_DATA(cmsg), sizeof(ts));
+        if ((ts[2].tv_sec != 0) || (ts[2].tv_nsec != 0))
+        {
+          /* The hardware clock has its own time base, unrelated to the system time.
+           * Report it as is.
+           */
+          result = ((uint64_t)ts[2].tv_sec * 1000000000ULL) + (uint64_t)ts[2].tv_nsec;
+        }
+        else
+        {
+          result = cancomm_timestamp_convert(ctx, 
+                                             ((uint64_t)ts[0].tv_sec * 1000000000ULL) +
+                                             (uint64_t)ts[0].tv_nsec + 
+                                             (uint64_t)clockOffset);
+        }
+      }
+      /* Running total of the frames that the kernel dropped, because the socket's 
+       * receive queue was full. Only present once it dropped frames.
+       */
+      if (cmsg->cmsg_type == SO_RXQ_OVFL)
+      {
+        memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+        cancomm_stats_add(&ctx->stats.rx_overflows, (uint32_t)(drops - ctx->rxq_drops));
+        ctx->rxq_drops = drops;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_timestamp_from_cmsg ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to obtain the current time of the configured clock as a
+**            timestamp relative to the time that the context connected to the CAN device.
+** \param     ctx Non-opaque CAN communication context.
+** \return    The timestamp in the unit of the configured timestamp mode, or zero if the
+**            system time could not be obtained.
+**
+****************************************************************************************/
+static uint64_t cancomm_timestamp_now(struct cancomm_ctx const * ctx)
+{
+  uint64_t result = 0;
+  uint64_t now;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if the time could be obtained. */
+  if ((ctx != NULL) && (cancomm_clock_read(ctx, &now) == CANCOMM_TRUE))
+  {
+    result = cancomm_timestamp_convert(ctx, now);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_timestamp_now ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to read the current time of the configured clock. Uses
+**            clock_gettime(), which the vDSO serves without entering the kernel.
+** \param     ctx Non-opaque CAN communication context.
+** \param     now Pointer to where the current time in nanoseconds is stored.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_clock_read(struct cancomm_ctx const * ctx, uint64_t * now)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct timespec ts;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (now != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (now != NULL))
+  {
+    if (clock_gettime(ctx->opt_clock, &ts) == 0)
+    {
+      *now = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_clock_read ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to determine the current offset of the configured clock
+**            with respect to the system time. Needed to convert the kernel's software
+**            reception timestamps, which are always based on the system time.
+** \param     ctx Non-opaque CAN communication context.
+** \return    Offset in nanoseconds to add to a system time to arrive at the time of the
+**            configured clock. Zero if the configured clock is the system time.
+**
+****************************************************************************************/
+static int64_t cancomm_clock_offset(struct cancomm_ctx const * ctx)
+{
+  int64_t result = 0;
+  struct timespec tsReal;
+  struct timespec tsClock;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and if a clock other than the system time is
+   * configured.
+   */
+  if ((ctx != NULL) && (ctx->opt_clock != CLOCK_REALTIME))
+  {
+    if ((clock_gettime(CLOCK_REALTIME, &tsReal) == 0) &&
+        (clock_gettime(ctx->opt_clock, &tsClock) == 0))
+    {
+      result = (((int64_t)tsClock.tv_sec - (int64_t)tsReal.tv_sec) * 1000000000LL) +
+               ((int64_t)tsClock.tv_nsec - (int64_t)tsReal.tv_nsec);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_clock_offset ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to determine the absolute point in time, based on the
+**            monotonic system clock, that lies the specified number of microseconds in
+**            the future.
+** \param     deadline Pointer to where the absolute point in time is stored.
+** \param     timeout_us Number of microseconds from now.
+**
+****************************************************************************************/
+static void cancomm_deadline_init(struct timespec * deadline, uint32_t timeout_us)
+{
+  /* Verify parameter. */
+  assert(deadline != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (deadline != NULL)
+  {
+    /* Obtain the current time of the monotonic clock. This clock is not affected by
+     * changes to the system time, making it the right one for timeouts.
+     */
+    (void)clock_gettime(CLOCK_MONOTONIC, deadline);
+    /* Add the timeout. */
+    deadline->tv_sec += timeout_us / 1000000UL;
+    deadline->tv_nsec += (long)(timeout_us % 1000000UL) * 1000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+      deadline->tv_sec++;
+      deadline->tv_nsec -= 1000000000L;
+    }
+  }
+} /*** end of cancomm_deadline_init ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to obtain the current time of the monotonic system clock,
+**            for measuring intervals that are not affected by changes to the system
+**            time.
+** \return    Time of CLOCK_MONOTONIC in nanoseconds.
+**
+****************************************************************************************/
+static uint64_t cancomm_monotonic_ns(void)
+{
+  struct timespec now = { 0 };
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+} /*** end of cancomm_monotonic_ns ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to sleep until the socket of the context reports one of the
+**            specified events, or until the deadline passed. cancomm_shutdown() ends the
+**            wait early.
+** \param     ctx Non-opaque CAN communication context.
+** \param     events Bit mask with the poll events to wait for, e.g. POLLIN or POLLOUT.
+** \param     deadline Absolute point in time of the monotonic clock at which to stop
+**            waiting. NULL to wait without a timeout.
+** \return    CANCOMM_TRUE if one of the events occurred. CANCOMM_FALSE upon timeout,
+**            signal interruption, error or shutdown.
+**
+****************************************************************************************/
+static uint8_t cancomm_wait_event(struct cancomm_ctx const * ctx, short events,
+                                  struct timespec const * deadline)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    /* Frames are received on the socket of the receive backend. */
+    result = cancomm_wait_fd(((events & POLLIN) != 0) ? cancomm_rx_fd(ctx) : ctx->socket,
+                             ctx->shutdown_fd, events, deadline);
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_wait_event ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to sleep until a file descriptor reports one of the
+**            specified events, or until the deadline passed. An optional wake file
+**            descriptor ends the wait early, once it becomes readable.
+** \param     fd The file descriptor.
+** \param     wakeFd Event file descriptor that ends the wait when readable, such as the
+**            one of cancomm_shutdown(). -1 if not used.
+** \param     events Bit mask with the poll events to wait for, e.g. POLLIN or POLLOUT.
+** \param     deadline Absolute point in time of the monotonic clock at which to stop
+**            waiting. NULL to wait without a timeout.
+** \return    CANCOMM_TRUE if one of the events occurred. CANCOMM_FALSE upon timeout,
+**            signal interruption, error or when the wake file descriptor is readable.
+**
+****************************************************************************************/
+static uint8_t cancomm_wait_fd(int fd, int wakeFd, short events, 
+                               struct timespec const * deadline)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct pollfd pfds[2];
+  struct timespec now;
+  struct timespec remaining;
+  struct timespec const * remainingPtr = NULL;
+
+  /* Verify parameter. */
+  assert(fd >= 0);
+
+  /* Only continue with a valid parameter. */
+  if (fd >= 0)
+  {
+    /* Convert the absolute deadline to the relative timeout needed by ppoll(). */
+    if (deadline != NULL)
+    {
+      (void)clock_gettime(CLOCK_MONOTONIC, &now);
+      remaining.tv_sec = deadline->tv_sec - now.tv_sec;
+      remaining.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+      if (remaining.tv_nsec < 0)
+      {
+        remaining.tv_sec--;
+        remaining.tv_nsec += 1000000000L;
+      }
+      /* Deadline already passed? Still poll once, but without waiting. */
+      if (remaining.tv_sec < 0)
+      {
+        remaining.tv_sec = 0;
+        remaining.tv_nsec = 0;
+      }
+      remainingPtr = &remaining;
+    }
+
+    /* Sleep in the kernel until the event occurs or the timeout expires. The kernel
+     * ignores the wake file descriptor, if it is negative.
+     */
+    pfds[0].fd = fd;
+    pfds[0].events = events;
+    pfds[0].revents = 0;
+    pfds[1].fd = wakeFd;
+    pfds[1].events = POLLIN;
+    pfds[1].revents = 0;
+    if (ppoll(pfds, 2, remainingPtr, NULL) > 0)
+    {
+      /* Only report success if one of the requested events occurred and the wait was
+       * not woken up. A POLLERR or POLLHUP alone does not count, yet the caller's next
+       * I/O call will see it.
+       */
+      if (((pfds[0].revents & events) != 0) && (pfds[1].revents == 0))
+      {
+        result = CANCOMM_TRUE;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_wait_fd ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to wait for space in the transmit queue, right after a
+**            transmit attempt failed with a full queue. A full socket send buffer or
+**            io_uring submission queue signals once space is available. A full queue of
+**            the CAN device (ENOBUFS) does not signal, so that one needs a short pause
+**            instead. cancomm_shutdown() ends the wait early.
+** \param     ctx Non-opaque CAN communication context.
+** \param     deadline Absolute point in time of the monotonic clock at which to stop
+**            waiting. NULL to wait without a timeout.
+** \return    CANCOMM_TRUE if the transmit attempt should be retried. CANCOMM_FALSE upon
+**            timeout, signal interruption, error or shutdown.
+**
+****************************************************************************************/
+static uint8_t cancomm_tx_space_wait(struct cancomm_ctx const * ctx, 
+                                     struct timespec const * deadline)
+{
+  uint8_t result = CANCOMM_FALSE;
+  int txErrno = errno;
+  uint64_t wake;
+  uint64_t limit;
+  struct timespec wakeTime;
+
+  /* Verify parameter. */
+  assert(ctx != NULL);
+
+  /* Only continue with a valid parameter and when connected. */
+  if ((ctx != NULL) && (ctx->socket != CANCOMM_INVALID_SOCKET))
+  {
+    if (txErrno == ENOBUFS)
+    {
+      /* Pause, but not past the deadline. Only the shutdown event ends it early. */
+      wake = cancomm_monotonic_ns() + CANCOMM_TX_BACKOFF_NS;
+      limit = wake;
+      if (deadline != NULL)
+      {
+        limit = ((uint64_t)deadline->tv_sec * 1000000000ULL) + 
+                (uint64_t)deadline->tv_nsec;
+      }
+      if (limit >= wake)
+      {
+        wakeTime.tv_sec = (time_t)(wake / 1000000000ULL);
+        wakeTime.tv_nsec = (long)(wake % 1000000000ULL);
+        if ((cancomm_wait_fd(ctx->shutdown_fd, -1, POLLIN, &wakeTime) != CANCOMM_TRUE) &&
+            (errno != EINTR))
+        {
+          result = CANCOMM_TRUE;
+        }
+      }
+      else
+      {
+        /* The deadline ends the pause. */
+        (void)cancomm_wait_fd(ctx->shutdown_fd, -1, POLLIN, deadline);
+      }
+    }
+    /* The io_uring backend frees its transmit slots upon completion events. */
+    else if (ctx->uring != NULL)
+    {
+      result = cancomm_wait_fd(ctx->uring->fd, ctx->shutdown_fd, POLLIN, deadline);
+    }
+    else
+    {
+      result = cancomm_wait_event(ctx, POLLOUT, deadline);
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_tx_space_wait ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to create the recording file that belongs to the current
+**            sequence number of the recorder. The file is allocated with its full size,
+**            such that the file system reserves the space upfront and a full storage
+**            medium gets detected now instead of upon a write to the memory mapping.
+** \param     recorder Non-opaque recorder.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_recorder_file_open(struct cancomm_recorder * recorder)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct cancomm_record_header * header;
+  size_t nameSize;
+  char * name;
+  void * map;
+  size_t mapSize;
+  int fd = -1;
+
+  /* Verify parameter. */
+  assert(recorder != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (recorder != NULL)
+  {
+    mapSize = CANCOMM_RECORD_HEADER_SIZE + 
+              ((size_t)recorder->records_max * sizeof(struct cancomm_record));
+    /* Construct the name of the file from the base path and the index of the file. */
+    nameSize = strlen(recorder->path) + 12U;
+    name = malloc(nameSize);
+    if (name != NULL)
+    {
+      (void)snprintf(name, nameSize, "%s.%u", recorder->path, 
+                     (uint32_t)(recorder->sequence % recorder->file_count));
+      fd = open(name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      free(name);
+    }
+    if (fd >= 0)
+    {
+      /* Reserve the space. Fall back to a sparse file if the file system cannot. */
+      if ((fallocate(fd, 0, 0, (off_t)mapSize) == 0) || 
+          ((errno == EOPNOTSUPP) && (ftruncate(fd, (off_t)mapSize) == 0)))
+      {
+        map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED)
+        {
+          (void)madvise(map, mapSize, MADV_SEQUENTIAL);
+          /* Initialize the header. The rest of the new file already reads as zero. */
+          header = (struct cancomm_record_header *)map;
+          memcpy(header->magic, CANCOMM_RECORD_MAGIC, sizeof(header->magic));
+          header->version = CANCOMM_RECORD_VERSION;
+          header->record_size = sizeof(struct cancomm_record);
+          header->record_count = 0;
+          header->sequence = recorder->sequence;
+          header->created = (uint64_t)time(NULL);
+          header->timestamp_mode = recorder->ctx->opt_timestamp;
+          header->devices_cnt = 0;
+          /* Store the file state in the recorder. */
+          recorder->fd = fd;
+          recorder->map_size = mapSize;
+          recorder->map = (uint8_t *)map;
+          recorder->header = header;
+          recorder->records = (struct cancomm_record *)
+                              (recorder->map + CANCOMM_RECORD_HEADER_SIZE);
+          recorder->records_synced = 0;
+          recorder->sync_time = cancomm_monotonic_ns();
+          result = CANCOMM_TRUE;
+        }
+      }
+      if (result != CANCOMM_TRUE)
+      {
+        close(fd);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_recorder_file_open ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to close the current recording file of the recorder, if
+**            open. When rotating, the write back of the file is merely started, so
+**            the recording continues without waiting for the storage medium.
+** \param     recorder Non-opaque recorder.
+** \param     final CANCOMM_TRUE if the recording ends. In this case the function waits
+**            for the write back and shrinks the file to its actually used size.
+**
+****************************************************************************************/
+static void cancomm_recorder_file_close(struct cancomm_recorder * recorder, 
+                                        uint8_t final)
+{
+  off_t usedSize;
+
+  /* Verify parameter. */
+  assert(recorder != NULL);
+
+  /* Only continue with a valid parameter and if a file is open. */
+  if ((recorder != NULL) && (recorder->map != NULL))
+  {
+    usedSize = (off_t)(CANCOMM_RECORD_HEADER_SIZE + 
+               (recorder->header->record_count * sizeof(struct cancomm_record)));
+    if (final == CANCOMM_TRUE)
+    {
+      (void)msync(recorder->map, recorder->map_size, MS_SYNC);
+      (void)munmap(recorder->map, recorder->map_size);
+      (void)ftruncate(recorder->fd, usedSize);
+    }
+    else
+    {
+      (void)sync_file_range(recorder->fd, 0, usedSize, SYNC_FILE_RANGE_WRITE);
+      (void)munmap(recorder->map, recorder->map_size);
+    }
+    close(recorder->fd);
+    recorder->fd = -1;
+    recorder->map_size = 0;
+    recorder->map = NULL;
+    recorder->header = NULL;
+    recorder->records = NULL;
+  }
+} /*** end of cancomm_recorder_file_close ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to periodically start the write back of the newly recorded
+**            data. Without it, the kernel would only write back once the dirty page 
+**            limits are reached, after which writing to the memory mapping stalls. Note
+**            that on Linux, msync() with MS_ASYNC does not start a write back, so
+**            sync_file_range() is used instead. It also does not wait for completion.
+** \param     recorder Non-opaque recorder.
+**
+****************************************************************************************/
+static void cancomm_recorder_sync(struct cancomm_recorder * recorder)
+{
+  uint64_t now;
+  uint64_t startOffset;
+  uint64_t endOffset;
+
+  /* Verify parameter. */
+  assert(recorder != NULL);
+
+  /* Only continue with a valid parameter, an open file and if enabled. */
+  if ((recorder != NULL) && (recorder->header != NULL) && 
+      (recorder->sync_interval > 0))
+  {
+    now = cancomm_monotonic_ns();
+    if ((now - recorder->sync_time) >= recorder->sync_interval)
+    {
+      /* Write back the records since the previous time. The header also changed. */
+      startOffset = CANCOMM_RECORD_HEADER_SIZE + 
+                    (recorder->records_synced * sizeof(struct cancomm_record));
+      endOffset = CANCOMM_RECORD_HEADER_SIZE + 
+                  (recorder->header->record_count * sizeof(struct cancomm_record));
+      (void)sync_file_range(recorder->fd, (off_t)startOffset, 
+                            (off_t)(endOffset - startOffset), SYNC_FILE_RANGE_WRITE);
+      (void)sync_file_range(recorder->fd, 0, CANCOMM_RECORD_HEADER_SIZE, 
+                            SYNC_FILE_RANGE_WRITE);
+      recorder->records_synced = recorder->header->record_count;
+      recorder->sync_time = now;
+    }
+  }
+} /*** end of cancomm_recorder_sync ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to store the name of a CAN device in the header of a
+**            recording file, if not yet present. The name stays available to the tools,
+**            even after the device is gone.
+** \param     header Pointer to the header of the recording file.
+** \param     ifindex Interface index of the CAN device.
+**
+****************************************************************************************/
+static void cancomm_recorder_device_add(struct cancomm_record_header * header, 
+                                        uint32_t ifindex)
+{
+  struct cancomm_record_device * device;
+
+  /* Verify parameter. */
+  assert(header != NULL);
+
+  /* Only continue with a valid parameter and if not yet present. */
+  if ((header != NULL) && 
+      (cancomm_export_device(header, ifindex) == CANCOMM_RECORD_DEVICES_MAX) &&
+      (header->devices_cnt < CANCOMM_RECORD_DEVICES_MAX))
+  {
+    device = &header->devices[header->devices_cnt];
+    device->ifindex = ifindex;
+    if (if_indextoname(ifindex, device->name) == NULL)
+    {
+      device->name[0] = '\0';
+    }
+    header->devices_cnt++;
+  }
+} /*** end of cancomm_recorder_device_add ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to look up a CAN device in the header of a recording file.
+** \param     header Pointer to the header of the recording file.
+** \param     ifindex Interface index of the CAN device.
+** \return    Index of the device in the devices array of the header. 
+**            CANCOMM_RECORD_DEVICES_MAX if not present.
+**
+****************************************************************************************/
+static uint32_t cancomm_export_device(struct cancomm_record_header const * header,
+                                      uint32_t ifindex)
+{
+  uint32_t result = CANCOMM_RECORD_DEVICES_MAX;
+  uint32_t idx;
+
+  /* Verify parameter. */
+  assert(header != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (header != NULL)
+  {
+    for (idx = 0; (idx < header->devices_cnt) && 
+                  (idx < CANCOMM_RECORD_DEVICES_MAX); idx++)
+    {
+      if (header->devices[idx].ifindex == ifindex)
+      {
+        result = idx;
+        break;
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_export_device ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to convert the timestamp of a record to microseconds.
+** \param     header Pointer to the header of the recording file.
+** \param     timestamp Timestamp as stored in the record.
+** \return    Timestamp in microseconds.
+**
+****************************************************************************************/
+static uint64_t cancomm_export_time_us(struct cancomm_record_header const * header,
+                                       uint64_t timestamp)
+{
+  return cancomm_recording_time_ns(header, timestamp) / 1000U;
+} /*** end of cancomm_export_time_us ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to write records in the log file format of candump -l from
+**            can-utils, which canplayer can replay.
+** \param     logFile Log file to write to.
+** \param     header Pointer to the header of the recording file.
+** \param     records Pointer to the array with the records.
+** \param     count Number of records in the array.
+**
+****************************************************************************************/
+static void cancomm_export_candump(FILE * logFile, 
+                                   struct cancomm_record_header const * header,
+                                   struct cancomm_record const * records, uint64_t count)
+{
+  struct cancomm_record const * record;
+  char fallbackName[IF_NAMESIZE + 8];
+  char const * name;
+  uint64_t timeUs;
+  uint32_t deviceIdx;
+  uint64_t idx;
+
+  for (idx = 0; idx < count; idx++)
+  {
+    record = &records[idx];
+    /* Determine the name of the CAN device. */
+    deviceIdx = cancomm_export_device(header, record->ifindex);
+    if ((deviceIdx < CANCOMM_RECORD_DEVICES_MAX) && 
+        (header->devices[deviceIdx].name[0] != '\0'))
+    {
+      name = header->devices[deviceIdx].name;
+    }
+    else
+    {
+      (void)snprintf(fallbackName, sizeof(fallbackName), "can%u", record->ifindex);
+      name = fallbackName;
+    }
+    timeUs = cancomm_export_time_us(header, record->timestamp);
+    fprintf(logFile, "(%" PRIu64 ".%06" PRIu64 ") %s ", timeUs / 1000000U, 
+            timeUs % 1000000U, name);
+    /* Write the identifier. Error frames have no identifier and data here. */
+    if ((record->flags & CANCOMM_FLAG_CANERR_MSG) != 0)
+    {
+      fprintf(logFile, "%08X#", CAN_ERR_FLAG);
+    }
+    else
+    {
+      fprintf(logFile, (record->ext == CANCOMM_TRUE) ? "%08X" : "%03X", record->id);
+      /* The record does not hold the bit rate switch flag. Report it as set, which is
+       * how this library transmits CAN FD frames.
+       */
+      fputs(((record->flags & CANCOMM_FLAG_CANFD_MSG) != 0) ? "##1" : "#", logFile);
+      for (uint8_t dataIdx = 0; 
+           (dataIdx < record->len) && (dataIdx < CANCOMM_DATA_LEN_MAX); dataIdx++)
+      {
+        fprintf(logFile, "%02X", record->data[dataIdx]);
+      }
+    }
+    fputc('\n', logFile);
+  }
+} /*** end of cancomm_export_candump ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to write records in the ASCII log file format (ASC) of
+**            Vector tools. The timestamps are relative to the first record and the
+**            channel numbers follow the order of the CAN devices in the header.
+** \param     logFile Log file to write to.
+** \param     header Pointer to the header of the recording file.
+** \param     records Pointer to the array with the records.
+** \param     count Number of records in the array.
+**
+****************************************************************************************/
+static void cancomm_export_asc(FILE * logFile, 
+                               struct cancomm_record_header const * header,
+                               struct cancomm_record const * records, uint64_t count)
+{
+  static const uint8_t fdLengths[] = { 8, 12, 16, 20, 24, 32, 48, 64 };
+  struct cancomm_record const * record;
+  char dateText[64];
+  char idText[16];
+  struct tm created;
+  time_t createdTime;
+  uint64_t startUs = 0;
+  uint64_t timeUs;
+  uint32_t channel;
+  uint8_t dlc;
+  uint64_t idx;
+
+  /* Write the file header, with the creation time of the recording file. */
+  createdTime = (time_t)header->created;
+  (void)localtime_r(&createdTime, &created);
+  (void)strftime(dateText, sizeof(dateText), "%a %b %d %I:%M:%S.000 %P %Y", &created);
+  fprintf(logFile, "date %s\nbase hex  timestamps absolute\ninternal events logged\n"
+          "Begin Triggerblock %s\n   0.000000 Start of measurement\n", dateText, 
+          dateText);
+  if (count > 0)
+  {
+    startUs = cancomm_export_time_us(header, records[0].timestamp);
+  }
+  for (idx = 0; idx < count; idx++)
+  {
+    record = &records[idx];
+    /* Channels start at one. Frames of unknown devices go to the first channel. */
+    channel = cancomm_export_device(header, record->ifindex);
+    channel = (channel < CANCOMM_RECORD_DEVICES_MAX) ? (channel + 1U) : 1U;
+    timeUs = cancomm_export_time_us(header, record->timestamp);
+    timeUs = (timeUs > startUs) ? (timeUs - startUs) : 0U;
+    fprintf(logFile, "%4" PRIu64 ".%06" PRIu64 " ", timeUs / 1000000U, 
+            timeUs % 1000000U);
+    if ((record->flags & CANCOMM_FLAG_CANERR_MSG) != 0)
+    {
+      fprintf(logFile, "%u  ErrorFrame\n", channel);
+      continue;
+    }
+    (void)snprintf(idText, sizeof(idText), (record->ext == CANCOMM_TRUE) ? "%Xx" : "%X",
+                   record->id);
+    if ((record->flags & CANCOMM_FLAG_CANFD_MSG) != 0)
+    {
+      /* Determine the data length code of the CAN FD frame. */
+      dlc = (record->len <= 8U) ? record->len : 15U;
+      for (uint8_t lenIdx = 1; lenIdx < sizeof(fdLengths); lenIdx++)
+      {
+        if ((record->len > fdLengths[lenIdx - 1U]) && (record->len <= fdLengths[lenIdx]))
+        {
+          dlc = 8U + lenIdx;
+          break;
+        }
+      }
+      fprintf(logFile, "CANFD %3u Rx   %8s  %32s 1 0 %x %2u", channel, idText, "", 
+              dlc, record->len);
+    }
+    else
+    {
+      fprintf(logFile, "%u  %-15s Rx   d %u", channel, idText, record->len);
+    }
+    for (uint8_t dataIdx = 0; 
+         (dataIdx < record->len) && (dataIdx < CANCOMM_DATA_LEN_MAX); dataIdx++)
+    {
+      fprintf(logFile, " %02X", record->data[dataIdx]);
+    }
+    if ((record->flags & CANCOMM_FLAG_CANFD_MSG) != 0)
+    {
+      /* Unknown duration, length, CRC and bit timings. Just the EDL and BRS flags,
+       * for the same reason as with the candump format.
+       */
+      fprintf(logFile, " %8u %4u %8X %8u %8u %8u %8u %8u", 0U, 0U, 0x3000U, 0U, 0U, 0U, 
+              0U, 0U);
+    }
+    fputc('\n', logFile);
+  }
+  fputs("End TriggerBlock\n", logFile);
+} /*** end of cancomm_export_asc ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to map a recording file for reading and to validate it.
+** \param     path Path of the recording file.
+** \param     recordingMap Pointer to where the mapping info is stored.
+** \return    CANCOMM_TRUE if successful, CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_recording_open(char const * path, 
+                                      struct cancomm_recording_map * recordingMap)
+{
+  uint8_t result = CANCOMM_FALSE;
+  struct stat fileStat;
+  void * map = MAP_FAILED;
+  uint64_t recordCount;
+  int fd;
+
+  /* Verify parameters. */
+  assert((path != NULL) && (recordingMap != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((path != NULL) && (recordingMap != NULL))
+  {
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+      if ((fstat(fd, &fileStat) == 0) && 
+          ((size_t)fileStat.st_size >= CANCOMM_RECORD_HEADER_SIZE))
+      {
+        map = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      close(fd);
+    }
+    if (map != MAP_FAILED)
+    {
+      (void)madvise(map, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+      recordingMap->map = map;
+      recordingMap->size = (size_t)fileStat.st_size;
+      recordingMap->header = (struct cancomm_record_header const *)map;
+      recordingMap->records = (struct cancomm_record const *)
+                              ((uint8_t const *)map + CANCOMM_RECORD_HEADER_SIZE);
+      /* Only accept files with a known format. */
+      if ((memcmp(recordingMap->header->magic, CANCOMM_RECORD_MAGIC, 
+                  sizeof(recordingMap->header->magic)) == 0) &&
+          (recordingMap->header->version == CANCOMM_RECORD_VERSION) &&
+          (recordingMap->header->record_size == sizeof(struct cancomm_record)))
+      {
+        /* Do not trust the record count beyond the size of the file. */
+        recordCount = (recordingMap->size - CANCOMM_RECORD_HEADER_SIZE) / 
+                      sizeof(struct cancomm_record);
+        recordingMap->count = (recordingMap->header->record_count < recordCount) ?
+                              recordingMap->header->record_count : recordCount;
+        result = CANCOMM_TRUE;
+      }
+      else
+      {
+        munmap(map, (size_t)fileStat.st_size);
+      }
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_recording_open ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to unmap a recording file.
+** \param     recordingMap Pointer to the mapping info.
+**
+****************************************************************************************/
+static void cancomm_recording_close(struct cancomm_recording_map * recordingMap)
+{
+  /* Verify parameter. */
+  assert(recordingMap != NULL);
+
+  /* Only continue with a valid parameter. */
+  if (recordingMap != NULL)
+  {
+    munmap(recordingMap->map, recordingMap->size);
+  }
+} /*** end of cancomm_recording_close ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to convert the timestamp of a record to nanoseconds.
+** \param     header Pointer to the header of the recording file.
+** \param     timestamp Timestamp as stored in the record.
+** \return    Timestamp in nanoseconds.
+**
+****************************************************************************************/
+static uint64_t cancomm_recording_time_ns(struct cancomm_record_header const * header,
+                                          uint64_t timestamp)
+{
+  return (header->timestamp_mode == CANCOMM_TIMESTAMP_SW_US) ? (timestamp * 1000U) : 
+                                                               timestamp;
+} /*** end of cancomm_recording_time_ns ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to determine at which point in time a record is due for
+**            transmission during a replay.
+** \param     recordingMap Pointer to the mapping info of the recording file.
+** \param     record Pointer to the record.
+** \param     startTime Time (CLOCK_MONOTONIC nanoseconds) at which the replay started.
+** \param     firstTimestamp Timestamp in nanoseconds of the first record.
+** \param     speed Replay speed in percent. Not CANCOMM_REPLAY_SPEED_MAX.
+** \return    Time (CLOCK_MONOTONIC nanoseconds) at which the record is due.
+**
+****************************************************************************************/
+static uint64_t cancomm_replay_deadline(struct cancomm_recording_map const * recordingMap,
+                                        struct cancomm_record const * record,
+                                        uint64_t startTime, uint64_t firstTimestamp,
+                                        uint32_t speed)
+{
+  uint64_t timestamp;
+  uint64_t offset = 0;
+
+  /* Timestamps before the first one, such as from another CAN device, are due 
+   * right away.
+   */
+  timestamp = cancomm_recording_time_ns(recordingMap->header, record->timestamp);
+  if (timestamp > firstTimestamp)
+  {
+    offset = ((timestamp - firstTimestamp) * 100U) / speed;
+  }
+  return startTime + offset;
+} /*** end of cancomm_replay_deadline ***/
+
+
+/************************************************************************************//**
+** \brief     Helper function to transmit frames of a replay. Retries while the transmit
+**            queue of the CAN device is full.
+** \param     ctx Non-opaque CAN communication context.
+** \param     frames Pointer to the array with the frames to transmit.
+** \param     count Number of frames in the array.
+** \param     sent Pointer to the total number of transmitted frames, which is 
+**            incremented.
+** \param     scheduled CANCOMM_TRUE to pass the timestamp member of each frame to the
+**            kernel as its launch time, CANCOMM_FALSE to transmit right away.
+** \return    CANCOMM_TRUE if all frames were transmitted. CANCOMM_FALSE otherwise.
+**
+****************************************************************************************/
+static uint8_t cancomm_replay_send(struct cancomm_ctx * ctx, cancomm_frame_t * frames,
+                                   size_t count, uint64_t * sent, uint8_t scheduled)
+{
+  uint8_t result = CANCOMM_FALSE;
+  size_t done = 0;
+  size_t chunkSent;
+  uint8_t txResult;
+
+  /* Verify parameters. */
+  assert((ctx != NULL) && (frames != NULL) && (sent != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((ctx != NULL) && (frames != NULL) && (sent != NULL))
+  {
+    for (;;)
+    {
+      txResult = cancomm_frames_send(ctx, &frames[done], count - done, &chunkSent,
+                                     scheduled);
+      done += chunkSent;
+      *sent += chunkSent;
+      if (txResult == CANCOMM_TRUE)
+      {
+        result = CANCOMM_TRUE;
+        break;
+      }
+      /* Anything but a full queue, such as a frame that cannot be transmitted, ends
+       * the replay.
+       */
+      if (cancomm_last_tx_queue_full() != CANCOMM_TRUE)
+      {
+        break;
+      }
+      /* Wait for the queue to drain. */
+      if (cancomm_tx_space_wait(ctx, NULL) != CANCOMM_TRUE)
+      {
+        break;
+      }
+    }
+  }
 
   /* Give the result back to the caller. */
   return result;
-} /*** end of cancomm_sanitize_frame_len ***/
+} /*** end of cancomm_replay_send ***/
 
 
 /*********************************** end of cancomm.c **********************************/
@@ -33,6 +33,7 @@ extern "C" {
 * Include files
 ****************************************************************************************/
 #include <stdint.h>                         /* for standard integer types              */
+#include <stddef.h>                         /* for size_t                              */
 
 
 /****************************************************************************************
@@ -47,9 +48,170 @@ extern "C" {
 /** \brief Bit flag to indicate that the message is a CAN FD message. */
 #define CANCOMM_FLAG_CANFD_MSG         (0x01)
 
+/** \brief Bit flag to indicate that a subscribed CAN message stopped arriving. */
+#define CANCOMM_FLAG_TIMEOUT_MSG       (0x40)
+
 /** \brief Bit flag to indicate that the message is a CAN error frame. */
 #define CANCOMM_FLAG_CANERR_MSG        (0x80)
 
+/** \brief Maximum number of data bytes in a CAN message. */
+#define CANCOMM_DATA_LEN_MAX           (64)
+
+/** \brief Device name for connecting to all SocketCAN devices at once. */
+#define CANCOMM_DEVICE_ANY             "any"
+
+/** \brief Timeout value to wait indefinitely for an event to happen. */
+#define CANCOMM_TIMEOUT_INFINITE       (0xFFFFFFFFu)
+
+/** \brief Maximum number of acceptance filters per context. Matches the limit of the
+ *         kernel.
+ */
+#define CANCOMM_FILTERS_MAX            (512U)
+
+/** \brief Error frame mask that enables the reception of all CAN error frame classes.
+ *         See linux/can/error.h for the individual error classes (CAN_ERR_xxx).
+ */
+#define CANCOMM_ERR_MASK_ALL           (0x1FFFFFFFu)
+
+/** \brief Context option for selecting the timestamp mode. The value is one of the
+ *         CANCOMM_TIMESTAMP_xxx macros.
+ */
+#define CANCOMM_OPT_TIMESTAMP          (1U)
+
+/** \brief Timestamp mode with software timestamps in microseconds (default). */
+#define CANCOMM_TIMESTAMP_SW_US        (0U)
+
+/** \brief Timestamp mode with software timestamps in nanoseconds. */
+#define CANCOMM_TIMESTAMP_SW_NS        (1U)
+
+/** \brief Timestamp mode with hardware timestamps in nanoseconds, if supported by the
+ *         CAN device. Falls back to software timestamps in nanoseconds otherwise.
+ */
+#define CANCOMM_TIMESTAMP_HW_NS        (2U)
+
+/** \brief Context option for selecting the clock that timestamps are based on. The value
+ *         is one of the CANCOMM_CLOCK_xxx macros.
+ */
+#define CANCOMM_OPT_CLOCK              (2U)
+
+/** \brief Clock based on the system time (default). Affected by system time changes. */
+#define CANCOMM_CLOCK_REALTIME         (0U)
+
+/** \brief Monotonic clock. Not affected by system time changes, yet subject to the
+ *         frequency adjustments of NTP.
+ */
+#define CANCOMM_CLOCK_MONOTONIC        (1U)
+
+/** \brief Monotonic clock, based on the raw hardware time without NTP adjustments. */
+#define CANCOMM_CLOCK_MONOTONIC_RAW    (2U)
+
+/** \brief Context option for selecting the backend that receives the frames from the
+ *         kernel. The value is one of the CANCOMM_BACKEND_xxx macros.
+ */
+#define CANCOMM_OPT_BACKEND            (3U)
+
+/** \brief Backend that receives the frames through the CAN raw socket (default). */
+#define CANCOMM_BACKEND_RAW            (0U)
+
+/** \brief Backend that reads the received frames straight from a memory mapped ring 
+ *         buffer, shared with the kernel (AF_PACKET socket with TPACKET_V3). Saves
+ *         copying and system calls at high bus loads. Acceptance filters are evaluated
+ *         in user space with this backend.
+ */
+#define CANCOMM_BACKEND_PACKET_MMAP    (1U)
+
+/** \brief Backend that performs all I/O asynchronously through the shared queues of an
+ *         io_uring instance. A multishot receive request stays armed, so frames are
+ *         received without a system call per batch, and transmissions are queued 
+ *         without waiting for the kernel.
+ */
+#define CANCOMM_BACKEND_IO_URING       (2U)
+
+/** \brief Context option for the size of the socket's send buffer in bytes. Zero for the
+ *         default of the kernel. Applied upon connect. A small send buffer makes
+ *         cancomm_last_tx_queue_full() report a full transmit queue before the queue of
+ *         the CAN device fills up, such that cancomm_wait_writable() works exactly.
+ */
+#define CANCOMM_OPT_SNDBUF             (4U)
+
+/** \brief Context option for the size of the socket's receive buffer in bytes. Zero for
+ *         the default of the kernel. Applied upon connect. A large receive buffer
+ *         prevents frame loss during bursts.
+ */
+#define CANCOMM_OPT_RCVBUF             (5U)
+
+/** \brief Context option for the number of frames that cancomm_receive_batch_timeout()
+ *         waits for, before it returns. Zero or one to return as soon as a frame is
+ *         available (default).
+ */
+#define CANCOMM_OPT_COALESCE_FRAMES    (6U)
+
+/** \brief Context option for the maximum time in microseconds that 
+ *         cancomm_receive_batch_timeout() waits for more frames, after the first one
+ *         arrived. Zero to not wait for more frames (default).
+ */
+#define CANCOMM_OPT_COALESCE_US        (7U)
+
+/** \brief Context option for the time in microseconds that cancomm_replay() queues the
+ *         frames ahead of their due time, with the due time as the launch time 
+ *         (SO_TXTIME). Zero to sleep until each frame is due (default).
+ */
+#define CANCOMM_OPT_REPLAY_TXTIME_US   (8U)
+
+/** \brief Log file format of candump -l (can-utils), for cancomm_recording_export(). */
+#define CANCOMM_EXPORT_CANDUMP         (0U)
+
+/** \brief ASCII log file format (ASC) of Vector tools, for cancomm_recording_export(). */
+#define CANCOMM_EXPORT_ASC             (1U)
+
+/** \brief Replay speed that keeps the original timing of the recorded frames. */
+#define CANCOMM_REPLAY_SPEED_ORIGINAL  (100U)
+
+/** \brief Replay speed that transmits the recorded frames without pauses. */
+#define CANCOMM_REPLAY_SPEED_MAX       (0U)
+
+/** \brief Bus state of a CAN device without errors. Also reported when the CAN device
+ *         does not report its bus state, such as a virtual CAN device.
+ */
+#define CANCOMM_LINK_STATE_ERROR_ACTIVE  (0U)
+
+/** \brief Bus state of a CAN device with an error counter of 96 or more. */
+#define CANCOMM_LINK_STATE_ERROR_WARNING (1U)
+
+/** \brief Bus state of a CAN device with an error counter of 128 or more. */
+#define CANCOMM_LINK_STATE_ERROR_PASSIVE (2U)
+
+/** \brief Bus state of a CAN device that went off the bus, due to a transmit error
+ *         counter of 256 or more.
+ */
+#define CANCOMM_LINK_STATE_BUS_OFF       (3U)
+
+/** \brief Bus state of a CAN device that is stopped, for example because it is down. */
+#define CANCOMM_LINK_STATE_STOPPED       (4U)
+
+/** \brief Bus state of a CAN device that is in sleep mode. */
+#define CANCOMM_LINK_STATE_SLEEPING      (5U)
+
+/** \brief Route flag to forward CAN FD frames. Without it, the route forwards CAN
+ *         classic frames.
+ */
+#define CANCOMM_GW_FLAG_CANFD          (0x01)
+
+/** \brief Route flag to pass the forwarded frames to the local sockets on the
+ *         destination device as well, as if they were transmitted locally. Only for
+ *         kernel routes.
+ */
+#define CANCOMM_GW_FLAG_ECHO           (0x02)
+
+/** \brief Modification of the CAN message identifier and its type. */
+#define CANCOMM_GW_MOD_ID              (0x01)
+
+/** \brief Modification of the number of CAN message data bytes. */
+#define CANCOMM_GW_MOD_LEN             (0x02)
+
+/** \brief Modification of the CAN message data bytes. */
+#define CANCOMM_GW_MOD_DATA            (0x04)
+
 
 /****************************************************************************************
 * Type definitions
@@ -57,6 +219,224 @@ extern "C" {
 /** \brief Opaque pointer for the CAN communication context. */
 typedef void * cancomm_t;
 
+/** \brief Opaque pointer for a CAN message that was prepared for repeated 
+ *         transmission.
+ */
+typedef void * cancomm_prepared_t;
+
+/** \brief Opaque pointer for an ISO-TP channel. */
+typedef void * cancomm_isotp_t;
+
+/** \brief Opaque pointer for a recorder that writes received frames to files. */
+typedef void * cancomm_recorder_t;
+
+/** \brief Opaque pointer for a forwarder that routes frames between CAN devices. */
+typedef void * cancomm_forwarder_t;
+
+/** \brief Structure with all the information of a single CAN message or CAN error
+ *         frame. Allows functions to process multiple messages in one go, using a
+ *         caller owned array of these structures.
+ */
+typedef struct
+{
+  /** \brief CAN message identifier. */
+  uint32_t id;
+  /** \brief CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for 29-bit. */
+  uint8_t  ext;
+  /** \brief Number of CAN message data bytes. */
+  uint8_t  len;
+  /** \brief Bit flags with additional information about the message, such as
+   *         CANCOMM_FLAG_CANFD_MSG and CANCOMM_FLAG_CANERR_MSG.
+   */
+  uint8_t  flags;
+  /** \brief Interface index of the CAN device that the message was received on, or
+   *         should be transmitted on. Zero for the connected device upon transmission.
+   *         Use if_indextoname() to obtain the device name.
+   */
+  uint32_t ifindex;
+  /** \brief Timestamp of the message. In microseconds, unless configured otherwise
+   *         with option CANCOMM_OPT_TIMESTAMP.
+   */
+  uint64_t timestamp;
+  /** \brief Array with the CAN message data bytes. */
+  uint8_t  data[CANCOMM_DATA_LEN_MAX];
+} cancomm_frame_t;
+
+/** \brief Structure with an acceptance filter. A received CAN message passes the filter
+ *         if (received_id & mask) == (id & mask) and its identifier type matches.
+ */
+typedef struct
+{
+  /** \brief CAN message identifier to match. */
+  uint32_t id;
+  /** \brief Bit mask with the identifier bits that must match. */
+  uint32_t mask;
+  /** \brief CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for 29-bit. */
+  uint8_t  ext;
+  /** \brief CANCOMM_TRUE to invert the filter, such that it passes all the CAN messages
+   *         that do not match.
+   */
+  uint8_t  invert;
+} cancomm_filter_t;
+
+/** \brief Structure with the statistics of a context, as obtained with
+ *         cancomm_get_stats(). The counters accumulate from the moment the context was
+ *         created.
+ */
+typedef struct
+{
+  /** \brief Number of received frames that were handed over to the application. */
+  uint64_t rx_frames;
+  /** \brief Number of received frames that were discarded, because they were invalid.
+   *         For example remote frames or frames with an unexpected size.
+   */
+  uint64_t rx_dropped;
+  /** \brief Number of receive attempts that found no frames to read. */
+  uint64_t rx_empty;
+  /** \brief Number of frames that the kernel dropped, because the receive queue of the
+   *         socket was full.
+   */
+  uint64_t rx_overflows;
+  /** \brief Number of frames that the background reader thread dropped, because its
+   *         ring was full. Since the start of the background reader thread.
+   */
+  uint64_t reader_drops;
+  /** \brief Number of frames that were submitted for transmission. */
+  uint64_t tx_frames;
+  /** \brief Number of transmit attempts that failed, because the transmit queue was
+   *         full.
+   */
+  uint64_t tx_queue_full;
+  /** \brief Number of transmit attempts that failed for another reason. */
+  uint64_t tx_errors;
+} cancomm_stats_t;
+
+/** \brief Structure with the configuration of a CAN device. */
+typedef struct
+{
+  /** \brief Bitrate in bits per second. For CAN FD the bitrate of the arbitration
+   *         phase. Zero if not known, or to keep it as is upon configuration.
+   */
+  uint32_t bitrate;
+  /** \brief Bitrate in bits per second of the CAN FD data phase. Zero if not known, or
+   *         to keep it as is upon configuration.
+   */
+  uint32_t data_bitrate;
+  /** \brief Time in milliseconds after which the CAN device automatically restarts
+   *         after going off the bus. Zero to disable the automatic restart.
+   */
+  uint32_t restart_ms;
+  /** \brief CANCOMM_TRUE if the CAN device operates in CAN FD mode, CANCOMM_FALSE for
+   *         CAN classic.
+   */
+  uint8_t  fd;
+  /** \brief CANCOMM_TRUE if the CAN device is up, CANCOMM_FALSE if it is down. */
+  uint8_t  up;
+} cancomm_link_config_t;
+
+/** \brief Structure with the bus state and the error statistics of a CAN device. The
+ *         statistics count from the moment the CAN device was created.
+ */
+typedef struct
+{
+  /** \brief Bus state, such as CANCOMM_LINK_STATE_BUS_OFF. */
+  uint32_t state;
+  /** \brief Transmit error counter of the CAN controller. */
+  uint16_t tx_errors;
+  /** \brief Receive error counter of the CAN controller. */
+  uint16_t rx_errors;
+  /** \brief Number of bus errors, such as bit and stuff errors. */
+  uint32_t bus_errors;
+  /** \brief Number of changes to the error warning state. */
+  uint32_t error_warning;
+  /** \brief Number of changes to the error passive state. */
+  uint32_t error_passive;
+  /** \brief Number of changes to the bus off state. */
+  uint32_t bus_off;
+  /** \brief Number of transmissions that lost the arbitration. */
+  uint32_t arbitration_lost;
+  /** \brief Number of restarts after going off the bus. */
+  uint32_t restarts;
+} cancomm_link_state_t;
+
+/** \brief Structure with a modification of the frames that a route forwards. The
+ *         operation (AND, OR, XOR or SET) depends on the member of the route that holds
+ *         the modification.
+ */
+typedef struct
+{
+  /** \brief Bit mask with the members of the frame to modify, such as 
+   *         CANCOMM_GW_MOD_ID. Zero to not modify the frames.
+   */
+  uint8_t  members;
+  /** \brief CAN message identifier operand. */
+  uint32_t id;
+  /** \brief CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for 29-bit.
+   *         Only used by the SET operation.
+   */
+  uint8_t  ext;
+  /** \brief Number of CAN message data bytes operand. */
+  uint8_t  len;
+  /** \brief CAN message data bytes operand. */
+  uint8_t  data[CANCOMM_DATA_LEN_MAX];
+} cancomm_gw_mod_t;
+
+/** \brief Structure with a checksum that a route updates in the forwarded frames. The
+ *         indices select data bytes. Negative indices count from the end of the frame,
+ *         such that -1 is its last data byte.
+ */
+typedef struct
+{
+  /** \brief CANCOMM_TRUE to update the checksum, CANCOMM_FALSE otherwise. */
+  uint8_t  enabled;
+  /** \brief Index of the first data byte that the checksum covers. */
+  int8_t   from;
+  /** \brief Index of the last data byte that the checksum covers. */
+  int8_t   to;
+  /** \brief Index of the data byte where the checksum is stored. */
+  int8_t   result;
+  /** \brief Initial value of the checksum. */
+  uint8_t  init;
+  /** \brief Value that the CRC8 checksum is XOR-ed with at the end. */
+  uint8_t  final_xor;
+  /** \brief Polynomial of the CRC8 checksum, such as 0x1D for SAE J1850. */
+  uint8_t  poly;
+} cancomm_gw_csum_t;
+
+/** \brief Structure with a route that forwards frames from one CAN device to another,
+ *         optionally modifying them on the way. The modifications are applied in the
+ *         order AND, OR, XOR, SET, followed by the CRC8 and the XOR checksums.
+ */
+typedef struct
+{
+  /** \brief Name of the CAN device to forward the frames from, e.g. "can0". */
+  char const * src_device;
+  /** \brief Name of the CAN device to forward the frames to, e.g. "can1". */
+  char const * dst_device;
+  /** \brief Pointer to the filter that the frames must pass to be forwarded. NULL to
+   *         forward all frames.
+   */
+  cancomm_filter_t const * filter;
+  /** \brief Bit flags of the route, such as CANCOMM_GW_FLAG_CANFD. */
+  uint8_t  flags;
+  /** \brief Maximum number of times that a frame is forwarded by kernel routes. Zero
+   *         for the kernel's default.
+   */
+  uint8_t  hops;
+  /** \brief Modification that AND-s the frame members with its operands. */
+  cancomm_gw_mod_t  mod_and;
+  /** \brief Modification that OR-s the frame members with its operands. */
+  cancomm_gw_mod_t  mod_or;
+  /** \brief Modification that XOR-s the frame members with its operands. */
+  cancomm_gw_mod_t  mod_xor;
+  /** \brief Modification that sets the frame members to its operands. */
+  cancomm_gw_mod_t  mod_set;
+  /** \brief XOR checksum over data bytes. Members final_xor and poly are not used. */
+  cancomm_gw_csum_t csum_xor;
+  /** \brief CRC8 checksum over data bytes. */
+  cancomm_gw_csum_t csum_crc8;
+} cancomm_gw_route_t;
+
 
 /****************************************************************************************
 * Function prototypes
@@ -64,16 +444,126 @@ typedef void * cancomm_t;
 /* API for obtaining a context, allowing multiple applications to use this library. */
 cancomm_t   cancomm_new(void);
 void        cancomm_free(cancomm_t ctx);
-/* API for CAN communication using a specific CAN device. */
+uint8_t     cancomm_set_option(cancomm_t ctx, uint32_t option, uint32_t value);
+/* API for obtaining a context in caller provided storage, without heap allocations. */
+size_t      cancomm_ctx_size(void);
+cancomm_t   cancomm_init(void * buffer, size_t size);
+uint8_t     cancomm_reserve(cancomm_t ctx, uint32_t devices, uint32_t filters, 
+                            uint32_t ring_capacity);
+/* API for CAN communication using a specific CAN device or a set of CAN devices. */
 uint8_t     cancomm_connect(cancomm_t ctx, char const * device);
+uint8_t     cancomm_connect_devices(cancomm_t ctx, char const * const * devices, 
+                                    size_t count);
 void        cancomm_disconnect(cancomm_t ctx);
+void        cancomm_shutdown(cancomm_t ctx);
+uint8_t     cancomm_shutdown_requested(cancomm_t ctx);
 uint8_t     cancomm_transmit(cancomm_t ctx, uint32_t id, uint8_t ext, uint8_t len, 
                              uint8_t const * data, uint8_t flags, uint64_t * timestamp);
+uint8_t     cancomm_transmit_batch(cancomm_t ctx, cancomm_frame_t * frames, size_t count,
+                                   size_t * sent);
+uint8_t     cancomm_transmit_scheduled(cancomm_t ctx, cancomm_frame_t * frames, 
+                                       size_t count, size_t * sent);
+uint8_t     cancomm_wait_writable(cancomm_t ctx, uint32_t timeout_us);
+uint8_t     cancomm_last_tx_queue_full(void);
 uint8_t     cancomm_receive(cancomm_t ctx, uint32_t * id, uint8_t * ext, uint8_t * len, 
                              uint8_t * data, uint8_t * flags, uint64_t * timestamp);
+uint8_t     cancomm_receive_timeout(cancomm_t ctx, uint32_t * id, uint8_t * ext, 
+                                    uint8_t * len, uint8_t * data, uint8_t * flags, 
+                                    uint64_t * timestamp, uint32_t timeout_us);
+uint8_t     cancomm_receive_batch(cancomm_t ctx, cancomm_frame_t * frames, size_t max, 
+                                  size_t * count);
+uint8_t     cancomm_receive_batch_timeout(cancomm_t ctx, cancomm_frame_t * frames, 
+                                          size_t max, size_t * count, 
+                                          uint32_t timeout_us);
+/* API for repeatedly transmitting CAN messages, such as periodic ones, efficiently. */
+cancomm_prepared_t cancomm_prepare(cancomm_t ctx, cancomm_frame_t const * frame);
+void        cancomm_prepared_free(cancomm_prepared_t prepared);
+uint8_t   * cancomm_prepared_data(cancomm_prepared_t prepared);
+uint8_t     cancomm_prepared_update(cancomm_prepared_t prepared, uint8_t offset, 
+                                    uint8_t const * data, uint8_t len);
+uint8_t     cancomm_prepared_transmit(cancomm_t ctx, cancomm_prepared_t prepared,
+                                      uint64_t * timestamp);
+uint8_t     cancomm_prepared_transmit_batch(cancomm_t ctx, 
+                                            cancomm_prepared_t const * prepared, 
+                                            size_t count, size_t * sent);
+/* API for kernel offloaded cyclic transmission of CAN messages. */
+uint8_t     cancomm_cyclic_start(cancomm_t ctx, cancomm_frame_t const * frame, 
+                                 uint32_t period_us, uint32_t count);
+uint8_t     cancomm_cyclic_update(cancomm_t ctx, cancomm_frame_t const * frame);
+uint8_t     cancomm_cyclic_stop(cancomm_t ctx, cancomm_frame_t const * frame);
+/* API for kernel filtered reception of just the content changes of CAN messages. */
+uint8_t     cancomm_subscribe(cancomm_t ctx, cancomm_frame_t const * mask, 
+                              uint32_t timeout_us);
+uint8_t     cancomm_unsubscribe(cancomm_t ctx, cancomm_frame_t const * mask);
+uint8_t     cancomm_subscription_receive(cancomm_t ctx, cancomm_frame_t * frame);
+int         cancomm_subscription_get_fd(cancomm_t ctx);
+/* API for request and response transactions, such as diagnostic services. */
+uint8_t     cancomm_transact(cancomm_t ctx, cancomm_frame_t const * tx_frame, 
+                             uint32_t rx_id, uint32_t rx_mask, uint32_t timeout_us, 
+                             cancomm_frame_t * rx_frame);
+cancomm_isotp_t cancomm_isotp_new(cancomm_t ctx, uint32_t tx_id, uint32_t rx_id, 
+                                  uint8_t ext);
+void        cancomm_isotp_free(cancomm_isotp_t isotp);
+uint8_t     cancomm_isotp_transmit(cancomm_isotp_t isotp, uint8_t const * data, 
+                                   size_t len);
+uint8_t     cancomm_isotp_receive(cancomm_isotp_t isotp, uint8_t * data, size_t max, 
+                                  size_t * len, uint32_t timeout_us);
+/* API for receiving CAN messages with a background reader thread. */
+uint8_t     cancomm_reader_start(cancomm_t ctx, uint32_t capacity);
+void        cancomm_reader_stop(cancomm_t ctx);
+uint8_t     cancomm_reader_pop(cancomm_t ctx, cancomm_frame_t * frame);
+uint8_t     cancomm_reader_pop_batch(cancomm_t ctx, cancomm_frame_t * frames, size_t max,
+                                     size_t * count);
+uint64_t    cancomm_reader_drops(cancomm_t ctx);
+/* API for looking up the latest received frame of each CAN message. */
+uint8_t     cancomm_snapshot_enable(cancomm_t ctx, uint32_t capacity);
+void        cancomm_snapshot_disable(cancomm_t ctx);
+uint8_t     cancomm_snapshot_get(cancomm_t ctx, uint32_t id, uint8_t ext, 
+                                 uint32_t ifindex, cancomm_frame_t * frame, 
+                                 uint64_t * count);
+/* API for recording the received frames to rotating files and for replaying them. */
+cancomm_recorder_t cancomm_recorder_new(cancomm_t ctx, char const * path, 
+                                        uint64_t file_size, uint32_t file_count, 
+                                        uint32_t sync_ms);
+void        cancomm_recorder_free(cancomm_recorder_t recorder);
+uint8_t     cancomm_recorder_write(cancomm_recorder_t recorder, 
+                                   cancomm_frame_t const * frames, size_t count);
+uint8_t     cancomm_recorder_capture(cancomm_recorder_t recorder, uint32_t timeout_us,
+                                     size_t * count);
+uint8_t     cancomm_recording_export(char const * recording, char const * output, 
+                                     uint32_t format);
+uint8_t     cancomm_replay(cancomm_t ctx, char const * recording, uint32_t speed, 
+                           uint64_t * sent);
+/* API for integrating the CAN communication into an event loop. */
+int         cancomm_get_fd(cancomm_t ctx);
+/* API for configuring which CAN messages and error frames get received. */
+uint8_t     cancomm_set_filters(cancomm_t ctx, cancomm_filter_t const * filters, 
+                                size_t count);
+uint8_t     cancomm_set_error_filter(cancomm_t ctx, uint32_t mask);
+/* API for obtaining the statistics of the CAN communication. */
+uint8_t     cancomm_get_stats(cancomm_t ctx, cancomm_stats_t * stats);
 /* API for obtaining CAN device names on the system (can0, vcan0, etc.). */
 uint8_t     cancomm_devices_buildlist(cancomm_t ctx);
 char      * cancomm_devices_name(cancomm_t ctx, uint8_t idx);
+int         cancomm_devices_monitor(cancomm_t ctx);
+uint8_t     cancomm_devices_update(cancomm_t ctx);
+/* API for configuring CAN devices and for querying their bus state. */
+uint8_t     cancomm_link_get_config(cancomm_t ctx, char const * device, 
+                                    cancomm_link_config_t * config);
+uint8_t     cancomm_link_set_config(cancomm_t ctx, char const * device, 
+                                    cancomm_link_config_t const * config);
+uint8_t     cancomm_link_get_state(cancomm_t ctx, char const * device, 
+                                   cancomm_link_state_t * state);
+/* API for forwarding frames between CAN devices, in the kernel or in user space. */
+uint8_t     cancomm_gw_add(cancomm_t ctx, cancomm_gw_route_t const * route);
+uint8_t     cancomm_gw_remove(cancomm_t ctx, cancomm_gw_route_t const * route);
+uint8_t     cancomm_gw_flush(cancomm_t ctx);
+cancomm_forwarder_t cancomm_forwarder_new(cancomm_t ctx, 
+                                          cancomm_gw_route_t const * routes, 
+                                          size_t count);
+void        cancomm_forwarder_free(cancomm_forwarder_t forwarder);
+uint8_t     cancomm_forwarder_run(cancomm_forwarder_t forwarder, uint32_t timeout_us,
+                                  size_t * forwarded);
 
 #ifdef __cplusplus
 }
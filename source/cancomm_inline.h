@@ -0,0 +1,295 @@
+/************************************************************************************//**
+* \file         cancomm_inline.h
+* \brief        Header file with the inline fast path for converting CAN frames between
+*               the format of the library and the format of the CAN raw socket.
+*
+*----------------------------------------------------------------------------------------
+*                          C O P Y R I G H T
+*----------------------------------------------------------------------------------------
+*           Copyright (c) 2022 by PragmaticLinux     All rights reserved
+*
+*----------------------------------------------------------------------------------------
+*                            L I C E N S E
+*----------------------------------------------------------------------------------------
+* This library is free software; you can redistribute it and/or modify it under the terms
+* of the GNU Lesser General Public License as published by the Free Software Foundation;
+* either version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You have received a copy of the GNU Lesser General Public License along with library.
+* If not, see https://www.gnu.org/licenses/.
+*
+****************************************************************************************/
+#ifndef CANCOMM_INLINE_H
+#define CANCOMM_INLINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>                         /* for standard integer types              */
+#include <stddef.h>                         /* for size_t                              */
+#include <string.h>                         /* for string library                      */
+#include <assert.h>                         /* for assertions                          */
+#include <linux/can.h>                      /* for CAN frame definitions               */
+#include "cancomm.h"                        /* for the CAN communication library       */
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static inline uint8_t cancomm_inline_len_sanitize(uint8_t len);
+static inline void    cancomm_inline_data_copy(uint8_t * dst, uint8_t const * src,
+                                               uint8_t len);
+static inline uint8_t cancomm_inline_frame_pack(uint32_t id, uint8_t ext, uint8_t len,
+                                                uint8_t const * data, uint8_t flags,
+                                                uint8_t fd_enabled,
+                                                struct canfd_frame * raw,
+                                                size_t * size);
+static inline uint8_t cancomm_inline_frame_unpack(struct canfd_frame const * raw,
+                                                  size_t size, cancomm_frame_t * frame);
+
+
+/************************************************************************************//**
+** \brief     Sanitizes the CAN frame length, specifically for CAN FD. On CAN FD, the
+**            frame lengths can be: 0..8, 12, 16, 20, 24, 32, 48, 64. This means that if
+**            a frame length of 14 is specified, it is rounded up to the next supported
+**            frame length value, 16 in this case. A single table lookup maps the
+**            length straight to its sanitized value.
+** \param     len Unsanitized frame length. 0..64.
+** \return    Sanitized frame length in the range 0..8, 12, 16, 20, 24, 32, 48, 64.
+**
+****************************************************************************************/
+static inline uint8_t cancomm_inline_len_sanitize(uint8_t len)
+{
+  uint8_t result;
+  uint8_t frame_len;
+  static const uint8_t len2len[CANFD_MAX_DLEN + 1] =
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,    /*  0 -  8 */
+    12, 12, 12, 12,                        /*  9 - 12 */
+    16, 16, 16, 16,                        /* 13 - 16 */
+    20, 20, 20, 20,                        /* 17 - 20 */
+    24, 24, 24, 24,                        /* 21 - 24 */
+    32, 32, 32, 32, 32, 32, 32, 32,        /* 25 - 32 */
+    48, 48, 48, 48, 48, 48, 48, 48,        /* 33 - 40 */
+    48, 48, 48, 48, 48, 48, 48, 48,        /* 41 - 48 */
+    64, 64, 64, 64, 64, 64, 64, 64,        /* 49 - 56 */
+    64, 64, 64, 64, 64, 64, 64, 64         /* 57 - 64 */
+  };
+
+  /* Make sure the specified len parameter is valid. If not, correct it. */
+  frame_len = (len > CANFD_MAX_DLEN) ? CANFD_MAX_DLEN : len;
+  /* Convert the length value to its representive frame length value. */
+  result = len2len[frame_len];
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_inline_len_sanitize ***/
+
+
+/************************************************************************************//**
+** \brief     Copies the data bytes of a frame with fixed-size word copies, instead of
+**            byte by byte. Lengths of 16 bytes and more are copied in blocks of 16
+**            bytes, which the compiler turns into vector moves, and the last block
+**            overlaps with the previous one, such that no byte outside of the source is
+**            read. Shorter lengths are copied with two overlapping word copies.
+** \param     dst Pointer to where the data bytes are stored.
+** \param     src Pointer to the data bytes to copy.
+** \param     len Number of data bytes to copy.
+**
+****************************************************************************************/
+static inline void cancomm_inline_data_copy(uint8_t * dst, uint8_t const * src,
+                                            uint8_t len)
+{
+  uint8_t offset;
+
+  if (len >= 16U)
+  {
+    for (offset = 0; (offset + 16U) < len; offset += 16U)
+    {
+      memcpy(&dst[offset], &src[offset], 16U);
+    }
+    memcpy(&dst[len - 16U], &src[len - 16U], 16U);
+  }
+  else if (len >= 8U)
+  {
+    memcpy(dst, src, 8U);
+    memcpy(&dst[len - 8U], &src[len - 8U], 8U);
+  }
+  else if (len >= 4U)
+  {
+    memcpy(dst, src, 4U);
+    memcpy(&dst[len - 4U], &src[len - 4U], 4U);
+  }
+  else
+  {
+    for (offset = 0; offset < len; offset++)
+    {
+      dst[offset] = src[offset];
+    }
+  }
+} /*** end of cancomm_inline_data_copy ***/
+
+
+/************************************************************************************//**
+** \brief     Constructs a frame, as needed for transmission on the CAN raw socket.
+** \param     id CAN message identifier.
+** \param     ext CANCOMM_FALSE for an 11-bit message identifier, CANCOMM_TRUE for
+**            29-bit.
+** \param     len Number of CAN message data bytes.
+** \param     data Pointer to array with data bytes.
+** \param     flags Bit flags for providing additional information about how to transmit
+**            the message. See cancomm_transmit().
+** \param     fd_enabled CANCOMM_TRUE if the socket was configured for CAN FD, in which
+**            case flag CANCOMM_FLAG_CANFD_MSG results in a CAN FD frame with the bit
+**            rate switch. CANCOMM_FALSE otherwise.
+** \param     raw Pointer to where the constructed frame is stored.
+** \param     size Pointer to where the number of bytes to write to the socket is stored.
+** \return    CANCOMM_TRUE if the frame was constructed. CANCOMM_FALSE if the data does
+**            not fit in the frame.
+**
+****************************************************************************************/
+static inline uint8_t cancomm_inline_frame_pack(uint32_t id, uint8_t ext, uint8_t len,
+                                                uint8_t const * data, uint8_t flags,
+                                                uint8_t fd_enabled,
+                                                struct canfd_frame * raw,
+                                                size_t * size)
+{
+  uint8_t result = CANCOMM_FALSE;
+  uint8_t frameLenMax;
+
+  /* Verify parameters. */
+  assert((data != NULL) && (raw != NULL) && (size != NULL));
+
+  /* Only continue with valid parameters. */
+  if ((data != NULL) && (raw != NULL) && (size != NULL))
+  {
+    /* Initialize the settings as if the message will be CAN classic. */
+    frameLenMax = CAN_MAX_DLEN;
+    *size = CAN_MTU;
+    raw->flags = 0;
+    /* Should the message be transmitted as CAN FD? */
+    if ((fd_enabled) && (flags & CANCOMM_FLAG_CANFD_MSG))
+    {
+      /* Update the settings for the mesasge to be CAN FD. */
+      frameLenMax = CANFD_MAX_DLEN;
+      *size = CANFD_MTU;
+      /* Configure the bit rate switch when transmitting messages in CAN FD mode. */
+      raw->flags = CANFD_BRS;
+    }
+
+    /* Only construct the frame if all the data actually fits. */
+    if (len <= frameLenMax)
+    {
+      raw->can_id = (ext == CANCOMM_TRUE) ? (id | CAN_EFF_FLAG) : id;
+      /* Sanitize the frame length before storing it. */
+      raw->len = cancomm_inline_len_sanitize(len);
+      raw->__res0 = 0;
+      raw->__res1 = 0;
+      /* Clear the data field of the frame with a fixed size, which the compiler turns
+       * into a few word or vector stores, and copy the data bytes into it.
+       */
+      if (frameLenMax == CANFD_MAX_DLEN)
+      {
+        memset(raw->data, 0, CANFD_MAX_DLEN);
+      }
+      else
+      {
+        memset(raw->data, 0, CAN_MAX_DLEN);
+      }
+      cancomm_inline_data_copy(raw->data, data, len);
+      /* Frame successfully constructed. Update the result accordingly. */
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_inline_frame_pack ***/
+
+
+/************************************************************************************//**
+** \brief     Converts a frame, as received from the CAN raw socket, to the frame format
+**            of this library. The timestamp and interface index are not touched. The
+**            entire data field of the frame, CAN_MAX_DLEN or CANFD_MAX_DLEN bytes
+**            depending on the size, is read from the raw frame.
+** \param     raw Pointer to the frame as received from the socket.
+** \param     size Number of bytes that the socket returned for the frame.
+** \param     frame Pointer to where the converted frame is stored.
+** \return    CANCOMM_TRUE if the frame is a valid CAN message or CAN error frame.
+**            CANCOMM_FALSE for invalid frame sizes and remote frames.
+**
+****************************************************************************************/
+static inline uint8_t cancomm_inline_frame_unpack(struct canfd_frame const * raw,
+                                                  size_t size, cancomm_frame_t * frame)
+{
+  uint8_t result = CANCOMM_FALSE;
+
+  /* Verify parameters. */
+  assert((raw != NULL) && (frame != NULL));
+
+  /* Only continue with valid parameters. CAN FD or CAN classic frames are the only
+   * valid ones.
+   */
+  if ((raw != NULL) && (frame != NULL) && ((size == CANFD_MTU) || (size == CAN_MTU)))
+  {
+    /* Ignore remote frames. Pretty much no one actually uses these. */
+    if (!(raw->can_id & CAN_RTR_FLAG))
+    {
+      /* Reset the bit flags. */
+      frame->flags = 0;
+
+      /* Was it an error frame? */
+      if (raw->can_id & CAN_ERR_FLAG)
+      {
+        /* Store error frame info. */
+        frame->flags |= CANCOMM_FLAG_CANERR_MSG;
+        frame->id = 0;
+        frame->ext = CANCOMM_FALSE;
+        frame->len = 0;
+      }
+      /* It was a regular data frame. Either CAN FD or CAN classic. */
+      else
+      {
+        /* Copy the CAN data frame. */
+        frame->ext = (raw->can_id & CAN_EFF_FLAG) ? CANCOMM_TRUE : CANCOMM_FALSE;
+        frame->id = raw->can_id & ~CAN_EFF_FLAG;
+        frame->len = raw->len;
+        /* Copy the entire data field with a fixed size, instead of just the used data
+         * bytes. The compiler turns this into a few word or vector moves. The socket
+         * always provides the entire data field of the frame, as its size is either
+         * CAN_MTU or CANFD_MTU.
+         */
+        if (size == CANFD_MTU)
+        {
+          /* Flag the frame as a CAN FD frame for the caller. */
+          frame->flags |= CANCOMM_FLAG_CANFD_MSG;
+          memcpy(frame->data, raw->data, CANFD_MAX_DLEN);
+        }
+        else
+        {
+          memcpy(frame->data, raw->data, CAN_MAX_DLEN);
+        }
+      }
+
+      /* Frame successfully converted. Update the result accordingly. */
+      result = CANCOMM_TRUE;
+    }
+  }
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of cancomm_inline_frame_unpack ***/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CANCOMM_INLINE_H */
+/******************************** end of cancomm_inline.h *******************************/